@@ -0,0 +1,194 @@
+#ifndef DEADLINE_MONITOR_HPP
+#define DEADLINE_MONITOR_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <fstream>
+#include <iostream>
+
+#include "json.hpp"
+#include "Trace_Recorder.hpp"
+
+//Where an audio block's time goes. Backends with asynchronous queues only see host time, so device work shows up in
+//whichever phase waits on it - For OpenCL that is the blocking readback//
+enum BlockPhase { PHASE_EXCITER, PHASE_UPLOAD, PHASE_STEPS, PHASE_READBACK, PHASE_RESAMPLE, PHASE_OUTPUT, PHASE_VISUALIZATION, NUM_BLOCK_PHASES };
+
+static const char* blockPhaseNames[NUM_BLOCK_PHASES] = { "exciter", "upload", "steps", "readback", "resample", "output", "visualization" };
+
+//Times every audio block against its deadline (numSamples / sampleRate). Phases are accumulated in plain members by the
+//one thread running the block, then published as relaxed atomics in endBlock() so the message thread can read the
+//running totals at any time. A block over its deadline is counted as an overrun against the phase that took longest.
+class DeadlineMonitor
+{
+private:
+	//Audio thread only//
+	int64_t blockStart_ = 0;
+	int64_t deadline_ = 0;
+	int64_t phaseTime_[NUM_BLOCK_PHASES];
+
+	//Published//
+	std::atomic<uint64_t> blocks_;
+	std::atomic<uint64_t> overruns_;
+	std::atomic<uint64_t> loadSum_;		//Parts per million of the deadline, summed over blocks.
+	std::atomic<uint32_t> lastLoad_;
+	std::atomic<uint32_t> peakLoad_;
+	std::atomic<uint64_t> phaseTotal_[NUM_BLOCK_PHASES];	//Nanoseconds.
+	std::atomic<int64_t> phaseMax_[NUM_BLOCK_PHASES];
+	std::atomic<uint64_t> phaseOverruns_[NUM_BLOCK_PHASES];
+public:
+	static int64_t now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	//Times one phase for as long as it is in scope, and marks it on the calling thread's trace while one is recording.
+	//A null monitor with tracing off costs a flag check//
+	class ScopedPhase
+	{
+	private:
+		DeadlineMonitor* monitor_;
+		BlockPhase phase_;
+		int64_t start_;
+		ScopedTrace trace_;
+	public:
+		ScopedPhase(DeadlineMonitor* aMonitor, BlockPhase aPhase) :
+			monitor_(aMonitor),
+			phase_(aPhase),
+			start_(aMonitor != nullptr ? now() : 0),
+			trace_(blockPhaseNames[aPhase])
+		{
+		}
+		~ScopedPhase()
+		{
+			if (monitor_ != nullptr)
+				monitor_->addPhase(phase_, now() - start_);
+		}
+	};
+
+	DeadlineMonitor() :
+		blocks_(0),
+		overruns_(0),
+		loadSum_(0),
+		lastLoad_(0),
+		peakLoad_(0)
+	{
+		for (int i = 0; i != NUM_BLOCK_PHASES; ++i)
+		{
+			phaseTime_[i] = 0;
+			phaseTotal_[i].store(0, std::memory_order_relaxed);
+			phaseMax_[i].store(0, std::memory_order_relaxed);
+			phaseOverruns_[i].store(0, std::memory_order_relaxed);
+		}
+	}
+
+	void beginBlock(uint32_t aNumSamples, double aSampleRate)
+	{
+		blockStart_ = now();
+		deadline_ = (int64_t)(aNumSamples * 1e9 / aSampleRate);
+		for (int i = 0; i != NUM_BLOCK_PHASES; ++i)
+			phaseTime_[i] = 0;
+	}
+	void addPhase(BlockPhase aPhase, int64_t aNanoseconds)
+	{
+		phaseTime_[aPhase] += aNanoseconds;
+	}
+	void endBlock()
+	{
+		const int64_t elapsed = now() - blockStart_;
+		const uint32_t load = deadline_ > 0 ? (uint32_t)(elapsed * 1000000 / deadline_) : 0;
+
+		int slowest = 0;
+		for (int i = 0; i != NUM_BLOCK_PHASES; ++i)
+		{
+			phaseTotal_[i].fetch_add(phaseTime_[i], std::memory_order_relaxed);
+			if (phaseTime_[i] > phaseMax_[i].load(std::memory_order_relaxed))
+				phaseMax_[i].store(phaseTime_[i], std::memory_order_relaxed);
+			if (phaseTime_[i] > phaseTime_[slowest])
+				slowest = i;
+		}
+		if (elapsed > deadline_)
+		{
+			overruns_.fetch_add(1, std::memory_order_relaxed);
+			phaseOverruns_[slowest].fetch_add(1, std::memory_order_relaxed);
+		}
+
+		loadSum_.fetch_add(load, std::memory_order_relaxed);
+		lastLoad_.store(load, std::memory_order_relaxed);
+		if (load > peakLoad_.load(std::memory_order_relaxed))
+			peakLoad_.store(load, std::memory_order_relaxed);
+		blocks_.fetch_add(1, std::memory_order_release);
+	}
+
+	//Reader side//
+	uint64_t getBlocks() const
+	{
+		return blocks_.load(std::memory_order_acquire);
+	}
+	uint64_t getOverruns() const
+	{
+		return overruns_.load(std::memory_order_relaxed);
+	}
+	//Fractions of the deadline - 1.0 is a block that only just made it//
+	double getAverageLoad() const
+	{
+		const uint64_t blocks = getBlocks();
+		return blocks != 0 ? loadSum_.load(std::memory_order_relaxed) / (blocks * 1e6) : 0.0;
+	}
+	double getLastLoad() const
+	{
+		return lastLoad_.load(std::memory_order_relaxed) / 1e6;
+	}
+	double getPeakLoad() const
+	{
+		return peakLoad_.load(std::memory_order_relaxed) / 1e6;
+	}
+	//Phase blamed for the most overruns, or NUM_BLOCK_PHASES if there have been none//
+	BlockPhase getWorstPhase() const
+	{
+		BlockPhase worst = NUM_BLOCK_PHASES;
+		uint64_t most = 0;
+		for (int i = 0; i != NUM_BLOCK_PHASES; ++i)
+		{
+			const uint64_t overruns = phaseOverruns_[i].load(std::memory_order_relaxed);
+			if (overruns > most)
+			{
+				most = overruns;
+				worst = (BlockPhase)i;
+			}
+		}
+		return worst;
+	}
+
+	std::string toJson() const
+	{
+		const uint64_t blocks = getBlocks();
+		nlohmann::json stats;
+		stats["blocks"] = blocks;
+		stats["overruns"] = getOverruns();
+		stats["load"]["average"] = getAverageLoad();
+		stats["load"]["peak"] = getPeakLoad();
+		for (int i = 0; i != NUM_BLOCK_PHASES; ++i)
+		{
+			nlohmann::json& phase = stats["phases"][blockPhaseNames[i]];
+			phase["meanUs"] = blocks != 0 ? phaseTotal_[i].load(std::memory_order_relaxed) / (blocks * 1e3) : 0.0;
+			phase["maxUs"] = phaseMax_[i].load(std::memory_order_relaxed) / 1e3;
+			phase["overruns"] = phaseOverruns_[i].load(std::memory_order_relaxed);
+		}
+		return stats.dump(4);
+	}
+	bool writeJson(const std::string& aPath) const
+	{
+		std::ofstream file(aPath);
+		if (!file.is_open())
+		{
+			std::cout << "ERROR writing deadline stats to " << aPath << std::endl;
+			return false;
+		}
+		file << toJson() << std::endl;
+		return true;
+	}
+};
+
+#endif
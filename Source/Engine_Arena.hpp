@@ -0,0 +1,156 @@
+#ifndef ENGINE_ARENA_HPP
+#define ENGINE_ARENA_HPP
+
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <iostream>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+//One block of memory carved up by bumping a pointer. Reserved off the audio thread for everything a model or a device
+//configuration needs, zeroed up front so every page is faulted in, and released whole - Nothing in it is freed on its
+//own. Optionally backed by huge pages to cut TLB misses on the large grids, falling back to normal pages if the system
+//has none to give.
+class EngineArena
+{
+public:
+	static const size_t ALIGNMENT = 64;
+	static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+private:
+	char* base_ = nullptr;
+	size_t capacity_ = 0;
+	size_t used_ = 0;
+	size_t mapped_ = 0;		//Bytes actually mapped - Rounded up to the page size.
+	bool hugePages_ = false;
+
+	void release()
+	{
+		if (base_ == nullptr)
+			return;
+#if defined(__linux__)
+		munmap(base_, mapped_);
+#elif defined(_WIN32)
+		VirtualFree(base_, 0, MEM_RELEASE);
+#else
+		free(base_);
+#endif
+		base_ = nullptr;
+		capacity_ = used_ = mapped_ = 0;
+		hugePages_ = false;
+	}
+
+	bool map(size_t aBytes, bool aHugePages)
+	{
+#if defined(__linux__)
+		if (aHugePages)
+		{
+			//Explicit huge pages need a reserved pool (vm.nr_hugepages) - Otherwise ask for transparent ones//
+			mapped_ = (aBytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+			void* memory = mmap(nullptr, mapped_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			if (memory != MAP_FAILED)
+			{
+				base_ = (char*)memory;
+				hugePages_ = true;
+				return true;
+			}
+		}
+		mapped_ = aBytes;
+		void* memory = mmap(nullptr, mapped_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (memory == MAP_FAILED)
+			return false;
+		base_ = (char*)memory;
+		if (aHugePages)
+			madvise(base_, mapped_, MADV_HUGEPAGE);
+		return true;
+#elif defined(_WIN32)
+		if (aHugePages)
+		{
+			//Needs SeLockMemoryPrivilege - Without it the allocation fails and normal pages are used//
+			const SIZE_T largePage = GetLargePageMinimum();
+			if (largePage != 0)
+			{
+				mapped_ = (aBytes + largePage - 1) & ~(largePage - 1);
+				base_ = (char*)VirtualAlloc(nullptr, mapped_, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+				if (base_ != nullptr)
+				{
+					hugePages_ = true;
+					return true;
+				}
+			}
+		}
+		mapped_ = aBytes;
+		base_ = (char*)VirtualAlloc(nullptr, mapped_, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+		return base_ != nullptr;
+#else
+		mapped_ = (aBytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+		base_ = (char*)aligned_alloc(ALIGNMENT, mapped_);
+		return base_ != nullptr;
+#endif
+	}
+public:
+	EngineArena() {}
+	~EngineArena()
+	{
+		release();
+	}
+	EngineArena(const EngineArena&) = delete;
+	EngineArena& operator=(const EngineArena&) = delete;
+
+	//Bytes to reserve for aCount Ts - Sum these to size an arena before carving it//
+	template<class T>
+	static size_t footprint(size_t aCount)
+	{
+		return (aCount * sizeof(T) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+	}
+
+	//Cold path - Drops anything carved from a previous reservation//
+	bool reserve(size_t aBytes, bool aHugePages = false)
+	{
+		release();
+		if (aBytes == 0)
+			return true;
+		if (!map(aBytes, aHugePages))
+		{
+			std::cout << "ERROR reserving " << aBytes << " byte engine arena." << std::endl;
+			return false;
+		}
+		memset(base_, 0, mapped_);
+		capacity_ = aBytes;
+		return true;
+	}
+
+	//Zeroed, ALIGNMENT aligned - nullptr once the reservation is used up, which is a sizing bug//
+	template<class T>
+	T* allocate(size_t aCount)
+	{
+		const size_t bytes = footprint<T>(aCount);
+		if (base_ == nullptr || used_ + bytes > capacity_)
+		{
+			std::cout << "ERROR engine arena exhausted - " << bytes << " bytes requested, " << (capacity_ - used_) << " left." << std::endl;
+			return nullptr;
+		}
+		T* memory = (T*)(base_ + used_);
+		used_ += bytes;
+		return memory;
+	}
+
+	size_t getCapacity() const
+	{
+		return capacity_;
+	}
+	size_t getUsed() const
+	{
+		return used_;
+	}
+	bool usesHugePages() const
+	{
+		return hugePages_;
+	}
+};
+
+#endif
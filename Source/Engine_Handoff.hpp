@@ -0,0 +1,69 @@
+#ifndef ENGINE_HANDOFF_HPP
+#define ENGINE_HANDOFF_HPP
+
+#include <atomic>
+#include <thread>
+#include <stdint.h>
+
+//Hands an object built on the message thread to the audio thread without locks. The audio thread brackets its use with
+//a ReadScope, which bumps an epoch counter to odd on entry and back to even on exit. A writer publishes the new pointer
+//with one atomic exchange, then waits until the reader is outside its scope (or has moved on an epoch) before the old
+//object may be destroyed. The reader side is two atomic increments and one load - No locks, no allocation.
+template<typename T>
+class EngineHandoff
+{
+private:
+	std::atomic<T*> current_;
+	std::atomic<uint64_t> epoch_;
+public:
+	EngineHandoff() : current_(nullptr), epoch_(0) {}
+
+	class ReadScope
+	{
+	private:
+		EngineHandoff& handoff_;
+		T* object_;
+	public:
+		explicit ReadScope(EngineHandoff& aHandoff) : handoff_(aHandoff)
+		{
+			//Sequentially consistent so the epoch bump cannot be reordered after the pointer load//
+			handoff_.epoch_.fetch_add(1);
+			object_ = handoff_.current_.load();
+		}
+		~ReadScope()
+		{
+			handoff_.epoch_.fetch_add(1, std::memory_order_release);
+		}
+		T* get() const
+		{
+			return object_;
+		}
+		ReadScope(const ReadScope&) = delete;
+		ReadScope& operator=(const ReadScope&) = delete;
+	};
+
+	//Writer side - Publishes aObject and returns the previous one once the audio thread can no longer see it//
+	T* exchange(T* aObject)
+	{
+		T* previous = current_.exchange(aObject);
+		waitForReaders();
+		return previous;
+	}
+
+	void waitForReaders() const
+	{
+		const uint64_t epoch = epoch_.load();
+		if ((epoch & 1) == 0)
+			return;
+		while (epoch_.load(std::memory_order_acquire) == epoch)
+			std::this_thread::yield();
+	}
+
+	//Writer side peek - Never use the result on the audio thread outside of a ReadScope//
+	T* peek() const
+	{
+		return current_.load(std::memory_order_acquire);
+	}
+};
+
+#endif
@@ -0,0 +1,166 @@
+#ifndef EXCITER_VOICE_POOL_HPP
+#define EXCITER_VOICE_POOL_HPP
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "Wavetable_Exciter.h"
+#include "Spsc_Ring.hpp"
+#include "Input_Events.hpp"
+#include "Latency_Monitor.hpp"
+#include "FDTD_Backend.hpp"
+
+//A strike as sent from the input thread - Plain data so it can travel through the ring by copy//
+struct StrikeCommand
+{
+	int64_t time_;			//inputEventTime() at capture.
+	int position_;			//Flat grid index.
+	float amplitude_;
+	float frequency_;
+	int durationMs_;
+};
+
+//Fixed set of wavetable voices rendered into the packed multi-point excitation. The input thread only ever writes
+//StrikeCommands into a lock-free ring - Allocation and stealing happen on the audio thread at the top of each block, so
+//nothing is shared but the ring. Strikes are timestamped at capture and start at the matching sample rather than the
+//block's first, a later block's if the BlockClock puts them there, so fast rolls keep their spacing. Voice v always renders into row v, which keeps a voice's samples on one resampler
+//channel when the simulation runs at its own rate. Free voices are taken lowest first and a block only carries the rows up
+//to the last sounding voice, so the backend adds as few rows per step as the strikes allow.
+class ExciterVoicePool
+{
+private:
+	struct Voice
+	{
+		WavetableSynth synth;
+		float amplitude = 0.0f;
+		int position = 0;
+		uint32_t remaining = 0;		//Samples left in the burst - 0 is a free voice.
+		uint32_t delay = 0;		//Silent samples before the burst starts.
+		uint64_t started = 0;		//Strike order, for stealing the oldest voice.
+	};
+
+	Voice* voices_;
+	uint32_t numVoices_;
+	SpscRing<StrikeCommand> commands_;
+	BlockClock clock_;
+	LatencyMonitor* latencyMonitor_ = nullptr;
+	uint64_t strikes_ = 0;
+	double sampleRate_ = SAMPLE_RATE;
+
+	void allocate(const StrikeCommand& aStrike, uint32_t aDelay)
+	{
+		//A free voice if there is one, otherwise steal the oldest strike//
+		Voice* voice = &voices_[0];
+		for (uint32_t v = 0; v != numVoices_; ++v)
+		{
+			if (voices_[v].remaining == 0)
+			{
+				voice = &voices_[v];
+				break;
+			}
+			if (voices_[v].started < voice->started)
+				voice = &voices_[v];
+		}
+
+		voice->synth.setCurrentIndex(0.0);
+		voice->synth.setFrequency(aStrike.frequency_, (float)sampleRate_);
+		voice->amplitude = aStrike.amplitude_;
+		voice->position = aStrike.position_;
+		voice->remaining = (uint32_t)(aStrike.durationMs_ * (sampleRate_ / 1000.0)) + 1;
+		voice->delay = aDelay;
+
+		if (latencyMonitor_ != nullptr)
+			latencyMonitor_->onsetApplied(aStrike.time_, aDelay);
+		voice->started = ++strikes_;
+	}
+public:
+	ExciterVoicePool(uint32_t aNumVoices, const float* aWavetable, const size_t aWavetableSize, uint32_t aQueueSize = 64) :
+		voices_(new Voice[aNumVoices]),
+		numVoices_(aNumVoices),
+		commands_(aQueueSize)
+	{
+		for (uint32_t v = 0; v != numVoices_; ++v)
+			voices_[v].synth.setWavetable(aWavetable, (int)aWavetableSize);
+	}
+	~ExciterVoicePool()
+	{
+		delete[] voices_;
+	}
+
+	uint32_t getNumVoices() const
+	{
+		return numVoices_;
+	}
+
+	//Called before the audio device starts - Voice durations and pitch follow the device rate//
+	void setSampleRate(double aSampleRate)
+	{
+		sampleRate_ = aSampleRate;
+	}
+
+	//Optional - Strikes are timed from capture to the block they start in. Set before audio starts//
+	void setLatencyMonitor(LatencyMonitor* aMonitor)
+	{
+		latencyMonitor_ = aMonitor;
+	}
+
+	//Input thread - Never blocks. aTime is when the touch was read, defaulting to now. Returns false if the queue is full
+	//and the strike was dropped//
+	bool strike(int aPosition, float aAmplitude, int aDurationMs, float aFrequency = 1440.0f, int64_t aTime = 0)
+	{
+		StrikeCommand command = { aTime != 0 ? aTime : inputEventTime(), aPosition, aAmplitude, aFrequency, aDurationMs };
+		return commands_.write(&command, 1) == 1;
+	}
+
+	//Rendering thread - Starts a strike at the top of the block about to be rendered. For control sources with their own
+	//queue, drained on the rendering thread, so the input ring keeps its single producer//
+	void strikeNow(int aPosition, float aAmplitude, int aDurationMs, float aFrequency, int64_t aTime)
+	{
+		StrikeCommand command = { aTime, aPosition, aAmplitude, aFrequency, aDurationMs };
+		allocate(command, 0);
+	}
+
+	//Audio thread - Takes new strikes, then renders each voice into its own row of aBlock up to the last one sounding and
+	//lowers points_ to match. Returns the active span//
+	uint32_t renderBlock(ExcitationBlock& aBlock, uint32_t aNumSamples)
+	{
+		clock_.beginBlock(sampleRate_, aNumSamples, aBlock.queued_);
+		StrikeCommand command;
+		while (commands_.read(&command, 1) == 1)
+			allocate(command, clock_.delayOf(command.time_));
+
+		const uint32_t limit = numVoices_ < aBlock.points_ ? numVoices_ : aBlock.points_;
+		uint32_t rows = 0;
+		for (uint32_t v = 0; v != limit; ++v)
+			if (voices_[v].remaining != 0)
+				rows = v + 1;
+		uint32_t span = 0;
+		for (uint32_t v = 0; v != rows; ++v)
+		{
+			Voice& voice = voices_[v];
+			float* row = aBlock.samples_ + v * aBlock.stride_;
+			const uint32_t delay = voice.delay < aNumSamples ? voice.delay : aNumSamples;
+			const uint32_t available = aNumSamples - delay;
+			const uint32_t active = voice.remaining < available ? voice.remaining : available;
+
+			memset(row, 0, delay * sizeof(float));
+			float* burst = row + delay;
+			voice.synth.renderBlock(burst, active);
+			const float amplitude = voice.amplitude;
+			for (uint32_t i = 0; i != active; ++i)
+				burst[i] *= amplitude;
+			memset(burst + active, 0, (available - active) * sizeof(float));
+
+			voice.delay -= delay;
+			voice.remaining -= active;
+			aBlock.positions_[v] = voice.position;
+			if (active != 0 && delay + active > span)
+				span = delay + active;
+		}
+		aBlock.points_ = rows;
+		return span;
+	}
+};
+
+#endif
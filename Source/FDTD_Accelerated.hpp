@@ -1,432 +1,638 @@
-#ifndef FDTD_ACCELERATED_HPP
-#define FDTD_ACCELERATED_HPP
-
-#include <utility>
-#include <stdint.h>
-#include <iostream>
-#include <fstream>
-
-//#define CL_HPP_TARGET_OPENCL_VERSION 210
-//#define CL_HPP_MINIMUM_OPENCL_VERSION 200
-#define CL_HPP_TARGET_OPENCL_VERSION 120
-#define CL_HPP_MINIMUM_OPENCL_VERSION 120
-#include <CL/cl2.hpp>
-//#include <CL/cl.hpp>
-#include <CL/cl_gl.h>
-
-//Parsing parameters as json file//
-#include "json.hpp"
-using nlohmann::json;
-
-#include "FDTD_Grid.hpp"
-#include "Buffer.hpp"
-
-#include "Visualizer.hpp"
-
-enum DeviceType { INTEGRATED = 32902, DISCRETE = 4098, NVIDIA = 4318 };
-enum Implementation { OPENCL, CUDA, VULKAN, DIRECT3D };
-
-#include <string>
-
-class FDTD_Accelerated
-{
-private:
-	Implementation implementation_;
-	uint32_t sampleRate_;
-	DeviceType deviceType_;
-
-	//CL//
-	cl_int errorStatus_ = 0;
-	cl_uint num_platforms, num_devices;
-	cl::Platform platform_;
-	cl::Context context_;
-	cl::Device device_;
-	cl::CommandQueue commandQueue_;
-	cl::Program kernelProgram_;
-	std::string kernelSourcePath_;
-	cl::Kernel kernel_;
-	cl::NDRange globalws_;
-	cl::NDRange localws_;
-
-	//CL Buffers//
-	cl::Buffer idGrid_;
-	cl::Buffer modelGrid_;
-	cl::Buffer boundaryGridBuffer_;
-	cl::Buffer outputBuffer_;
-	cl::Buffer excitationBuffer_;
-	cl::Buffer localBuffer_;
-	cl::Buffer outputPositionBuffer_;
-
-	//Model//
-	int listenerPosition_[2];
-	int excitationPosition_[2];
-	Model* model_;
-	int modelWidth_;
-	int modelHeight_;
-	int gridElements_;
-	int gridByteSize_;
-
-	//Output and excitations//
-	typedef float base_type_;
-	unsigned int bufferSize_;
-	Buffer<base_type_> output_;
-	Buffer<base_type_> excitation_;
-
-	int bufferRotationIndex_ = 1;
-
-	Visualizer* vis;
-
-	float* renderGrid;
-	int* idGridInput_;
-	int* outputGridInput_;
-	float* boundaryGridInput_;
-	float emptyBuffer_[44100];
-
-	void initOpenCL()
-	{
-		std::vector <cl::Platform> platforms;
-		cl::Platform::get(&platforms);
-		for (cl::vector<cl::Platform>::iterator it = platforms.begin(); it != platforms.end(); ++it)
-		{
-			cl::Platform platform(*it);
-
-			cl_context_properties contextProperties[3] = { CL_CONTEXT_PLATFORM, (cl_context_properties)(platform)(), 0 };
-			context_ = cl::Context(CL_DEVICE_TYPE_GPU, contextProperties);
-
-			cl::vector<cl::Device> devices = context_.getInfo<CL_CONTEXT_DEVICES>();
-
-			int device_id = 0;
-			for (cl::vector<cl::Device>::iterator it2 = devices.begin(); it2 != devices.end(); ++it2)
-			{
-				cl::Device device(*it2);
-				auto d = device.getInfo<CL_DEVICE_VENDOR_ID>();
-				if (d == DeviceType::NVIDIA || d == DeviceType::DISCRETE)	//Hard coded to pick AMD or NVIDIA.
-				{
-					//Create command queue for first device - Profiling enabled//
-					commandQueue_ = cl::CommandQueue(context_, device, CL_QUEUE_PROFILING_ENABLE, &errorStatus_);	//Need to specify device 1[0] of platform 3[2] for dedicated graphics - Harri Laptop.
-					if (errorStatus_)
-						std::cout << "ERROR creating command queue for device. Status code: " << errorStatus_ << std::endl;
-
-					std::cout << "\t\tDevice Name Chosen: " << device.getInfo<CL_DEVICE_NAME>() << std::endl;
-
-					return;
-				}
-			}
-			std::cout << std::endl;
-		}
-	}
-	void initBuffersCL()
-	{
-		//Create input and output buffer for grid points//
-		idGrid_ = cl::Buffer(context_, CL_MEM_READ_WRITE, gridByteSize_);
-		modelGrid_ = cl::Buffer(context_, CL_MEM_READ_WRITE, gridByteSize_ * 3);
-		boundaryGridBuffer_ = cl::Buffer(context_, CL_MEM_READ_WRITE, gridByteSize_);
-		outputBuffer_ = cl::Buffer(context_, CL_MEM_READ_WRITE, output_.bufferSize_ * sizeof(float));
-		excitationBuffer_ = cl::Buffer(context_, CL_MEM_READ_WRITE, excitation_.bufferSize_ * sizeof(float));
-		outputPositionBuffer_ = cl::Buffer(context_, CL_MEM_READ_WRITE, gridByteSize_);
-
-		//Copy data to newly created device's memory//
-		float* temporaryGrid =  new float[gridElements_ * 3];
-		memset(temporaryGrid, 0, gridByteSize_ * 3);
-
-		commandQueue_.enqueueWriteBuffer(idGrid_, CL_TRUE, 0, gridByteSize_ , idGridInput_);
-		commandQueue_.enqueueWriteBuffer(modelGrid_, CL_TRUE, 0, gridByteSize_*3, temporaryGrid);
-		commandQueue_.enqueueWriteBuffer(boundaryGridBuffer_, CL_TRUE, 0, gridByteSize_, boundaryGridInput_);
-		commandQueue_.enqueueWriteBuffer(outputPositionBuffer_, CL_TRUE, 0, gridByteSize_, outputGridInput_);
-	}
-	void step()
-	{
-		commandQueue_.enqueueNDRangeKernel(kernel_, cl::NullRange/*globaloffset*/, globalws_, localws_, NULL);
-		commandQueue_.enqueueNDRangeKernel(kernel_, cl::NullRange/*globaloffset*/, 2, localws_, NULL);
-		//commandQueue_.finish();
-
-		output_.bufferIndex_++;
-		excitation_.bufferIndex_++;
-		bufferRotationIndex_ = (bufferRotationIndex_ + 1) % 3;
-	}
-protected:
-public:
-	FDTD_Accelerated(Implementation aImplementation, uint32_t aSampleRate, float aGridSpacing) : 
-		implementation_(aImplementation),
-		sampleRate_(aSampleRate),
-		modelWidth_(128),
-		modelHeight_(128),
-		//model_(64, 64, 0.5),
-		bufferSize_(aSampleRate),	//@ToDo - Make these controllable.
-		output_(bufferSize_),
-		excitation_(bufferSize_)
-	{
-		listenerPosition_[0] = 16;
-		listenerPosition_[1] = 16;
-		excitationPosition_[0] = 32;
-		excitationPosition_[1] = 32;
-
-		memset(emptyBuffer_, 0, 44100 * sizeof(float));
-	}
-
-	~FDTD_Accelerated()
-	{
-		delete vis;
-	}
-
-	void buildProgram()
-	{
-		//Build program//
-		kernelProgram_.build();
-
-		kernel_ = cl::Kernel(kernelProgram_, "compute", &errorStatus_);	//@ToDo - Hard coded the kernel name. Find way to generate this?
-	}
-
-	void fillBuffer(float* input, float* output, uint32_t numSteps)
-	{
-		//Load excitation samples into GPU//
-		commandQueue_.enqueueWriteBuffer(excitationBuffer_, CL_TRUE, 0, numSteps * sizeof(float), input);
-		kernel_.setArg(5, sizeof(cl_mem), &excitationBuffer_);
-
-		//Calculate buffer size of synthesizer output samples//
-		for (unsigned int i = 0; i != numSteps; ++i)
-		{
-			input[i] = 0.0;
-			//Increments kernel indices//
-			kernel_.setArg(4, sizeof(int), &output_.bufferIndex_);
-			kernel_.setArg(3, sizeof(int), &bufferRotationIndex_);
-
-			step();
-		}
-
-		output_.resetIndex();
-		excitation_.resetIndex();
-
-		commandQueue_.enqueueReadBuffer(outputBuffer_, CL_TRUE, 0, numSteps * sizeof(float), output);
-		commandQueue_.enqueueWriteBuffer(outputBuffer_, CL_TRUE, 0, numSteps * sizeof(float), emptyBuffer_);
-	}
-	void renderSimulation()
-	{
-		commandQueue_.enqueueReadBuffer(modelGrid_, CL_TRUE, 0, gridByteSize_, renderGrid);
-		render(renderGrid, boundaryGridInput_);
-	}
-
-
-	void createModel(const std::string aPath, float aBoundaryValue, uint32_t aInputPosition[2], uint32_t aOutputPosition[2])
-	{
-		// JOSN parsing.
-		//Read json file into program object//
-		std::ifstream ifs(aPath);
-		json jsonFile = json::parse(ifs);
-		//std::cout << j << std::endl;
-
-		 modelWidth_ = jsonFile["buffer"].size();
-		 modelHeight_= jsonFile["buffer"][0].size();
-
-		 outputGridInput_ = new int[modelWidth_*modelHeight_];
-		 boundaryGridInput_ = new float[modelWidth_*modelHeight_];
-		 idGridInput_ = new int[modelWidth_*modelHeight_];
-		for (int i = 0; i != modelWidth_; ++i)
-		{
-			for (int j = 0; j != modelHeight_; ++j)
-			{
-				idGridInput_[i*modelWidth_ + j] = jsonFile["buffer"][i][j];
-				outputGridInput_[i*modelWidth_ + j] = 0;
-			}
-		}
-
-		globalws_ = cl::NDRange(modelWidth_, modelHeight_);
-		localws_ = cl::NDRange(32, 32);						//@ToDo - CHANGE TO OPTIMIZED GROUP SIZE.
-
-		//deviceType_ = INTEGRATED;
-		deviceType_ = NVIDIA;
-
-		initOpenCL();
-		initRender();
-
-		model_ = new Model(modelWidth_, modelHeight_, aBoundaryValue);
-		model_->setInputPosition(aInputPosition[0], aInputPosition[1]);
-
-		//@TODO - Temporary post-processing boundary calculation. Remove when added in SVG parser.
-		int boundaryCount = 0;
-		for (int i = 1; i != (modelWidth_- 1); ++i)
-		{
-			for (int j = 1; j != (modelHeight_ - 1); ++j)
-			{
-				if (idGridInput_[i*modelWidth_ + j] == 2)
-				{
-					//std::cout << j << ", " << i << "\n";
-				}
-				//@ToDo - Work out calcualting boundary grid correctly.
-				//This way trying to manually treat string differently from others.
-				//if (idGridInput_[i*modelWidth_ + j] == 3)
-				//{
-				//	int gridID = idGridInput_[i*modelWidth_ + j];
-
-				//	boundaryCount = 0;
-				//	if (idGridInput_[(i - 1)*modelWidth_ + j] == gridID)
-				//		++boundaryCount;
-				//	if (idGridInput_[(i + 1)*modelWidth_ + j] == gridID)
-				//		++boundaryCount;
-				//	if (idGridInput_[(i - 1)*modelWidth_ + j + 1] == gridID)
-				//		++boundaryCount;
-				//	if (idGridInput_[(i - 1)*modelWidth_ + j - 1] == gridID)
-				//		++boundaryCount;
-				//	if (idGridInput_[(i + 1)*modelWidth_ + j + 1] == gridID)
-				//		++boundaryCount;
-				//	if (idGridInput_[(i + 1)*modelWidth_ + j - 1] == gridID)
-				//		++boundaryCount;
-				//	if (idGridInput_[(i)*modelWidth_ + j - 1] == gridID)
-				//		++boundaryCount;
-				//	if (idGridInput_[(i)*modelWidth_ + j + 1] == gridID)
-				//		++boundaryCount;
-
-				//	if (boundaryCount == 1)
-				//		boundaryGridInput_[i*modelWidth_ + j] = 1.0;
-				//}
-				//else
-				//{
-				//	if (idGridInput_[i*modelWidth_ + j] > 0 && (idGridInput_[(i-1)*modelWidth_ + j] == 0 || idGridInput_[(i+1)*modelWidth_ + j] == 0 || idGridInput_[i*modelWidth_ + j-1] == 0 || idGridInput_[i*modelWidth_ + j+1] == 0))
-				//	//if (idGridInput_[i][j] > 0 && (idGridInput_[i-1][j] == 0 || idGridInput_[i+1][j] == 0 || idGridInput_[i][j-1] == 0 || idGridInput_[i][j+1] == 0))
-				//	{
-				//		boundaryGridInput_[i*modelWidth_ + j] = 1.0;
-				//	}
-				//}
-				/*if (idGridInput_[i*modelWidth_ + j] > 0)
-				{
-					boundaryCount = 0;
-					if (idGridInput_[(i - 1)*modelWidth_ + j] == 0)
-						++boundaryCount;
-					if (idGridInput_[(i + 1)*modelWidth_ + j] == 0)
-						++boundaryCount;
-					if (idGridInput_[(i - 1)*modelWidth_ + j+1] == 0)
-						++boundaryCount;
-					if (idGridInput_[(i - 1)*modelWidth_ + j-1] == 0)
-						++boundaryCount;
-					if (idGridInput_[(i + 1)*modelWidth_ + j+1] == 0)
-						++boundaryCount;
-					if (idGridInput_[(i + 1)*modelWidth_ + j-1] == 0)
-						++boundaryCount;
-					if (idGridInput_[(i)*modelWidth_ + j-1] == 0)
-						++boundaryCount;
-					if (idGridInput_[(i)*modelWidth_ + j + 1] == 0)
-						++boundaryCount;
-					if(boundaryCount > 1 && boundaryCount < 5)
-						boundaryGridInput_[i*modelWidth_ + j] = 1.0;
-				}*/
-
-				if (idGridInput_[i*modelWidth_ + j] > 0 && (idGridInput_[(i-1)*modelWidth_ + j] == 0 || idGridInput_[(i+1)*modelWidth_ + j] == 0 || idGridInput_[i*modelWidth_ + j-1] == 0 || idGridInput_[i*modelWidth_ + j+1] == 0))
-				//if (idGridInput_[i][j] > 0 && (idGridInput_[i-1][j] == 0 || idGridInput_[i+1][j] == 0 || idGridInput_[i][j-1] == 0 || idGridInput_[i][j+1] == 0))
-				{
-					boundaryGridInput_[i*modelWidth_ + j] = aBoundaryValue;
-				}
-				//std::cout << model_->boundaryGrid_.valueAt(i, j) << " | ";
-			}
-			//std::cout << std::endl;
-		}
-
-		gridElements_ = (modelWidth_ * modelHeight_);
-		gridByteSize_ = (gridElements_ * sizeof(float));
-		renderGrid = new float[gridElements_ * 3];
-
-		if (implementation_ == Implementation::OPENCL)
-		{
-			initBuffersCL();
-		}
-
-		createExplicitEquation(aPath);
-	}
-
-	void createExplicitEquation(const std::string aPath)
-	{
-		//Read json file into program object//
-		std::ifstream ifs(aPath);
-		json jsonFile = json::parse(ifs);
-		std::string sourceFile = jsonFile["controllers"][0]["physics_kernel"];
-
-		//Create program source object from std::string source code//
-		std::vector<std::string> programSources;
-		programSources.push_back(sourceFile);
-		cl::Program::Sources source(programSources);	//Apparently this takes a vector of strings as the program source.
-
-		//Create program from source code//
-		kernelProgram_ = cl::Program(context_, source, &errorStatus_);
-		if (errorStatus_)
-			std::cout << "ERROR creating OpenCL program from source. Status code: " << errorStatus_ << std::endl;
-		
-		//Build program//
-		char options[1024];
-		snprintf(options, sizeof(options),
-			" -cl-fast-relaxed-math"
-			" -cl-single-precision-constant"
-			//""
-		);
-		kernelProgram_.build(options);	//@Highlight - Keep this in?
-
-		kernel_ = cl::Kernel(kernelProgram_, "fdtdKernel", &errorStatus_);	//@ToDo - Hard coded the kernel name. Find way to generate this?
-		if (errorStatus_)
-			std::cout << "ERROR building OpenCL kernel from source. Status code: " << errorStatus_ << std::endl;
-
-		kernel_.setArg(0, sizeof(cl_mem), &idGrid_);
-		kernel_.setArg(1, sizeof(cl_mem), &modelGrid_);
-		kernel_.setArg(2, sizeof(cl_mem), &boundaryGridBuffer_);
-		kernel_.setArg(6, sizeof(cl_mem), &outputBuffer_);
-
-		int inPos = model_->getInputPosition();
-		int outPos = model_->getOutputPosition();
-		kernel_.setArg(7, sizeof(int), &inPos);
-		kernel_.setArg(8, sizeof(cl_mem), &outputPositionBuffer_);
-	}
-	void createMatrixEquation(const std::string aPath);	//How is the matrix equations defined? Is there just a default matrix equation that can be formed for many equations or need be defined?
-
-	//@ToDo - Do we need this? Coefficients just need to use .setArg(), don't need to create buffer for them...
-	void createCoefficient(std::string aCoeff)
-	{
-
-	}
-	void updateCoefficient(std::string aCoeff, uint32_t aIndex, float aValue)
-	{
-		kernel_.setArg(aIndex, sizeof(float), &aValue);	//@ToDo - Need dynamicaly find index for setArg (The first param)
-	}
-
-	void setInputPosition(int aInputs[])
-	{
-		model_->setInputPosition(aInputs[0], aInputs[1]);
-		int inPos = model_->getInputPosition();
-		kernel_.setArg(7, sizeof(int), &inPos);
-	}
-	void setOutputPosition(int aOutputs[])
-	{
-		model_->setOutputPosition(aOutputs[0], aOutputs[1]);
-		int flatPosition = model_->getOutputPosition();
-		outputGridInput_[flatPosition] = 1;
-		commandQueue_.enqueueWriteBuffer(outputPositionBuffer_, CL_TRUE, 0, gridByteSize_, outputGridInput_);
-		kernel_.setArg(8, sizeof(cl_mem), &outputPositionBuffer_);
-	}
-	void setInputPositions(std::vector<uint32_t> aInputs);
-	void setOutputPositions(std::vector<uint32_t> aOutputs);
-
-	void setInputs(std::vector<std::vector<float>> aInputs);
-
-	std::vector<std::vector<float>> getInputs();
-	std::vector<std::vector<float>> getOutputs();
-
-	void initRender()
-	{
-		vis = new Visualizer(modelWidth_, modelHeight_);
-	}
-	void render(float* aData, float* aBoundary)
-	{
-		vis->render(aData, aBoundary);
-	}
-	GLFWwindow* getWindow()
-	{
-		return vis->getWindow();
-	}
-
-	int getModelWidth()
-	{
-		return modelWidth_;
-	}
-	int getModelHeight()
-	{
-		return modelHeight_;
-	}
-};
-
+#ifndef FDTD_ACCELERATED_HPP
+#define FDTD_ACCELERATED_HPP
+
+#include <utility>
+#include <algorithm>
+#include <stdint.h>
+#include <iostream>
+#include <fstream>
+
+#include "FDTD_Grid.hpp"
+#include "FDTD_Backend.hpp"
+#include "FDTD_Backend_OpenCL.hpp"
+#include "FDTD_Backend_CPU.hpp"
+#ifdef FDTD_USE_VULKAN
+#include "FDTD_Backend_Vulkan.hpp"
+#endif
+#include "Model_Loader.hpp"
+#include "Model_Cache.hpp"
+#include "Model_Preprocess.hpp"
+#include "Model_Geometry.hpp"
+
+#include "Triple_Buffer.hpp"
+#include "Engine_Handoff.hpp"
+#include "Realtime_Check.hpp"
+#include "Spsc_Ring.hpp"
+#include "Input_Events.hpp"
+
+#include <string>
+
+//Selects the backend for an implementation once, binding the per-block call to the concrete type//
+static FDTD_Backend* createBackend(Implementation aImplementation, FDTD_Backend::ProcessBlockFn& aProcessBlock)
+{
+	switch (aImplementation)
+	{
+	case Implementation::OPENCL:
+		aProcessBlock = &FDTD_Backend::processBlockThunk<FDTD_Backend_OpenCL>;
+		return new FDTD_Backend_OpenCL();
+#ifdef FDTD_USE_VULKAN
+	case Implementation::VULKAN:
+		aProcessBlock = &FDTD_Backend::processBlockThunk<FDTD_Backend_Vulkan>;
+		return new FDTD_Backend_Vulkan();
+#endif
+	case Implementation::CPU:
+		aProcessBlock = &FDTD_Backend::processBlockThunk<FDTD_Backend_CPU>;
+		return new FDTD_Backend_CPU();
+	default:
+		std::cout << "Implementation not available, falling back to CPU backend." << std::endl;
+		aProcessBlock = &FDTD_Backend::processBlockThunk<FDTD_Backend_CPU>;
+		return new FDTD_Backend_CPU();
+	}
+}
+
+class FDTD_Accelerated
+{
+private:
+	Implementation implementation_;
+	double sampleRate_;
+
+	//Backend//
+	FDTD_Backend* backend_;
+	FDTD_Backend::ProcessBlockFn processBlock_;
+
+	//Model//
+	int listenerPosition_[2];
+	int excitationPosition_[2];
+	Model* model_ = nullptr;
+	ModelData modelData_;
+	float boundaryValue_ = 0.0f;
+	ModelCache modelCache_;
+	std::vector<int> pickups_;		//Flat output positions in the order setOutputPosition() added them.
+	int modelWidth_;
+	int modelHeight_;
+	int gridElements_;
+
+	unsigned int bufferSize_;
+	double simulationRate_ = 0.0;		//0 - Step once per device sample.
+	uint32_t maxExcitationPoints_ = 1;
+	std::atomic<int> inputPosition_;	//Strike point for single channel fillBuffer() calls.
+
+	//Model sized host memory (snapshot slots) in one reservation, remade by createModel()//
+	EngineArena modelArena_;
+	bool hugePages_ = false;
+
+	//Block sized resources - Rebuilt by prepare() and swapped in without the audio thread waiting//
+	EngineHandoff<BlockResources> blockResources_;
+
+	//Optional per block phase timing - Only for the thread whose blocks it is timing//
+	DeadlineMonitor* deadlineMonitor_ = nullptr;
+
+	//Coefficient changes from the message thread, applied on the audio thread at their captured sample//
+	SpscRing<ParameterEvent> parameterEvents_;
+	BlockClock parameterClock_;
+	ParameterEvent heldEvent_ = {};		//Read but timed past the chunk it was read in.
+	bool eventHeld_ = false;
+
+	//Field snapshots for the render thread - With RGBA8 pixels once setDisplaySize() is given a size//
+	TripleBuffer<FieldSnapshot> snapshots_;
+	DisplayFormat display_;
+
+	//Snapshot slots in the backend's own memory where it has some, otherwise carved from a fresh modelArena_ reservation,
+	//and the backend told of the display//
+	void allocateSnapshots()
+	{
+		display_.fieldWidth_ = modelWidth_;
+		display_.fieldHeight_ = modelHeight_;
+		const size_t pixelBytes = display_.isEnabled() ? EngineArena::footprint<unsigned char>(display_.bytes()) : 0;
+		float* fields[3];
+		size_t fieldBytes = 0;
+		for (int i = 0; i != 3; ++i)
+		{
+			fields[i] = backend_->getSnapshotField(i);
+			fieldBytes += fields[i] == nullptr ? EngineArena::footprint<float>(gridElements_) : 0;
+		}
+		modelArena_.reserve(fieldBytes + 3 * pixelBytes, hugePages_);
+		for (int i = 0; i != 3; ++i)
+		{
+			FieldSnapshot& slot = snapshots_.slot(i);
+			slot.field_ = fields[i] != nullptr ? fields[i] : modelArena_.allocate<float>(gridElements_);
+			slot.pixels_ = display_.isEnabled() ? modelArena_.allocate<unsigned char>(display_.bytes()) : nullptr;
+			slot.pixelWidth_ = display_.width_;
+			slot.pixelHeight_ = display_.height_;
+		}
+		backend_->setDisplayFormat(display_);
+	}
+
+	//modelData_ is loaded - Sizes everything by it and uploads it to the backend//
+	void installModel(float aBoundaryValue, uint32_t aInputPosition[2])
+	{
+		modelWidth_ = modelData_.width_;
+		modelHeight_ = modelData_.height_;
+		gridElements_ = (modelWidth_ * modelHeight_);
+		boundaryValue_ = aBoundaryValue;
+
+		//Room for shape edits to add tiles and materials without allocating on the rendering thread//
+		modelData_.activeTiles_.reserve(((modelWidth_ + MODEL_TILE_SIZE - 1) / MODEL_TILE_SIZE) * ((modelHeight_ + MODEL_TILE_SIZE - 1) / MODEL_TILE_SIZE));
+		modelData_.materials_.reserve(modelData_.materials_.size() + 16);
+
+		model_ = new Model(modelWidth_, modelHeight_, aBoundaryValue);
+		model_->setInputPosition(aInputPosition[0], aInputPosition[1]);
+
+		inputPosition_.store(model_->getInputPosition());
+
+		backend_->uploadModel(modelData_);
+		allocateSnapshots();
+	}
+
+protected:
+public:
+	FDTD_Accelerated(Implementation aImplementation, uint32_t aSampleRate, float aGridSpacing) : 
+		implementation_(aImplementation),
+		sampleRate_(44100.0),	//Until prepare() is given the device rate.
+		modelWidth_(128),
+		modelHeight_(128),
+		//model_(64, 64, 0.5),
+		bufferSize_(aSampleRate),	//@ToDo - Make these controllable.
+		inputPosition_(0),
+		parameterEvents_(256)
+	{
+		listenerPosition_[0] = 16;
+		listenerPosition_[1] = 16;
+		excitationPosition_[0] = 32;
+		excitationPosition_[1] = 32;
+
+		backend_ = createBackend(implementation_, processBlock_);
+	}
+
+	~FDTD_Accelerated()
+	{
+		delete blockResources_.exchange(nullptr);
+		delete model_;
+		delete backend_;
+	}
+
+	//Sizes everything per block for the device's negotiated block size and rate. Called off the audio thread whenever the
+	//device (re)starts - The old resources are destroyed only once the audio thread has let go of them.
+	void prepare(uint32_t aMaxBlockSize, double aSampleRate)
+	{
+		realtimeAssertNonBlocking("prepare called from a real-time thread.");
+		if (aMaxBlockSize == 0)
+			aMaxBlockSize = 1;
+
+		//Device sized blocks are converted to a varying number of steps at the simulation rate//
+		SimulationRateConverter* rateConverter = nullptr;
+		uint32_t maxSteps = aMaxBlockSize;
+		if (simulationRate_ > 0.0 && (uint32_t)simulationRate_ != (uint32_t)aSampleRate)
+		{
+			rateConverter = new SimulationRateConverter((uint32_t)aSampleRate, (uint32_t)simulationRate_, aMaxBlockSize, maxExcitationPoints_);
+			maxSteps = rateConverter->getMaxSteps();
+		}
+
+		BlockResources* resources = backend_->createBlockResources(maxSteps, maxExcitationPoints_);
+		resources->maxBlockSize_ = aMaxBlockSize;
+		resources->maxExcitationPoints_ = maxExcitationPoints_;
+		resources->sampleRate_ = aSampleRate;
+
+		//Backends with host visible excitation rows hand them out so renderers write straight into device staging. Rows
+		//rendered at the device rate ahead of a rate converter still need their own//
+		const bool hostRows = resources->excitation_ == nullptr || rateConverter != nullptr;
+		const size_t rows = hostRows ? (size_t)aMaxBlockSize * maxExcitationPoints_ : 0;
+		resources->arena_.reserve(EngineArena::footprint<float>(rows) + EngineArena::footprint<int>(maxExcitationPoints_), hugePages_);
+		if (hostRows)
+			resources->excitation_ = resources->arena_.allocate<float>(rows);
+		resources->excitationPositions_ = resources->arena_.allocate<int>(maxExcitationPoints_);
+		std::fill(resources->excitationPositions_, resources->excitationPositions_ + maxExcitationPoints_, inputPosition_.load());
+		resources->rateConverter_ = rateConverter;
+
+		bufferSize_ = aMaxBlockSize;
+		sampleRate_ = aSampleRate;
+		delete blockResources_.exchange(resources);
+	}
+
+	//Times the phases of every block rendered from here on. Set before the rendering thread starts//
+	void setDeadlineMonitor(DeadlineMonitor* aMonitor)
+	{
+		deadlineMonitor_ = aMonitor;
+		backend_->setDeadlineMonitor(aMonitor);
+	}
+
+	//Backs the model and block arenas with huge pages where the system allows - Takes effect from the next createModel()
+	//or prepare()//
+	void setHugePages(bool aHugePages)
+	{
+		hugePages_ = aHugePages;
+	}
+
+	//Keeps loaded models and their compiled programs in aDirectory, so reloading an unchanged model on the same device
+	//skips parsing, boundary detection and compilation - Empty disables it. Takes effect from the next createModel()//
+	void setModelCache(const std::string& aDirectory, uint64_t aMaxBytes = ModelCache::DEFAULT_MAX_BYTES)
+	{
+		modelCache_.setDirectory(aDirectory, aMaxBytes);
+	}
+
+	//Runs the simulation at its own rate and uses polyphase resampling to and from the device. The device rate is then
+	//only a transport detail - The step cost per second is fixed by setSimulationRate(). 0 steps once per device sample.
+	void setSimulationRate(double aSimulationRate)
+	{
+		simulationRate_ = aSimulationRate;
+		if (blockResources_.peek() != nullptr)
+			prepare(bufferSize_, sampleRate_);
+	}
+	double getSimulationRate() const
+	{
+		return simulationRate_ > 0.0 ? simulationRate_ : sampleRate_;
+	}
+
+	//Rows in the packed excitation renderBlock() hands its renderer - One per simultaneous strike point//
+	void setMaxExcitationPoints(uint32_t aMaxPoints)
+	{
+		maxExcitationPoints_ = aMaxPoints > 0 ? aMaxPoints : 1;
+		if (blockResources_.peek() != nullptr)
+			prepare(bufferSize_, sampleRate_);
+	}
+	uint32_t getMaxExcitationPoints() const
+	{
+		return maxExcitationPoints_;
+	}
+
+	//One prepared sized chunk at the device rate, converted through the simulation rate when one is set//
+	void processChunk(BlockResources& aBlock, ExcitationBlock& aExcitation, float* output, uint32_t numSamples)
+	{
+		SimulationRateConverter* converter = aBlock.rateConverter_;
+		if (converter == nullptr)
+		{
+			processBlock_(backend_, aBlock, aExcitation, output, numSamples);
+			return;
+		}
+
+		ExcitationBlock steps;
+		uint32_t numSteps;
+		{
+			DeadlineMonitor::ScopedPhase phase(deadlineMonitor_, PHASE_RESAMPLE);
+			numSteps = converter->beginBlock(aExcitation.samples_, aExcitation.stride_, aExcitation.points_, numSamples, aExcitation.length_);
+			for (uint32_t p = 0; p != aExcitation.points_; ++p)
+				memset(aExcitation.samples_ + p * aExcitation.stride_, 0, aExcitation.length_ * sizeof(float));
+		}
+		steps.samples_ = converter->getStepExcitation();
+		steps.positions_ = aExcitation.positions_;
+		steps.points_ = converter->getStepPoints();
+		steps.stride_ = converter->getStepStride();
+		steps.length_ = converter->getStepExcitationLength();
+		processBlock_(backend_, aBlock, steps, converter->getStepOutput(), numSteps);
+		DeadlineMonitor::ScopedPhase phase(deadlineMonitor_, PHASE_RESAMPLE);
+		converter->endBlock(output, numSamples);
+	}
+
+	//A chunk split at the sample offsets of any pending coefficient changes. Each change is applied between the steps
+	//either side of it, on the thread that owns the backend, so kernel arguments are never set mid block.
+	void processEvents(BlockResources& aBlock, ExcitationBlock& aExcitation, float* output, uint32_t numSamples)
+	{
+		parameterClock_.beginBlock(aBlock.sampleRate_, numSamples, aExcitation.queued_);
+		uint32_t start = 0;
+		ParameterEvent& event = heldEvent_;
+		while (eventHeld_ || parameterEvents_.read(&event, 1) == 1)
+		{
+			//Later chunks of the same callback, or later blocks, take events timed past this one//
+			const uint32_t offset = parameterClock_.delayOf(event.time_);
+			eventHeld_ = offset >= numSamples;
+			if (eventHeld_)
+				break;
+			if (offset > start)
+			{
+				processSpan(aBlock, aExcitation, output, start, offset);
+				start = offset;
+			}
+			backend_->setCoefficient(event.index_, event.value_);
+		}
+		processSpan(aBlock, aExcitation, output, start, numSamples);
+	}
+	void processSpan(BlockResources& aBlock, ExcitationBlock& aExcitation, float* output, uint32_t aStart, uint32_t aEnd)
+	{
+		ExcitationBlock span = aExcitation;
+		span.samples_ = aExcitation.samples_ + aStart;
+		span.length_ = aExcitation.length_ > aStart ? std::min(aExcitation.length_ - aStart, aEnd - aStart) : 0;
+		processChunk(aBlock, span, output + aStart, aEnd - aStart);
+	}
+
+	//Blocks longer than prepared for are split rather than rejected, so hosts that overshoot their expected size still play.
+	//Single strike point at the model's input position. excitationLength marks the leading span of input that can be
+	//non-zero - Silent blocks skip the excitation upload//
+	void fillBuffer(float* input, float* output, uint32_t numSteps, uint32_t excitationLength = UINT32_MAX)
+	{
+		EngineHandoff<BlockResources>::ReadScope resources(blockResources_);
+		BlockResources* block = resources.get();
+		int position = inputPosition_.load(std::memory_order_relaxed);
+		for (uint32_t offset = 0; offset < numSteps; offset += block->maxBlockSize_)
+		{
+			ExcitationBlock excitation;
+			const uint32_t length = std::min(numSteps - offset, block->maxBlockSize_);
+			excitation.samples_ = input + offset;
+			excitation.positions_ = &position;
+			excitation.points_ = 1;
+			excitation.stride_ = length;
+			excitation.length_ = excitationLength > offset ? std::min(excitationLength - offset, length) : 0;
+			excitation.queued_ = offset;
+			processEvents(*block, excitation, output + offset, length);
+		}
+	}
+	//As fillBuffer, with the excitation rendered chunk by chunk straight into the prepared multi-point staging. The
+	//renderer is called as uint32_t(ExcitationBlock&, uint32_t numSamples) - It fills up to points_ rows and their
+	//positions, may lower points_, and returns the active span it wrote. aQueued is how much output the caller already
+	//holds that has not been heard, so events are timed from when the block will be//
+	template<class ExcitationRenderer>
+	void renderBlock(ExcitationRenderer aRenderExcitation, float* output, uint32_t numSteps, uint32_t aQueued = 0)
+	{
+		EngineHandoff<BlockResources>::ReadScope resources(blockResources_);
+		BlockResources* block = resources.get();
+		for (uint32_t offset = 0; offset < numSteps; offset += block->maxBlockSize_)
+		{
+			ExcitationBlock excitation;
+			const uint32_t length = std::min(numSteps - offset, block->maxBlockSize_);
+			excitation.samples_ = block->excitation_;
+			excitation.positions_ = block->excitationPositions_;
+			excitation.points_ = block->maxExcitationPoints_;
+			excitation.stride_ = block->maxBlockSize_;
+			excitation.queued_ = aQueued + offset;
+			{
+				DeadlineMonitor::ScopedPhase phase(deadlineMonitor_, PHASE_EXCITER);
+				excitation.length_ = aRenderExcitation(excitation, length);
+			}
+			processEvents(*block, excitation, output + offset, length);
+		}
+	}
+	//Audio thread side of visualisation - Starts the (backend permitting asynchronous) field copy and publishes the slot//
+	void publishFieldSnapshot()
+	{
+		DeadlineMonitor::ScopedPhase phase(deadlineMonitor_, PHASE_VISUALIZATION);
+		if (display_.isEnabled())
+			backend_->requestDisplaySnapshot(snapshots_.writeSlot());
+		else
+			backend_->requestFieldSnapshot(snapshots_.writeSlot());
+		snapshots_.publish();
+	}
+	//Snapshots for an aWidth by aHeight display, aGain scaling the field first - See FDTD_Backend::requestDisplaySnapshot().
+	//0 by 0 goes back to field snapshots. Remakes the slots, so call after createModel() and before the render thread or
+	//audio thread runs//
+	void setDisplaySize(int aWidth, int aHeight, float aGain = 1.0f)
+	{
+		display_.width_ = aWidth;
+		display_.height_ = aHeight;
+		display_.gain_ = aGain;
+		allocateSnapshots();
+	}
+
+	//Rendering thread, for an engine that is not rendering this block - Applies its queued coefficient changes now rather
+	//than letting them back up until it next renders//
+	void applyParameterEvents()
+	{
+		ParameterEvent& event = heldEvent_;
+		while (eventHeld_ || parameterEvents_.read(&event, 1) == 1)
+		{
+			backend_->setCoefficient(event.index_, event.value_);
+			eventHeld_ = false;
+		}
+	}
+	//Rendering thread, between blocks - Silences the membrane, so the next block starts from rest//
+	void clearField()
+	{
+		backend_->clearField();
+	}
+
+
+	void createModel(const std::string aPath, float aBoundaryValue, uint32_t aInputPosition[2], uint32_t aOutputPosition[2])
+	{
+		realtimeAssertNonBlocking("createModel called from a real-time thread.");
+		if (!backend_->init())
+			std::cout << "ERROR initialising " << backend_->getName() << " backend." << std::endl;
+
+		//The cache key needs the device, so the backend is up before anything is loaded//
+		std::vector<unsigned char> program;
+		const std::string cacheKey = modelCache_.isEnabled() ? modelCache_.key(aPath, aBoundaryValue, backend_->getDeviceSignature()) : "";
+		const bool cached = !cacheKey.empty() && modelCache_.load(cacheKey, aBoundaryValue, modelData_, program);
+		bool loaded = cached;
+		if (!cached)
+		{
+			modelData_ = ModelData();
+			loaded = loadModel(aPath, aBoundaryValue, modelData_);
+		}
+		backend_->setProgramBinary(program);
+
+		installModel(aBoundaryValue, aInputPosition);
+
+		//Stored on a miss, and on a hit that had no program for a backend that compiles one//
+		if (loaded && !cacheKey.empty() && (!cached || program.empty()))
+		{
+			if (!backend_->getProgramBinary(program))
+				program.clear();
+			if (!cached || !program.empty())
+				modelCache_.store(cacheKey, modelData_, program);
+		}
+		if (modelCache_.isEnabled())
+			std::cout << "Model cache: " << modelCache_.getHits() << " hits, " << modelCache_.getMisses() << " misses, " << modelCache_.getEvictions()
+				<< " evicted, " << modelCache_.getBytes() / 1024 << " of " << modelCache_.getMaxBytes() / 1024 << " KB" << std::endl;
+		prepare(bufferSize_, sampleRate_);
+	}
+
+	//As createModel, with the model rasterised from aGeometry at aWidth x aHeight rather than read from a file. Not cached -
+	//Generating takes milliseconds, less than a cache hit//
+	void createModel(const ModelGeometry& aGeometry, int aWidth, int aHeight, float aBoundaryValue, uint32_t aInputPosition[2], uint32_t aOutputPosition[2])
+	{
+		realtimeAssertNonBlocking("createModel called from a real-time thread.");
+		if (!backend_->init())
+			std::cout << "ERROR initialising " << backend_->getName() << " backend." << std::endl;
+
+		modelData_ = ModelData();
+		aGeometry.generate(aWidth, aHeight, aBoundaryValue, modelData_);
+		backend_->setProgramBinary(std::vector<unsigned char>());
+		installModel(aBoundaryValue, aInputPosition);
+		prepare(bufferSize_, sampleRate_);
+	}
+
+	void createMatrixEquation(const std::string aPath);	//How is the matrix equations defined? Is there just a default matrix equation that can be formed for many equations or need be defined?
+
+	//@ToDo - Do we need this? Coefficients just need to use .setArg(), don't need to create buffer for them...
+	void createCoefficient(std::string aCoeff)
+	{
+
+	}
+	//Message thread - Stamped now and queued for the audio thread rather than set while a block may be running//
+	void updateCoefficient(std::string aCoeff, uint32_t aIndex, float aValue)
+	{
+		ParameterEvent event = { inputEventTime(), aIndex, aValue };	//@ToDo - Need dynamicaly find index for setArg (The first param)
+		if (parameterEvents_.write(&event, 1) != 1)
+			std::cout << "ERROR parameter queue full, dropped update to " << aCoeff << "." << std::endl;
+	}
+
+	//Rendering thread - Set between chunks, for control sources drained at the top of a block rather than timestamped//
+	void applyCoefficient(uint32_t aIndex, float aValue)
+	{
+		backend_->setCoefficient(aIndex, aValue);
+	}
+
+	void setInputPosition(int aInputs[])
+	{
+		model_->setInputPosition(aInputs[0], aInputs[1]);
+		inputPosition_.store(model_->getInputPosition(), std::memory_order_relaxed);
+	}
+	//Flat grid index for a strike at (x, y), kept off the outer boundary ring//
+	int getFlatPosition(int aX, int aY) const
+	{
+		aX = std::max(1, std::min(aX, modelWidth_ - 2));
+		aY = std::max(1, std::min(aY, modelHeight_ - 2));
+		return aY * modelWidth_ + aX;
+	}
+	void setOutputPosition(int aOutputs[])
+	{
+		model_->setOutputPosition(aOutputs[0], aOutputs[1]);
+		int flatPosition = model_->getOutputPosition();
+		modelData_.outputGrid_[flatPosition] = 1;
+		backend_->setOutputGrid(modelData_.outputGrid_.data());
+		pickups_.push_back(flatPosition);
+	}
+	//Rendering thread - Moves pickup aPickup to (x, y) between chunks, uploading only the cells that changed//
+	void movePickup(uint32_t aPickup, int aX, int aY)
+	{
+		if (aPickup >= pickups_.size())
+			return;
+		const int position = getFlatPosition(aX, aY);
+		const int previous = pickups_[aPickup];
+		if (position == previous)
+			return;
+		pickups_[aPickup] = position;
+
+		int* outputGrid = modelData_.outputGrid_.data();
+		if (std::find(pickups_.begin(), pickups_.end(), previous) == pickups_.end())
+		{
+			outputGrid[previous] = 0;
+			backend_->setOutputCell(outputGrid, previous);
+		}
+		if (outputGrid[position] == 0)
+		{
+			outputGrid[position] = 1;
+			backend_->setOutputCell(outputGrid, position);
+		}
+	}
+	//Rendering thread, between chunks - Paints aId into the cells of a shape, e.g. 0 to cut the membrane away or 2 to lay
+	//the second material. Only the cells that change are preprocessed again and only the rectangle around them is
+	//uploaded, so drawing on a ringing membrane costs in proportion to the stroke. The outer ring is never painted.
+	//Positions and sizes are clamped to the model. Ids other than 0, 1 and 2 are ignored - The steps only update those,
+	//and a new id would grow the material list on this thread//
+	void paintRectangle(int aX, int aY, int aWidth, int aHeight, int aId)
+	{
+		aX = std::min(std::max(aX, 0), modelWidth_);
+		aY = std::min(std::max(aY, 0), modelHeight_);
+		const ModelRegion bounds = { aX, aY, std::min(std::max(aWidth, 0), modelWidth_), std::min(std::max(aHeight, 0), modelHeight_) };
+		paintShape(bounds, aId, [](int aCellX, int aCellY) { return true; });
+	}
+	void paintCircle(int aX, int aY, int aRadius, int aId)
+	{
+		aX = std::min(std::max(aX, 0), modelWidth_);
+		aY = std::min(std::max(aY, 0), modelHeight_);
+		aRadius = std::min(std::max(aRadius, 0), std::max(modelWidth_, modelHeight_));
+		const ModelRegion bounds = { aX - aRadius, aY - aRadius, 2 * aRadius + 1, 2 * aRadius + 1 };
+		const int64_t radiusSquared = (int64_t)aRadius * aRadius;
+		paintShape(bounds, aId, [aX, aY, radiusSquared](int aCellX, int aCellY)
+		{
+			const int64_t dx = aCellX - aX;
+			const int64_t dy = aCellY - aY;
+			return dx * dx + dy * dy <= radiusSquared;
+		});
+	}
+	//Any shape, as a test of whether the cell at (x, y) inside aBounds is covered//
+	template<class Inside>
+	void paintShape(const ModelRegion& aBounds, int aId, Inside aInside)
+	{
+		if (aId < 0 || aId > 2)
+			return;
+		const int x0 = std::max(aBounds.x_, 1);
+		const int y0 = std::max(aBounds.y_, 1);
+		const int x1 = std::min(aBounds.x_ + aBounds.width_, modelWidth_ - 1);
+		const int y1 = std::min(aBounds.y_ + aBounds.height_, modelHeight_ - 1);
+
+		//Shrunk to the cells that actually change - Painting over the same cells again uploads nothing//
+		int* ids = modelData_.idGrid_.data();
+		int minX = x1, minY = y1, maxX = x0 - 1, maxY = y0 - 1;
+		for (int y = y0; y < y1; ++y)
+		{
+			for (int x = x0; x < x1; ++x)
+			{
+				if (ids[y * modelWidth_ + x] != aId && aInside(x, y))
+				{
+					minX = std::min(minX, x);
+					maxX = std::max(maxX, x);
+					minY = std::min(minY, y);
+					maxY = std::max(maxY, y);
+				}
+			}
+		}
+		if (maxX < minX)
+			return;
+
+		const ModelRegion region = { minX, minY, maxX - minX + 1, maxY - minY + 1 };
+		const int width = modelWidth_;
+		const ModelRegion changed = ModelPreprocessor::get().runRegion(modelData_, boundaryValue_, region, [&region, &aInside, ids, width, aId]()
+		{
+			for (int y = region.y_; y != region.y_ + region.height_; ++y)
+				for (int x = region.x_; x != region.x_ + region.width_; ++x)
+					if (aInside(x, y))
+						ids[y * width + x] = aId;
+		});
+		backend_->updateModelRegion(modelData_, changed);
+	}
+	uint32_t getNumPickups() const
+	{
+		return (uint32_t)pickups_.size();
+	}
+	void setInputPositions(std::vector<uint32_t> aInputs);
+	void setOutputPositions(std::vector<uint32_t> aOutputs);
+
+	void setInputs(std::vector<std::vector<float>> aInputs);
+
+	std::vector<std::vector<float>> getInputs();
+	std::vector<std::vector<float>> getOutputs();
+
+	TripleBuffer<FieldSnapshot>& getFieldSnapshots()
+	{
+		return snapshots_;
+	}
+	const float* getBoundaryGrid() const
+	{
+		return modelData_.boundaryGrid_.data();
+	}
+	const std::vector<ModelController>& getControllers() const
+	{
+		return modelData_.controllers_;
+	}
+	//Normalised defaults carried by the model - See ModelData//
+	const float* getDefaultExciter() const
+	{
+		return modelData_.exciter_;
+	}
+	const std::vector<float>& getDefaultPickups() const
+	{
+		return modelData_.pickups_;
+	}
+
+	int getModelWidth()
+	{
+		return modelWidth_;
+	}
+	int getModelHeight()
+	{
+		return modelHeight_;
+	}
+	uint32_t getMaxBlockSize() const
+	{
+		return bufferSize_;
+	}
+	double getSampleRate() const
+	{
+		return sampleRate_;
+	}
+	const char* getBackendName() const
+	{
+		return backend_->getName();
+	}
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,321 @@
+#ifndef FDTD_BACKEND_HPP
+#define FDTD_BACKEND_HPP
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "Polyphase_Resampler.hpp"
+#include "Deadline_Monitor.hpp"
+#include "Engine_Arena.hpp"
+
+enum DeviceType { INTEGRATED = 32902, DISCRETE = 4098, NVIDIA = 4318 };
+enum Implementation { OPENCL, CUDA, VULKAN, DIRECT3D, CPU };
+
+//One interface controller from the model file - Bound to an OSC address when it has one//
+struct ModelController
+{
+	int id_ = 0;
+	std::string address_;
+	bool generateCoords_ = false;	//Messages carry the touch position.
+	bool generateMove_ = false;		//Messages follow the touch as it moves.
+	bool generateEnd_ = false;		//A message marks the touch lifting.
+};
+
+//Cells of one id and how many of them are boundary - Filled by preprocessing//
+struct ModelMaterial
+{
+	int id_ = 0;
+	uint32_t cells_ = 0;
+	uint32_t boundaryCells_ = 0;
+};
+
+//Rectangle of cells - e.g. what a shape edit changed. Empty when either side is 0//
+struct ModelRegion
+{
+	int x_ = 0;
+	int y_ = 0;
+	int width_ = 0;
+	int height_ = 0;
+
+	bool isEmpty() const
+	{
+		return width_ <= 0 || height_ <= 0;
+	}
+	//Grown by aCells on every side and clipped to a aWidth by aHeight grid//
+	ModelRegion expanded(int aCells, int aWidth, int aHeight) const
+	{
+		ModelRegion region;
+		region.x_ = std::max(0, x_ - aCells);
+		region.y_ = std::max(0, y_ - aCells);
+		region.width_ = std::min(aWidth, x_ + width_ + aCells) - region.x_;
+		region.height_ = std::min(aHeight, y_ + height_ + aCells) - region.y_;
+		return region;
+	}
+};
+
+//Square tiles the grid is divided into for activeTiles_ - Matches the OpenCL work group//
+static const int MODEL_TILE_SIZE = 32;
+
+//Host side description of a parsed model - Everything a backend needs to upload//
+struct ModelData
+{
+	int width_ = 0;
+	int height_ = 0;
+	std::vector<int> idGrid_;
+	std::vector<float> boundaryGrid_;
+	std::vector<int> outputGrid_;
+	std::string kernelSource_;
+	std::vector<ModelController> controllers_;
+
+	//Derived from the ids by ModelPreprocessor (Model_Preprocess.hpp)//
+	std::vector<unsigned char> neighbourMask_;	//Bits 0-3 set where the left, right, up and down neighbours are non-zero.
+	std::vector<uint32_t> activeTiles_;			//Row major indices of the tiles holding any non-zero id.
+	std::vector<ModelMaterial> materials_;		//By ascending id.
+
+	//Host defaults, normalised 0-1 across the model - JSON models carry none and keep these. The exciter is (x, y) as for
+	//getFlatPosition(), pickups are pairs as given to setOutputPosition()//
+	float exciter_[2] = { 0.5f, 0.5f };
+	std::vector<float> pickups_ = { 0.5f, 0.25f, 0.5f, 0.625f };
+
+	int elements() const
+	{
+		return width_ * height_;
+	}
+};
+
+//Display snapshots - The field box filtered down to width_ by height_, scaled by gain_ and colormapped to RGBA8//
+struct DisplayFormat
+{
+	int fieldWidth_ = 0;
+	int fieldHeight_ = 0;
+	int width_ = 0;				//0 - Snapshots copy the field itself.
+	int height_ = 0;
+	float gain_ = 1.0f;
+
+	bool isEnabled() const
+	{
+		return width_ > 0 && height_ > 0;
+	}
+	int bytes() const
+	{
+		return width_ * height_ * 4;
+	}
+};
+
+//Matches the colormap in shaders/opengl/fs.glsl, as does the OpenCL displayKernel//
+inline unsigned char colormapChannel(float aValue)
+{
+	const float clamped = aValue < 0.0f ? 0.0f : (aValue > 1.0f ? 1.0f : aValue);
+	return (unsigned char)(clamped * 255.0f + 0.5f);
+}
+inline void colormapPixel(float aValue, unsigned char* aPixel)
+{
+	aPixel[0] = colormapChannel(aValue < 0.7f ? 4.0f * aValue - 1.5f : -4.0f * aValue + 4.5f);
+	aPixel[1] = colormapChannel(aValue < 0.5f ? 4.0f * aValue - 0.5f : -4.0f * aValue + 3.5f);
+	aPixel[2] = colormapChannel(aValue < 0.3f ? 4.0f * aValue + 0.5f : -4.0f * aValue + 2.5f);
+	aPixel[3] = 255;
+}
+//Each pixel averages the cells it covers, or samples the nearest when the field is smaller than the display. The rows
+//under a display row are summed into a chunk of columns, which vectorises, and the pixels inside the chunk binned from
+//it with their edges stepped rather than divided. Pixels wider than a chunk average its cells alone//
+inline void colormapField(const float* aField, const DisplayFormat& aFormat, unsigned char* aPixels)
+{
+	const int chunk = 256;
+	float columns[chunk];
+	const int step = aFormat.fieldWidth_ / aFormat.width_;
+	const int extra = aFormat.fieldWidth_ % aFormat.width_;
+	for (int py = 0; py != aFormat.height_; ++py)
+	{
+		const int y0 = py * aFormat.fieldHeight_ / aFormat.height_;
+		const int y1 = std::max(y0 + 1, (py + 1) * aFormat.fieldHeight_ / aFormat.height_);
+		unsigned char* pixel = aPixels + py * aFormat.width_ * 4;
+		int px = 0;
+		int x0 = 0;				//px * fieldWidth_ / width_, stepped along with its remainder.
+		int remainder = 0;
+		while (px != aFormat.width_)
+		{
+			const int first = x0;
+			const int count = std::min(chunk, aFormat.fieldWidth_ - first);
+			for (int x = 0; x != count; ++x)
+				columns[x] = aField[y0 * aFormat.fieldWidth_ + first + x];
+			for (int y = y0 + 1; y != y1; ++y)
+			{
+				const float* row = aField + y * aFormat.fieldWidth_ + first;
+				for (int x = 0; x != count; ++x)
+					columns[x] += row[x];
+			}
+			for (; px != aFormat.width_; ++px, pixel += 4)
+			{
+				int next = x0 + step;
+				int nextRemainder = remainder + extra;
+				if (nextRemainder >= aFormat.width_)
+				{
+					++next;
+					nextRemainder -= aFormat.width_;
+				}
+				int x1 = std::max(x0 + 1, next);
+				if (x1 > first + count)
+				{
+					if (x0 != first)
+						break;
+					x1 = first + count;
+				}
+				float sum = 0.0f;
+				for (int x = x0; x != x1; ++x)
+					sum += columns[x - first];
+				colormapPixel(sum * aFormat.gain_ / (float)((x1 - x0) * (y1 - y0)), pixel);
+				x0 = next;
+				remainder = nextRemainder;
+			}
+		}
+	}
+}
+
+//One slot of the field snapshot triple buffer. A copy into field_ is complete when completed_ catches up with requested_,
+//counting rather than flagging so a late completion of an earlier request can never mark a newer one as done.
+struct FieldSnapshot
+{
+	float* field_ = nullptr;		//One grid - The backend's own snapshot memory, or carved from the engine's model arena.
+	unsigned char* pixels_ = nullptr;	//RGBA8 display snapshot - Null unless the engine has a DisplayFormat.
+	int pixelWidth_ = 0;
+	int pixelHeight_ = 0;
+	bool coloured_ = false;			//The request filled pixels_ - Otherwise field_, for the reader to colour.
+	std::atomic<uint64_t> requested_;
+	std::atomic<uint64_t> completed_;
+
+	FieldSnapshot() : requested_(0), completed_(0) {}
+
+	bool isComplete() const
+	{
+		return completed_.load(std::memory_order_acquire) == requested_.load(std::memory_order_acquire);
+	}
+};
+
+//One block of excitation for several strike points. Row p is samples_[p * stride_ ...] and is added at the flat grid
+//index positions_[p]. Only [0, length_) of any row can be non-zero, so a length_ of 0 is a silent block.
+struct ExcitationBlock
+{
+	float* samples_ = nullptr;
+	int* positions_ = nullptr;
+	uint32_t points_ = 0;
+	uint32_t stride_ = 0;
+	uint32_t length_ = 0;
+	uint32_t queued_ = 0;		//Samples rendered ahead of this chunk and not yet heard - See BlockClock.
+};
+
+//Everything sized by the device block - Built off the audio thread by createBlockResources() for the negotiated block
+//size and rate, then swapped in whole so the hot path never checks or resizes. Backends derive to add device buffers.
+struct BlockResources
+{
+	uint32_t maxBlockSize_ = 0;
+	uint32_t maxExcitationPoints_ = 0;
+	double sampleRate_ = 0.0;
+	EngineArena arena_;			//Holds the host side buffers below - Released with the resources.
+	float* excitation_ = nullptr;		//Excitation staging - maxExcitationPoints_ rows of maxBlockSize_. Device mapped when the backend provides it.
+	int* excitationPositions_ = nullptr;
+	SimulationRateConverter* rateConverter_ = nullptr;	//Null when the grid steps once per device sample.
+
+	virtual ~BlockResources()
+	{
+		delete rateConverter_;
+	}
+};
+
+//Interface every compute backend implements. Cold path calls (init, upload, snapshots, coefficients) are virtual,
+//the per-block processBlock() is not - It is bound once through processBlockThunk so the audio thread makes a single
+//direct call into a final class and the step loop inlines.
+class FDTD_Backend
+{
+protected:
+	DeadlineMonitor* deadlineMonitor_ = nullptr;	//Optional - processBlock() times its phases into it.
+	DisplayFormat display_;
+public:
+	//Backends zero the excitation span they consumed, and may skip uploading anything past it//
+	typedef void(*ProcessBlockFn)(FDTD_Backend*, BlockResources&, ExcitationBlock&, float*, uint32_t);
+
+	virtual ~FDTD_Backend() {}
+
+	virtual bool init() = 0;
+	virtual void uploadModel(const ModelData& aModel) = 0;
+	//Ids and boundary of aModel changed inside aRegion - Uploads that rectangle alone. Between blocks, on the thread driving
+	//processBlock. aModel must stay valid until the next block has been read back//
+	virtual void updateModelRegion(const ModelData& aModel, const ModelRegion& aRegion) = 0;
+	virtual BlockResources* createBlockResources(uint32_t aMaxBlockSize, uint32_t aMaxExcitationPoints) = 0;
+	virtual void readFieldSnapshot(float* aField) = 0;
+	//Zeroes all three time steps of the field - Between blocks, on the thread driving processBlock//
+	virtual void clearField() = 0;
+
+	//Starts a copy of the current field into aSlot. Backends with asynchronous transfers override this so the caller
+	//only pays for the enqueue - The default copies synchronously.
+	virtual void requestFieldSnapshot(FieldSnapshot& aSlot)
+	{
+		aSlot.requested_.fetch_add(1, std::memory_order_relaxed);
+		readFieldSnapshot(aSlot.field_);
+		aSlot.completed_.fetch_add(1, std::memory_order_release);
+	}
+
+	//Cold path, after uploadModel() - Host memory for snapshot slot aSlot's field, or null for the engine to allocate it.
+	//Backends whose copies can only land in host visible buffers of their own hand those out, so a snapshot is read where
+	//it lands rather than copied again on the audio thread//
+	virtual float* getSnapshotField(uint32_t aSlot)
+	{
+		return nullptr;
+	}
+	//Cold path, after uploadModel() - Sizes whatever requestDisplaySnapshot() needs on the device//
+	virtual void setDisplayFormat(const DisplayFormat& aFormat)
+	{
+		display_ = aFormat;
+	}
+	//As requestFieldSnapshot() but for a display. Backends that can downsample and colormap on the device override this
+	//to read back aSlot.pixels_ alone - The default copies the field, leaving colormapField() to the reader, as on the host
+	//colouring costs several times the copy and the caller is the audio thread.
+	virtual void requestDisplaySnapshot(FieldSnapshot& aSlot)
+	{
+		aSlot.coloured_ = false;
+		requestFieldSnapshot(aSlot);
+	}
+
+	virtual void setCoefficient(uint32_t aIndex, float aValue) = 0;
+	virtual void setOutputGrid(const int* aOutputGrid) = 0;
+	//One cell of aOutputGrid changed - Called between blocks on the thread driving processBlock. aOutputGrid must stay
+	//valid until the next block has been read back//
+	virtual void setOutputCell(const int* aOutputGrid, int aPosition)
+	{
+		setOutputGrid(aOutputGrid);
+	}
+
+	virtual const char* getName() const = 0;
+
+	//Model cache hooks. The signature names everything a compiled program is only valid on - Backend, device, driver and
+	//build options. setProgramBinary() offers a previously compiled program to the next uploadModel(), which builds from
+	//source if the device rejects it, and getProgramBinary() returns what uploadModel() ended up with. Backends that
+	//compile nothing keep the defaults//
+	virtual std::string getDeviceSignature() const
+	{
+		return getName();
+	}
+	virtual void setProgramBinary(const std::vector<unsigned char>& aBinary)
+	{
+	}
+	virtual bool getProgramBinary(std::vector<unsigned char>& aBinary)
+	{
+		return false;
+	}
+
+	//Set before the audio thread runs, and only for a backend driven from the thread the monitor times//
+	void setDeadlineMonitor(DeadlineMonitor* aMonitor)
+	{
+		deadlineMonitor_ = aMonitor;
+	}
+
+	template<class Backend>
+	static void processBlockThunk(FDTD_Backend* aBackend, BlockResources& aResources, ExcitationBlock& aExcitation, float* aOutput, uint32_t aNumSteps)
+	{
+		static_cast<Backend*>(aBackend)->processBlock(aResources, aExcitation, aOutput, aNumSteps);
+	}
+};
+
+#endif
@@ -0,0 +1,244 @@
+#ifndef FDTD_BACKEND_CPU_HPP
+#define FDTD_BACKEND_CPU_HPP
+
+#include <vector>
+#include <algorithm>
+#include <string.h>
+
+#include "FDTD_Backend.hpp"
+
+//Reference host implementation of the twin-membrane fdtdKernel (twinMembraneKernelSource, and the kernel the model files
+//carry) - Same update, same pickup sum over the field before the step, and coefficient indices set through
+//updateCoefficient() mean the same thing as on the OpenCL device. Other kernel sources are not interpreted.
+class FDTD_Backend_CPU final : public FDTD_Backend
+{
+private:
+	int modelWidth_ = 0;
+	int modelHeight_ = 0;
+	int gridElements_ = 0;
+
+	std::vector<int> idGrid_;
+	std::vector<float> modelGrid_;		//Three time steps back to back, rotated by bufferRotationIndex_.
+	std::vector<int> outputGrid_;
+	std::vector<int> outputCells_;		//Flat indices of outputGrid_ cells - Avoids scanning the grid per step.
+	static const size_t MAX_MOVED_CELLS = 16;
+
+	//Stepped tile by tile over the model's active tiles only - Everything outside them is id 0 and stays zero, except a
+	//strike landing there. Those cells are remembered per time step buffer and zeroed when the buffer comes round again,
+	//as the full grid loop would have done//
+	std::vector<uint32_t> activeTiles_;
+	int tilesX_ = 0;
+	static const uint32_t MAX_STRAY_CELLS = 64;
+	int strayCells_[3][MAX_STRAY_CELLS];
+	uint32_t numStrayCells_[3] = { 0, 0, 0 };
+
+	//Tiles an edit emptied - Stepped for one more rotation so their cells fall to zero a buffer at a time, as they do
+	//under the kernel, then dropped//
+	std::vector<uint32_t> retiringTiles_;
+	int retiringSteps_ = 0;
+
+	int bufferRotationIndex_ = 1;
+
+	//Coefficients - Indexed as the kernel arguments 9 to 12//
+	float muOne_ = 0.0;
+	float lambdaOne_ = 0.0;
+	float lambdaTwo_ = 0.0;
+	float muTwo_ = 0.0;
+
+	//fdtdKernel's update term for term - Ids other than 1 and 2 are held at rest, the boundary grid is not applied//
+	void stepTiles(const std::vector<uint32_t>& aTiles, const float* current, const float* previous, float* next)
+	{
+		const float scaleOne = 1.0f / (muOne_ + 1.0f);
+		const float scaleTwo = 1.0f / (muTwo_ + 1.0f);
+		const int* ids = idGrid_.data();
+		for (const uint32_t tile : aTiles)
+		{
+			const int tileX = (int)(tile % tilesX_) * MODEL_TILE_SIZE;
+			const int tileY = (int)(tile / tilesX_) * MODEL_TILE_SIZE;
+			const int endX = std::min(tileX + MODEL_TILE_SIZE, modelWidth_ - 1);
+			const int endY = std::min(tileY + MODEL_TILE_SIZE, modelHeight_ - 1);
+			for (int y = std::max(tileY, 1); y < endY; ++y)
+			{
+				for (int x = std::max(tileX, 1); x < endX; ++x)
+				{
+					const int idx = y * modelWidth_ + x;
+					const int id = ids[idx];
+					if (id != 1 && id != 2)
+					{
+						next[idx] = 0.0f;
+						continue;
+					}
+
+					const float lambda = id == 1 ? lambdaOne_ : lambdaTwo_;
+					const float mu = id == 1 ? muOne_ : muTwo_;
+					const float scale = id == 1 ? scaleOne : scaleTwo;
+
+					const float centre = current[idx];
+					const float neighbours = current[idx + 1] + current[idx - 1] + current[idx + modelWidth_] + current[idx - modelWidth_];
+					next[idx] = ((2.0f * centre) + ((mu - 1.0f) * previous[idx]) + (lambda * (neighbours - (4.0f * centre)))) * scale;
+				}
+			}
+		}
+	}
+
+	float step(const ExcitationBlock& aExcitation, uint32_t aStep)
+	{
+		float* current = &modelGrid_[bufferRotationIndex_ * gridElements_];
+		float* previous = &modelGrid_[((bufferRotationIndex_ + 2) % 3) * gridElements_];
+		float* next = &modelGrid_[((bufferRotationIndex_ + 1) % 3) * gridElements_];
+
+		const int nextIndex = (bufferRotationIndex_ + 1) % 3;
+		for (uint32_t s = 0; s != numStrayCells_[nextIndex]; ++s)
+			next[strayCells_[nextIndex][s]] = 0.0f;
+		numStrayCells_[nextIndex] = 0;
+
+		stepTiles(activeTiles_, current, previous, next);
+		if (retiringSteps_ != 0)
+		{
+			stepTiles(retiringTiles_, current, previous, next);
+			if (--retiringSteps_ == 0)
+				retiringTiles_.clear();
+		}
+
+		const int* ids = idGrid_.data();
+		if (aStep < aExcitation.length_)
+		{
+			for (uint32_t p = 0; p != aExcitation.points_; ++p)
+			{
+				const int position = aExcitation.positions_[p];
+				next[position] += aExcitation.samples_[p * aExcitation.stride_ + aStep];
+				if (ids[position] == 0 && numStrayCells_[nextIndex] != MAX_STRAY_CELLS)
+					strayCells_[nextIndex][numStrayCells_[nextIndex]++] = position;
+			}
+		}
+
+		//The kernel sums the pickups' centre values, the field before this step's update//
+		float sample = 0.0f;
+		for (size_t i = 0; i != outputCells_.size(); ++i)
+			sample += current[outputCells_[i]];
+
+		bufferRotationIndex_ = (bufferRotationIndex_ + 1) % 3;
+		return sample;
+	}
+public:
+	bool init() override
+	{
+		return true;
+	}
+
+	void uploadModel(const ModelData& aModel) override
+	{
+		modelWidth_ = aModel.width_;
+		modelHeight_ = aModel.height_;
+		gridElements_ = aModel.elements();
+
+		idGrid_ = aModel.idGrid_;
+		modelGrid_.assign(gridElements_ * 3, 0.0);
+
+		//Models not run through the preprocessor step every tile//
+		tilesX_ = (modelWidth_ + MODEL_TILE_SIZE - 1) / MODEL_TILE_SIZE;
+		activeTiles_ = aModel.activeTiles_;
+		const uint32_t tiles = (uint32_t)(tilesX_ * ((modelHeight_ + MODEL_TILE_SIZE - 1) / MODEL_TILE_SIZE));
+		activeTiles_.reserve(tiles);	//Room for any edit's tile list without allocating.
+		if (activeTiles_.empty())
+			for (uint32_t t = 0; t != tiles; ++t)
+				activeTiles_.push_back(t);
+		retiringTiles_.clear();
+		retiringTiles_.reserve(tiles);
+		retiringSteps_ = 0;
+		numStrayCells_[0] = numStrayCells_[1] = numStrayCells_[2] = 0;
+		setOutputGrid(aModel.outputGrid_.data());
+	}
+
+	//Cells leaving the membrane keep their values until the steps zero them, as on the device - A tile dropping out of
+	//activeTiles_ retires for one rotation first//
+	void updateModelRegion(const ModelData& aModel, const ModelRegion& aRegion) override
+	{
+		for (int y = aRegion.y_; y != aRegion.y_ + aRegion.height_; ++y)
+		{
+			const int row = y * modelWidth_ + aRegion.x_;
+			memcpy(&idGrid_[row], &aModel.idGrid_[row], aRegion.width_ * sizeof(int));
+		}
+		if (aModel.activeTiles_.empty())
+			return;
+
+		const std::vector<uint32_t>& tiles = aModel.activeTiles_;
+		for (const uint32_t tile : activeTiles_)
+			if (!std::binary_search(tiles.begin(), tiles.end(), tile) && std::find(retiringTiles_.begin(), retiringTiles_.end(), tile) == retiringTiles_.end())
+				retiringTiles_.push_back(tile);
+		retiringTiles_.erase(std::remove_if(retiringTiles_.begin(), retiringTiles_.end(),
+			[&tiles](uint32_t aTile) { return std::binary_search(tiles.begin(), tiles.end(), aTile); }), retiringTiles_.end());
+		if (!retiringTiles_.empty())
+			retiringSteps_ = 3;
+		activeTiles_.assign(tiles.begin(), tiles.end());
+	}
+
+	//Steps write straight into the caller's output - Nothing device side is sized by the block//
+	BlockResources* createBlockResources(uint32_t aMaxBlockSize, uint32_t aMaxExcitationPoints) override
+	{
+		return new BlockResources();
+	}
+
+	void processBlock(BlockResources& aResources, ExcitationBlock& excitation, float* output, uint32_t numSteps)
+	{
+		DeadlineMonitor::ScopedPhase phase(deadlineMonitor_, PHASE_STEPS);
+		for (uint32_t i = 0; i != numSteps; ++i)
+			output[i] = step(excitation, i);
+
+		const uint32_t active = excitation.length_ < numSteps ? excitation.length_ : numSteps;
+		for (uint32_t p = 0; p != excitation.points_; ++p)
+			memset(excitation.samples_ + p * excitation.stride_, 0, active * sizeof(float));
+	}
+
+	void readFieldSnapshot(float* aField) override
+	{
+		memcpy(aField, &modelGrid_[bufferRotationIndex_ * gridElements_], gridElements_ * sizeof(float));
+	}
+
+	void clearField() override
+	{
+		std::fill(modelGrid_.begin(), modelGrid_.end(), 0.0f);
+		retiringTiles_.clear();
+		retiringSteps_ = 0;
+		numStrayCells_[0] = numStrayCells_[1] = numStrayCells_[2] = 0;
+	}
+
+	void setCoefficient(uint32_t aIndex, float aValue) override
+	{
+		switch (aIndex)
+		{
+		case 9: muOne_ = aValue; break;
+		case 10: lambdaOne_ = aValue; break;
+		case 11: lambdaTwo_ = aValue; break;
+		case 12: muTwo_ = aValue; break;
+		default: break;
+		}
+	}
+	void setOutputGrid(const int* aOutputGrid) override
+	{
+		outputGrid_.assign(aOutputGrid, aOutputGrid + gridElements_);
+		outputCells_.clear();
+		for (int i = 0; i != gridElements_; ++i)
+			if (outputGrid_[i])
+				outputCells_.push_back(i);
+		outputCells_.reserve(outputCells_.size() + MAX_MOVED_CELLS);	//Room for setOutputCell without allocating.
+	}
+	void setOutputCell(const int* aOutputGrid, int aPosition) override
+	{
+		if ((outputGrid_[aPosition] != 0) == (aOutputGrid[aPosition] != 0))
+			return;
+		outputGrid_[aPosition] = aOutputGrid[aPosition];
+		std::vector<int>::iterator cell = std::find(outputCells_.begin(), outputCells_.end(), aPosition);
+		if (cell != outputCells_.end())
+			outputCells_.erase(cell);
+		else if (outputCells_.size() != outputCells_.capacity())
+			outputCells_.push_back(aPosition);
+	}
+
+	const char* getName() const override
+	{
+		return "CPU";
+	}
+};
+
+#endif
@@ -0,0 +1,535 @@
+#ifndef FDTD_BACKEND_OPENCL_HPP
+#define FDTD_BACKEND_OPENCL_HPP
+
+#include <iostream>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+//#define CL_HPP_TARGET_OPENCL_VERSION 210
+//#define CL_HPP_MINIMUM_OPENCL_VERSION 200
+#define CL_HPP_TARGET_OPENCL_VERSION 120
+#define CL_HPP_MINIMUM_OPENCL_VERSION 120
+#include <CL/cl2.hpp>
+//#include <CL/cl.hpp>
+#include <CL/cl_gl.h>
+
+#include "FDTD_Backend.hpp"
+#include "Trace_Recorder.hpp"
+
+//Adds every strike point's sample for this step onto the freshly written grid, before the pickup launch reads it. One
+//work item walks the points so two voices on the same cell cannot race.
+static const char* exciteKernelSource =
+	"__kernel void exciteKernel(__global float* modelGrid, __global const float* excitation, __global const int* positions,\n"
+	"	int points, int stride, int step, int rotationIndex, int gridElements, int offset)\n"
+	"{\n"
+	"	__global float* next = modelGrid + ((rotationIndex + 1) % 3) * gridElements;\n"
+	"	for (int p = 0; p != points; ++p)\n"
+	"		next[positions[p]] += excitation[p * stride + offset + step];\n"
+	"}\n";
+
+//One work item per display pixel - Averages the cells it covers and applies the fs.glsl colormap, as colormapField() does
+//on the host, so a snapshot reads back RGBA8 pixels rather than the float grid.
+static const char* displayKernelSource =
+	"__kernel void displayKernel(__global const float* modelGrid, __global uchar4* pixels, int rotationIndex, int fieldWidth,\n"
+	"	int fieldHeight, float gain)\n"
+	"{\n"
+	"	const int px = get_global_id(0);\n"
+	"	const int py = get_global_id(1);\n"
+	"	const int width = get_global_size(0);\n"
+	"	const int height = get_global_size(1);\n"
+	"	__global const float* field = modelGrid + rotationIndex * fieldWidth * fieldHeight;\n"
+	"	const int x0 = px * fieldWidth / width;\n"
+	"	const int x1 = max(x0 + 1, (px + 1) * fieldWidth / width);\n"
+	"	const int y0 = py * fieldHeight / height;\n"
+	"	const int y1 = max(y0 + 1, (py + 1) * fieldHeight / height);\n"
+	"	float sum = 0.0f;\n"
+	"	for (int y = y0; y != y1; ++y)\n"
+	"		for (int x = x0; x != x1; ++x)\n"
+	"			sum += field[y * fieldWidth + x];\n"
+	"	const float v = sum * gain / (float)((x1 - x0) * (y1 - y0));\n"
+	"	const float4 colour = (float4)(v < 0.7f ? 4.0f * v - 1.5f : -4.0f * v + 4.5f, v < 0.5f ? 4.0f * v - 0.5f : -4.0f * v + 3.5f,\n"
+	"		v < 0.3f ? 4.0f * v + 0.5f : -4.0f * v + 2.5f, 1.0f);\n"
+	"	pixels[py * width + px] = convert_uchar4_sat_rte(clamp(colour, 0.0f, 1.0f) * 255.0f);\n"
+	"}\n";
+
+static const char* modelProgramOptions = " -cl-fast-relaxed-math -cl-single-precision-constant";
+
+class FDTD_Backend_OpenCL final : public FDTD_Backend
+{
+private:
+	struct OpenCLBlockResources : public BlockResources
+	{
+		cl::Buffer outputBuffer_;
+		cl::Buffer excitationBuffer_;		//maxExcitationPoints_ rows of stride_ samples.
+		EngineArena staging_;				//Host side of excitationBuffer_ - The device uses it in place.
+		float* stagingRows_ = nullptr;
+		size_t stagingBytes_ = 0;
+		bool mapped_ = false;				//Rows are mapped for the host to write - Unmapped while kernels read them.
+		cl::Event mapEvent_;
+		cl::Buffer positionBuffer_;
+		cl::Buffer silentBuffer_;			//Bound to the model kernel's own excitation argument - Always zero.
+		uint32_t stride_ = 0;
+		uint32_t uploadedLength_ = 0;		//Leading span of excitationBuffer_ that may still be non-zero.
+		uint32_t uploadedPoints_ = 0;
+	};
+
+	DeviceType deviceType_;
+
+	//CL//
+	cl_int errorStatus_ = 0;
+	cl::Platform platform_;
+	cl::Context context_;
+	cl::Device device_;
+	cl::CommandQueue commandQueue_;
+	cl::Program kernelProgram_;
+	cl::Kernel kernel_;
+	cl::Program exciteProgram_;
+	cl::Kernel exciteKernel_;
+	cl::Program displayProgram_;		//Built by the first setDisplayFormat() that enables display snapshots.
+	cl::Kernel displayKernel_;
+	std::vector<unsigned char> cachedModelProgram_;		//Offered by the model cache for the next uploadModel().
+	std::vector<unsigned char> cachedExciteProgram_;
+	cl::NDRange globalws_;
+	cl::NDRange localws_;
+
+	//CL Buffers//
+	cl::Buffer idGrid_;
+	cl::Buffer modelGrid_;
+	cl::Buffer boundaryGridBuffer_;
+	cl::Buffer outputPositionBuffer_;
+	cl::Buffer pixelBuffer_;
+
+	//Model//
+	int modelWidth_ = 0;
+	int gridElements_ = 0;
+	int gridByteSize_ = 0;
+
+	//Output and excitations//
+	int bufferIndex_ = 0;
+	int bufferRotationIndex_ = 1;
+
+	cl::Event snapshotEvent_;
+
+	//Device track for the trace recorder - Only filled while a trace is recording//
+	TraceBuffer* deviceTrace_ = nullptr;
+	cl::Event firstStepEvent_;
+	cl::Event lastStepEvent_;
+	cl::Event readbackEvent_;
+
+	static void CL_CALLBACK snapshotComplete(cl_event aEvent, cl_int aStatus, void* aSlot)
+	{
+		static_cast<FieldSnapshot*>(aSlot)->completed_.fetch_add(1, std::memory_order_release);
+	}
+
+	void step(bool aExcite, cl::Event* aStartEvent = NULL, cl::Event* aEndEvent = NULL)
+	{
+		commandQueue_.enqueueNDRangeKernel(kernel_, cl::NullRange/*globaloffset*/, globalws_, localws_, NULL, aStartEvent);
+		if (aExcite)
+			commandQueue_.enqueueNDRangeKernel(exciteKernel_, cl::NullRange, 1, cl::NullRange, NULL);
+		commandQueue_.enqueueNDRangeKernel(kernel_, cl::NullRange/*globaloffset*/, 2, localws_, NULL, aEndEvent);
+		//commandQueue_.finish();
+
+		bufferIndex_++;
+		bufferRotationIndex_ = (bufferRotationIndex_ + 1) % 3;
+	}
+	//Profiled times are on the device clock - Anchored so the readback ends when the blocking read returned on the host//
+	void traceDeviceBlock(int64_t aReadReturned)
+	{
+		const int64_t offset = aReadReturned - (int64_t)readbackEvent_.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+		const int64_t stepsStart = (int64_t)firstStepEvent_.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+		const int64_t stepsEnd = (int64_t)lastStepEvent_.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+		const int64_t readStart = (int64_t)readbackEvent_.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+		const int64_t readEnd = (int64_t)readbackEvent_.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+		TraceRecorder::record('X', "device steps", stepsStart + offset, stepsEnd - stepsStart, 0.0, deviceTrace_);
+		TraceRecorder::record('X', "device readback", readStart + offset, readEnd - readStart, 0.0, deviceTrace_);
+	}
+	void initBuffersCL(const ModelData& aModel)
+	{
+		//Create input and output buffer for grid points//
+		idGrid_ = cl::Buffer(context_, CL_MEM_READ_WRITE, gridByteSize_);
+		modelGrid_ = cl::Buffer(context_, CL_MEM_READ_WRITE, gridByteSize_ * 3);
+		boundaryGridBuffer_ = cl::Buffer(context_, CL_MEM_READ_WRITE, gridByteSize_);
+		outputPositionBuffer_ = cl::Buffer(context_, CL_MEM_READ_WRITE, gridByteSize_);
+
+		//Copy data to newly created device's memory//
+		std::vector<float> temporaryGrid(gridElements_ * 3, 0.0);
+
+		commandQueue_.enqueueWriteBuffer(idGrid_, CL_TRUE, 0, gridByteSize_, aModel.idGrid_.data());
+		commandQueue_.enqueueWriteBuffer(modelGrid_, CL_TRUE, 0, gridByteSize_ * 3, temporaryGrid.data());
+		commandQueue_.enqueueWriteBuffer(boundaryGridBuffer_, CL_TRUE, 0, gridByteSize_, aModel.boundaryGrid_.data());
+		commandQueue_.enqueueWriteBuffer(outputPositionBuffer_, CL_TRUE, 0, gridByteSize_, aModel.outputGrid_.data());
+	}
+	//Builds for device_ alone, from aBinary when the device takes it and otherwise from source//
+	bool buildProgram(cl::Program& aProgram, const std::string& aSource, const char* aOptions, const std::vector<unsigned char>& aBinary)
+	{
+		const cl::vector<cl::Device> devices(1, device_);
+		if (!aBinary.empty())
+		{
+			std::vector<cl_int> binaryStatus;
+			aProgram = cl::Program(context_, devices, cl::Program::Binaries(1, aBinary), &binaryStatus, &errorStatus_);
+			if (errorStatus_ == CL_SUCCESS && aProgram.build(devices, aOptions) == CL_SUCCESS)
+				return true;
+			std::cout << "Cached OpenCL program rejected by the device, building from source." << std::endl;
+		}
+
+		//Create program from source code//
+		aProgram = cl::Program(context_, cl::Program::Sources(1, aSource), &errorStatus_);
+		if (errorStatus_)
+		{
+			std::cout << "ERROR creating OpenCL program from source. Status code: " << errorStatus_ << std::endl;
+			return false;
+		}
+		return aProgram.build(devices, aOptions) == CL_SUCCESS;	//@Highlight - Keep this in?
+	}
+	void createExplicitEquation(const std::string& aSourceFile)
+	{
+		buildProgram(kernelProgram_, aSourceFile, modelProgramOptions, cachedModelProgram_);
+
+		kernel_ = cl::Kernel(kernelProgram_, "fdtdKernel", &errorStatus_);	//@ToDo - Hard coded the kernel name. Find way to generate this?
+		if (errorStatus_)
+			std::cout << "ERROR building OpenCL kernel from source. Status code: " << errorStatus_ << std::endl;
+
+		kernel_.setArg(0, sizeof(cl_mem), &idGrid_);
+		kernel_.setArg(1, sizeof(cl_mem), &modelGrid_);
+		kernel_.setArg(2, sizeof(cl_mem), &boundaryGridBuffer_);
+		kernel_.setArg(8, sizeof(cl_mem), &outputPositionBuffer_);
+		int noInput = 0;
+		kernel_.setArg(7, sizeof(int), &noInput);
+
+		buildProgram(exciteProgram_, exciteKernelSource, "", cachedExciteProgram_);
+		exciteKernel_ = cl::Kernel(exciteProgram_, "exciteKernel", &errorStatus_);
+		if (errorStatus_)
+			std::cout << "ERROR building OpenCL excitation kernel. Status code: " << errorStatus_ << std::endl;
+		exciteKernel_.setArg(0, sizeof(cl_mem), &modelGrid_);
+		exciteKernel_.setArg(7, sizeof(int), &gridElements_);
+		int noOffset = 0;
+		exciteKernel_.setArg(8, sizeof(int), &noOffset);
+	}
+public:
+	FDTD_Backend_OpenCL() : deviceType_(NVIDIA)
+	{
+	}
+
+	bool init() override
+	{
+		std::vector <cl::Platform> platforms;
+		cl::Platform::get(&platforms);
+		for (cl::vector<cl::Platform>::iterator it = platforms.begin(); it != platforms.end(); ++it)
+		{
+			cl::Platform platform(*it);
+
+			cl_context_properties contextProperties[3] = { CL_CONTEXT_PLATFORM, (cl_context_properties)(platform)(), 0 };
+			context_ = cl::Context(CL_DEVICE_TYPE_GPU, contextProperties);
+
+			cl::vector<cl::Device> devices = context_.getInfo<CL_CONTEXT_DEVICES>();
+
+			int device_id = 0;
+			for (cl::vector<cl::Device>::iterator it2 = devices.begin(); it2 != devices.end(); ++it2)
+			{
+				cl::Device device(*it2);
+				auto d = device.getInfo<CL_DEVICE_VENDOR_ID>();
+				if (d == DeviceType::NVIDIA || d == DeviceType::DISCRETE)	//Hard coded to pick AMD or NVIDIA.
+				{
+					//Create command queue for first device - Profiling enabled//
+					commandQueue_ = cl::CommandQueue(context_, device, CL_QUEUE_PROFILING_ENABLE, &errorStatus_);	//Need to specify device 1[0] of platform 3[2] for dedicated graphics - Harri Laptop.
+					if (errorStatus_)
+						std::cout << "ERROR creating command queue for device. Status code: " << errorStatus_ << std::endl;
+
+					std::cout << "\t\tDevice Name Chosen: " << device.getInfo<CL_DEVICE_NAME>() << std::endl;
+					if (deviceTrace_ == nullptr)
+						deviceTrace_ = TraceRecorder::get().createBuffer("OpenCL device");
+
+					platform_ = platform;
+					device_ = device;
+					return true;
+				}
+			}
+			std::cout << std::endl;
+		}
+		return false;
+	}
+
+	void uploadModel(const ModelData& aModel) override
+	{
+		modelWidth_ = aModel.width_;
+		gridElements_ = aModel.elements();
+		gridByteSize_ = (gridElements_ * sizeof(float));
+
+		globalws_ = cl::NDRange(aModel.width_, aModel.height_);
+		localws_ = cl::NDRange(32, 32);						//@ToDo - CHANGE TO OPTIMIZED GROUP SIZE.
+
+		initBuffersCL(aModel);
+		createExplicitEquation(aModel.kernelSource_);
+	}
+
+	//Non-blocking rectangular writes of the edited rows only - Queued ahead of the next block's steps like setOutputCell//
+	void updateModelRegion(const ModelData& aModel, const ModelRegion& aRegion) override
+	{
+		const cl::array<cl::size_type, 3> origin = { aRegion.x_ * sizeof(float), (cl::size_type)aRegion.y_, 0 };
+		const cl::array<cl::size_type, 3> region = { aRegion.width_ * sizeof(float), (cl::size_type)aRegion.height_, 1 };
+		const cl::size_type rowPitch = modelWidth_ * sizeof(float);
+		commandQueue_.enqueueWriteBufferRect(idGrid_, CL_FALSE, origin, origin, region, rowPitch, 0, rowPitch, 0, aModel.idGrid_.data());
+		commandQueue_.enqueueWriteBufferRect(boundaryGridBuffer_, CL_FALSE, origin, origin, region, rowPitch, 0, rowPitch, 0, aModel.boundaryGrid_.data());
+	}
+
+	//Called off the audio thread - Touches the context and the queue, both thread safe in OpenCL 1.2//
+	BlockResources* createBlockResources(uint32_t aMaxBlockSize, uint32_t aMaxExcitationPoints) override
+	{
+		OpenCLBlockResources* resources = new OpenCLBlockResources();
+		resources->stride_ = aMaxBlockSize;
+		std::vector<float> zeros(aMaxBlockSize * aMaxExcitationPoints, 0.0);
+		resources->outputBuffer_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, aMaxBlockSize * sizeof(float), zeros.data());
+
+		//Excitation rows over zeroed, page aligned host memory the buffer is created on. While mapped the renderers write
+		//straight into it - Unmapping hands it to the device, which on shared memory parts reads it where it is and
+		//otherwise is the one transfer. Drivers that map elsewhere fall back to copying the host rows in//
+		resources->stagingBytes_ = zeros.size() * sizeof(float);
+		resources->staging_.reserve(EngineArena::footprint<float>(zeros.size()));
+		resources->stagingRows_ = resources->staging_.allocate<float>(zeros.size());
+		resources->excitationBuffer_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, resources->stagingBytes_, resources->stagingRows_, &errorStatus_);
+		void* mapped = errorStatus_ == CL_SUCCESS ? commandQueue_.enqueueMapBuffer(resources->excitationBuffer_, CL_TRUE, CL_MAP_WRITE, 0, resources->stagingBytes_) : nullptr;
+		if (mapped != nullptr && mapped == resources->stagingRows_)
+		{
+			resources->mapped_ = true;
+			resources->excitation_ = resources->stagingRows_;
+		}
+		else
+		{
+			if (mapped != nullptr)
+				commandQueue_.enqueueUnmapMemObject(resources->excitationBuffer_, mapped);
+			resources->stagingRows_ = nullptr;
+			resources->staging_.reserve(0);
+			resources->excitationBuffer_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, resources->stagingBytes_, zeros.data());
+		}
+		resources->silentBuffer_ = cl::Buffer(context_, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, aMaxBlockSize * sizeof(float), zeros.data());
+		resources->positionBuffer_ = cl::Buffer(context_, CL_MEM_READ_ONLY, aMaxExcitationPoints * sizeof(int));
+		return resources;
+	}
+
+	void processBlock(BlockResources& aResources, ExcitationBlock& excitation, float* output, uint32_t numSteps)
+	{
+		OpenCLBlockResources& resources = static_cast<OpenCLBlockResources&>(aResources);
+		const uint32_t active = excitation.length_ < numSteps ? excitation.length_ : numSteps;
+
+		//Rows rendered into the mapped staging - Possibly a chunk further along it - Are already where the device reads
+		//them. Only the positions are written, non-blocking as the readback below waits on them//
+		const bool inPlace = resources.stagingRows_ != nullptr && excitation.stride_ == resources.stride_ &&
+			excitation.samples_ >= resources.stagingRows_ && excitation.samples_ < resources.stagingRows_ + resources.stride_;
+		const int offset = inPlace ? (int)(excitation.samples_ - resources.stagingRows_) : 0;
+		//A silent block rendered in place leaves the rows zero and runs no excitation - The device never reads them, so
+		//they stay mapped and the block pays no unmap or map at all//
+		const bool deviceReadsRows = !inPlace || (active != 0 && excitation.points_ != 0);
+		if (resources.mapped_ && deviceReadsRows)
+		{
+			DeadlineMonitor::ScopedPhase phase(deadlineMonitor_, PHASE_UPLOAD);
+			commandQueue_.enqueueUnmapMemObject(resources.excitationBuffer_, resources.stagingRows_);
+			resources.mapped_ = false;
+		}
+		if (inPlace)
+		{
+			if (excitation.points_ != 0)
+				commandQueue_.enqueueWriteBuffer(resources.positionBuffer_, CL_FALSE, 0, excitation.points_ * sizeof(int), excitation.positions_);
+		}
+		else
+		{
+			//Load excitation into GPU - One rectangular write of the span that is or was non-zero across all points, nothing
+			//at all once every burst is over. A change in point count rewrites the whole block so stale rows are cleared//
+			uint32_t upload = std::min(numSteps, std::max(active, resources.uploadedLength_));
+			if (excitation.points_ != resources.uploadedPoints_)
+				upload = numSteps;
+			if (upload != 0 && excitation.points_ != 0)
+			{
+				DeadlineMonitor::ScopedPhase phase(deadlineMonitor_, PHASE_UPLOAD);
+				const cl::array<cl::size_type, 3> origin = { 0, 0, 0 };
+				const cl::array<cl::size_type, 3> region = { upload * sizeof(float), excitation.points_, 1 };
+				commandQueue_.enqueueWriteBufferRect(resources.excitationBuffer_, CL_TRUE, origin, origin, region,
+					resources.stride_ * sizeof(float), 0, excitation.stride_ * sizeof(float), 0, excitation.samples_);
+				commandQueue_.enqueueWriteBuffer(resources.positionBuffer_, CL_TRUE, 0, excitation.points_ * sizeof(int), excitation.positions_);
+			}
+			resources.uploadedLength_ = active;
+			resources.uploadedPoints_ = excitation.points_;
+			for (uint32_t p = 0; p != excitation.points_; ++p)
+				memset(excitation.samples_ + p * excitation.stride_, 0, active * sizeof(float));
+		}
+
+		kernel_.setArg(5, sizeof(cl_mem), &resources.silentBuffer_);
+		kernel_.setArg(6, sizeof(cl_mem), &resources.outputBuffer_);
+		const int points = (int)excitation.points_;
+		const int stride = (int)resources.stride_;
+		exciteKernel_.setArg(1, sizeof(cl_mem), &resources.excitationBuffer_);
+		exciteKernel_.setArg(2, sizeof(cl_mem), &resources.positionBuffer_);
+		exciteKernel_.setArg(3, sizeof(int), &points);
+		exciteKernel_.setArg(4, sizeof(int), &stride);
+		exciteKernel_.setArg(8, sizeof(int), &offset);
+
+		//Calculate buffer size of synthesizer output samples - Host time to enqueue, the device runs behind//
+		const bool tracing = deviceTrace_ != nullptr && TraceRecorder::get().isEnabled();
+		{
+			DeadlineMonitor::ScopedPhase phase(deadlineMonitor_, PHASE_STEPS);
+			for (unsigned int i = 0; i != numSteps; ++i)
+			{
+				//Increments kernel indices//
+				kernel_.setArg(4, sizeof(int), &bufferIndex_);
+				kernel_.setArg(3, sizeof(int), &bufferRotationIndex_);
+
+				const bool excite = i < active && points != 0;
+				if (excite)
+				{
+					exciteKernel_.setArg(5, sizeof(int), &bufferIndex_);
+					exciteKernel_.setArg(6, sizeof(int), &bufferRotationIndex_);
+				}
+				step(excite, tracing && i == 0 ? &firstStepEvent_ : NULL, tracing && i + 1 == numSteps ? &lastStepEvent_ : NULL);
+			}
+		}
+
+		bufferIndex_ = 0;
+
+		//Steps are done with the staging - Mapped back for the next block's renderers. Queued ahead of the readback so its
+		//wait covers the map too, and invalidating as the host rewrites every row it hands out//
+		const bool remap = !resources.mapped_ && resources.stagingRows_ != nullptr && resources.excitation_ == resources.stagingRows_;
+		if (remap)
+			commandQueue_.enqueueMapBuffer(resources.excitationBuffer_, CL_FALSE, CL_MAP_WRITE_INVALIDATE_REGION, 0, resources.stagingBytes_, NULL, &resources.mapEvent_);
+
+		//Blocking - Waits out every step still queued on the device//
+		DeadlineMonitor::ScopedPhase phase(deadlineMonitor_, PHASE_READBACK);
+		commandQueue_.enqueueReadBuffer(resources.outputBuffer_, CL_TRUE, 0, numSteps * sizeof(float), output, NULL, tracing ? &readbackEvent_ : NULL);
+		if (tracing && numSteps != 0)
+			traceDeviceBlock(TraceRecorder::now());
+		//Cleared device side, queued ahead of the next block's steps - No host zeros to keep or wait on//
+		commandQueue_.enqueueFillBuffer(resources.outputBuffer_, 0.0f, 0, numSteps * sizeof(float));
+
+		//Already complete on an in order queue. The map hands back the host rows as they were written, over which the
+		//spans just read are cleared//
+		if (remap)
+		{
+			resources.mapEvent_.wait();
+			resources.mapped_ = true;
+			if (inPlace)
+			{
+				for (uint32_t p = 0; p != excitation.points_; ++p)
+					memset(excitation.samples_ + p * excitation.stride_, 0, active * sizeof(float));
+			}
+		}
+	}
+
+	void readFieldSnapshot(float* aField) override
+	{
+		commandQueue_.enqueueReadBuffer(modelGrid_, CL_TRUE, bufferRotationIndex_ * gridByteSize_, gridByteSize_, aField);
+	}
+	//Non-blocking read queued behind the block's kernels - The event callback marks the slot complete//
+	void requestFieldSnapshot(FieldSnapshot& aSlot) override
+	{
+		aSlot.requested_.fetch_add(1, std::memory_order_relaxed);
+		commandQueue_.enqueueReadBuffer(modelGrid_, CL_FALSE, bufferRotationIndex_ * gridByteSize_, gridByteSize_, aSlot.field_, NULL, &snapshotEvent_);
+		snapshotEvent_.setCallback(CL_COMPLETE, &snapshotComplete, &aSlot);
+		commandQueue_.flush();
+	}
+
+	void setDisplayFormat(const DisplayFormat& aFormat) override
+	{
+		display_ = aFormat;
+		if (!display_.isEnabled())
+			return;
+		if (displayKernel_() == NULL)
+		{
+			buildProgram(displayProgram_, displayKernelSource, "", std::vector<unsigned char>());
+			displayKernel_ = cl::Kernel(displayProgram_, "displayKernel", &errorStatus_);
+			if (errorStatus_)
+				std::cout << "ERROR building OpenCL display kernel. Status code: " << errorStatus_ << std::endl;
+		}
+		pixelBuffer_ = cl::Buffer(context_, CL_MEM_WRITE_ONLY, display_.bytes());
+		displayKernel_.setArg(1, sizeof(cl_mem), &pixelBuffer_);
+		displayKernel_.setArg(3, sizeof(int), &display_.fieldWidth_);
+		displayKernel_.setArg(4, sizeof(int), &display_.fieldHeight_);
+		displayKernel_.setArg(5, sizeof(float), &display_.gain_);
+	}
+	//Downsampled and coloured on the device, queued behind the block's kernels - Only the pixels are read back, without
+	//blocking, and the event callback marks the slot complete//
+	void requestDisplaySnapshot(FieldSnapshot& aSlot) override
+	{
+		aSlot.coloured_ = true;
+		aSlot.requested_.fetch_add(1, std::memory_order_relaxed);
+		displayKernel_.setArg(0, sizeof(cl_mem), &modelGrid_);
+		displayKernel_.setArg(2, sizeof(int), &bufferRotationIndex_);
+		commandQueue_.enqueueNDRangeKernel(displayKernel_, cl::NullRange, cl::NDRange(display_.width_, display_.height_), cl::NullRange);
+		commandQueue_.enqueueReadBuffer(pixelBuffer_, CL_FALSE, 0, display_.bytes(), aSlot.pixels_, NULL, &snapshotEvent_);
+		snapshotEvent_.setCallback(CL_COMPLETE, &snapshotComplete, &aSlot);
+		commandQueue_.flush();
+	}
+
+	//Queued ahead of the next block's steps//
+	void clearField() override
+	{
+		commandQueue_.enqueueFillBuffer(modelGrid_, 0.0f, 0, gridByteSize_ * 3);
+	}
+
+	void setCoefficient(uint32_t aIndex, float aValue) override
+	{
+		kernel_.setArg(aIndex, sizeof(float), &aValue);	//@ToDo - Need dynamicaly find index for setArg (The first param)
+	}
+	void setOutputGrid(const int* aOutputGrid) override
+	{
+		commandQueue_.enqueueWriteBuffer(outputPositionBuffer_, CL_TRUE, 0, gridByteSize_, aOutputGrid);
+		kernel_.setArg(8, sizeof(cl_mem), &outputPositionBuffer_);
+	}
+	//Non-blocking - Queued ahead of the next block's steps, whose blocking readback also waits out the write//
+	void setOutputCell(const int* aOutputGrid, int aPosition) override
+	{
+		commandQueue_.enqueueWriteBuffer(outputPositionBuffer_, CL_FALSE, aPosition * sizeof(int), sizeof(int), aOutputGrid + aPosition);
+	}
+
+	const char* getName() const override
+	{
+		return "OpenCL";
+	}
+
+	std::string getDeviceSignature() const override
+	{
+		//The cached binary bundles the excitation program, which no model carries - FNV-1a of its source//
+		uint32_t hash = 2166136261u;
+		for (const char* c = exciteKernelSource; *c != 0; ++c)
+			hash = (hash ^ (unsigned char)*c) * 16777619u;
+		char excite[24];
+		snprintf(excite, sizeof(excite), "|excite:%08x", hash);
+		return std::string(getName()) + "|" + platform_.getInfo<CL_PLATFORM_NAME>() + "|" + device_.getInfo<CL_DEVICE_NAME>() + "|" +
+			device_.getInfo<CL_DEVICE_VERSION>() + "|" + device_.getInfo<CL_DRIVER_VERSION>() + "|" + modelProgramOptions + excite;
+	}
+	//Model program then excitation program, each behind its byte count//
+	void setProgramBinary(const std::vector<unsigned char>& aBinary) override
+	{
+		cachedModelProgram_.clear();
+		cachedExciteProgram_.clear();
+		std::vector<unsigned char>* programs[2] = { &cachedModelProgram_, &cachedExciteProgram_ };
+		size_t offset = 0;
+		for (std::vector<unsigned char>* program : programs)
+		{
+			uint64_t bytes = 0;
+			if (aBinary.size() - offset < sizeof(bytes))
+				break;
+			memcpy(&bytes, aBinary.data() + offset, sizeof(bytes));
+			offset += sizeof(bytes);
+			if (aBinary.size() - offset < bytes)
+				break;
+			program->assign(aBinary.begin() + offset, aBinary.begin() + offset + (size_t)bytes);
+			offset += (size_t)bytes;
+		}
+	}
+	bool getProgramBinary(std::vector<unsigned char>& aBinary) override
+	{
+		aBinary.clear();
+		const cl::Program* programs[2] = { &kernelProgram_, &exciteProgram_ };
+		for (const cl::Program* program : programs)
+		{
+			const cl::Program::Binaries binaries = program->getInfo<CL_PROGRAM_BINARIES>();
+			if (binaries.size() != 1 || binaries[0].empty())
+				return false;
+			const uint64_t bytes = binaries[0].size();
+			aBinary.insert(aBinary.end(), (const unsigned char*)&bytes, (const unsigned char*)&bytes + sizeof(bytes));
+			aBinary.insert(aBinary.end(), binaries[0].begin(), binaries[0].end());
+		}
+		return true;
+	}
+};
+
+#endif
@@ -0,0 +1,832 @@
+#ifndef FDTD_BACKEND_VULKAN_HPP
+#define FDTD_BACKEND_VULKAN_HPP
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include <vulkan/vulkan.h>
+
+#include "FDTD_Backend.hpp"
+//Generated from fdtd.comp by the pre-build step - glslangValidator -V --vn fdtdShaderSpirv (see README.md)//
+#include "shaders/vulkan/fdtd.comp.spv.h"
+
+//Vulkan compute implementation of the twin-membrane update (shaders/vulkan/fdtd.comp). A whole audio block of time steps
+//is recorded into one command buffer - Update dispatch, barrier, pickup dispatch, barrier per step - so the host pays one
+//submit and one fence wait per block. The buffer is recorded once for the longest block with indirect dispatches, and a
+//shorter block zeroes the group counts of the steps it skips; rotation, positions and coefficients live in a uniform
+//buffer written before each submit, so rate conversion and event splits never re-record.
+//Each BlockResources owns its excitation/output buffers, descriptor set, command pool and recording, so a new set can be
+//built on another thread and swapped in without touching anything the audio thread is using.
+//Only the twin-membrane update is implemented - A model's kernelSource_ is not compiled, so models whose physics_kernel
+//is anything else need the OpenCL backend. The SPIR-V is compiled into the binary, so nothing is loaded at run time.
+//Tools/Backend_Check.cpp compares it against the CPU and OpenCL backends on whichever Vulkan driver is installed.
+//Set FDTD_VULKAN_DEVICE to a substring of the device name (e.g. "llvmpipe") to pick a specific device.
+class FDTD_Backend_Vulkan final : public FDTD_Backend
+{
+private:
+	struct Params
+	{
+		int32_t width;
+		int32_t height;
+		int32_t rotationBase;
+		int32_t excitationPoints;
+		int32_t excitationStride;
+		int32_t excitationLength;
+		int32_t excitationOffset;	//Start of the block within each row.
+		int32_t numOutputCells;
+		float muOne;
+		float lambdaOne;
+		float lambdaTwo;
+		float muTwo;
+	};
+	struct PushConstants
+	{
+		int32_t step;
+		int32_t stage;
+	};
+	struct DeviceBuffer
+	{
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		void* mapped = nullptr;
+		VkDeviceSize size = 0;
+	};
+	struct VulkanBlockResources : public BlockResources
+	{
+		FDTD_Backend_Vulkan* owner_ = nullptr;
+		DeviceBuffer excitationBuffer_;	//maxExcitationPoints_ rows of stride_ samples, mapped as the base excitation_.
+		DeviceBuffer positions_;
+		DeviceBuffer output_;
+		uint32_t stride_ = 0;
+		VkDescriptorPool descriptorPool_ = VK_NULL_HANDLE;
+		VkDescriptorSet descriptorSet_ = VK_NULL_HANDLE;
+		VkCommandPool commandPool_ = VK_NULL_HANDLE;
+		VkCommandBuffer blockCommands_ = VK_NULL_HANDLE;	//Recorded once for stride_ steps.
+		DeviceBuffer dispatches_;		//Update and pickup group counts per step - Zero past the block's length.
+		uint32_t dispatchedSteps_ = 0;
+		uint32_t uploadedLength_ = 0;	//Leading span of excitationBuffer_ that may still be non-zero.
+		uint32_t uploadedPoints_ = 0;
+
+		~VulkanBlockResources()
+		{
+			if (owner_)
+				owner_->destroyBlockResources(*this);
+		}
+	};
+
+	const uint32_t localSize_ = 16;
+
+	VkInstance instance_ = VK_NULL_HANDLE;
+	VkPhysicalDevice physicalDevice_ = VK_NULL_HANDLE;
+	VkDevice device_ = VK_NULL_HANDLE;
+	VkQueue queue_ = VK_NULL_HANDLE;
+	uint32_t queueFamily_ = 0;
+	VkPhysicalDeviceMemoryProperties memoryProperties_;
+
+	VkDescriptorSetLayout descriptorSetLayout_ = VK_NULL_HANDLE;
+	VkPipelineLayout pipelineLayout_ = VK_NULL_HANDLE;
+	VkShaderModule shaderModule_ = VK_NULL_HANDLE;
+	VkPipeline pipeline_ = VK_NULL_HANDLE;
+	VkPipelineCache pipelineCache_ = VK_NULL_HANDLE;
+	std::vector<unsigned char> cachedPipeline_;		//Pipeline cache data offered by the model cache - The driver validates it.
+	VkCommandPool commandPool_ = VK_NULL_HANDLE;	//Model uploads and snapshots only.
+	VkCommandBuffer snapshotCommands_ = VK_NULL_HANDLE;
+	VkFence fence_ = VK_NULL_HANDLE;
+
+	//Snapshot slots - One host visible grid per engine slot, with a copy from each of the three rotating grids recorded
+	//into it when the model is uploaded. A requested copy is submitted without a fence and completed by the next wait//
+	static const uint32_t NUM_SNAPSHOTS = 3;
+	DeviceBuffer snapshotFields_[NUM_SNAPSHOTS];
+	VkCommandBuffer snapshotCopies_[NUM_SNAPSHOTS][3] = {};
+	FieldSnapshot* pendingSnapshots_[NUM_SNAPSHOTS] = {};
+	uint32_t pendingCopies_[NUM_SNAPSHOTS] = {};
+
+	//Buffers - Bindings 0 to 6 of fdtd.comp, excitation (2), output (3) and positions (6) live in the block resources.
+	//The update never reads the boundary grid, so it stays on the host//
+	static const uint32_t NUM_BINDINGS = 7;
+	static const uint32_t PARAMS_BINDING = 5;
+	DeviceBuffer idGrid_;
+	DeviceBuffer modelGrid_;
+	DeviceBuffer outputCells_;
+	DeviceBuffer params_;
+	DeviceBuffer snapshot_;
+	DeviceBuffer regionStaging_;				//Edited rows of ids for updateModelRegion. Host visible.
+	std::vector<VkBufferCopy> regionCopies_;	//One per edited row, reserved for the full height.
+
+	//Model//
+	int modelWidth_ = 0;
+	int modelHeight_ = 0;
+	int gridElements_ = 0;
+	Params* paramsMapped_ = nullptr;
+
+	bool check(VkResult aResult, const char* aWhat)
+	{
+		if (aResult != VK_SUCCESS)
+		{
+			std::cout << "ERROR Vulkan " << aWhat << ". Status code: " << aResult << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	int findMemoryType(uint32_t aTypeBits, VkMemoryPropertyFlags aFlags)
+	{
+		for (uint32_t i = 0; i != memoryProperties_.memoryTypeCount; ++i)
+			if ((aTypeBits & (1u << i)) && (memoryProperties_.memoryTypes[i].propertyFlags & aFlags) == aFlags)
+				return i;
+		return -1;
+	}
+
+	//Host visible buffers stay mapped for their lifetime. Device local is preferred for grids but not required, lavapipe
+	//only exposes host visible memory.
+	bool createBuffer(DeviceBuffer& aBuffer, VkDeviceSize aSize, VkBufferUsageFlags aUsage, bool aHostVisible)
+	{
+		destroyBuffer(aBuffer);
+
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = aSize;
+		bufferInfo.usage = aUsage;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		if (!check(vkCreateBuffer(device_, &bufferInfo, nullptr, &aBuffer.buffer), "creating buffer"))
+			return false;
+
+		VkMemoryRequirements requirements;
+		vkGetBufferMemoryRequirements(device_, aBuffer.buffer, &requirements);
+
+		int memoryType = -1;
+		if (aHostVisible)
+			memoryType = findMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		else
+		{
+			memoryType = findMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			if (memoryType < 0)
+				memoryType = findMemoryType(requirements.memoryTypeBits, 0);
+		}
+		if (memoryType < 0)
+		{
+			std::cout << "ERROR Vulkan no suitable memory type." << std::endl;
+			return false;
+		}
+
+		VkMemoryAllocateInfo allocateInfo = {};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocateInfo.allocationSize = requirements.size;
+		allocateInfo.memoryTypeIndex = memoryType;
+		if (!check(vkAllocateMemory(device_, &allocateInfo, nullptr, &aBuffer.memory), "allocating memory"))
+			return false;
+		vkBindBufferMemory(device_, aBuffer.buffer, aBuffer.memory, 0);
+
+		if (aHostVisible)
+			vkMapMemory(device_, aBuffer.memory, 0, aSize, 0, &aBuffer.mapped);
+		aBuffer.size = aSize;
+		return true;
+	}
+	void destroyBuffer(DeviceBuffer& aBuffer)
+	{
+		if (aBuffer.mapped)
+			vkUnmapMemory(device_, aBuffer.memory);
+		if (aBuffer.buffer)
+			vkDestroyBuffer(device_, aBuffer.buffer, nullptr);
+		if (aBuffer.memory)
+			vkFreeMemory(device_, aBuffer.memory, nullptr);
+		aBuffer = DeviceBuffer();
+	}
+
+	//Uploads through a temporary staging buffer so device local grids work on discrete GPUs//
+	void uploadBuffer(DeviceBuffer& aBuffer, const void* aData, VkDeviceSize aSize)
+	{
+		DeviceBuffer staging;
+		createBuffer(staging, aSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, true);
+		memcpy(staging.mapped, aData, aSize);
+
+		VkCommandBuffer commands = beginOneShot();
+		VkBufferCopy region = { 0, 0, aSize };
+		vkCmdCopyBuffer(commands, staging.buffer, aBuffer.buffer, 1, &region);
+		endOneShot(commands);
+
+		destroyBuffer(staging);
+	}
+	VkCommandBuffer beginOneShot()
+	{
+		VkCommandBufferAllocateInfo allocateInfo = {};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.commandPool = commandPool_;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocateInfo.commandBufferCount = 1;
+		VkCommandBuffer commands;
+		vkAllocateCommandBuffers(device_, &allocateInfo, &commands);
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(commands, &beginInfo);
+		return commands;
+	}
+	void endOneShot(VkCommandBuffer aCommands)
+	{
+		vkEndCommandBuffer(aCommands);
+		submitAndWait(aCommands);
+		vkFreeCommandBuffers(device_, commandPool_, 1, &aCommands);
+	}
+	void submitAndWait(VkCommandBuffer aCommands)
+	{
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &aCommands;
+		vkResetFences(device_, 1, &fence_);
+		vkQueueSubmit(queue_, 1, &submitInfo, fence_);
+		vkWaitForFences(device_, 1, &fence_, VK_TRUE, UINT64_MAX);
+		completeSnapshots();
+	}
+	//Everything submitted ahead of a waited fence has finished, snapshot copies included//
+	void completeSnapshots()
+	{
+		for (uint32_t i = 0; i != NUM_SNAPSHOTS; ++i)
+		{
+			if (pendingSnapshots_[i] == nullptr)
+				continue;
+			pendingSnapshots_[i]->completed_.fetch_add(pendingCopies_[i], std::memory_order_release);
+			pendingSnapshots_[i] = nullptr;
+			pendingCopies_[i] = 0;
+		}
+	}
+
+	//Copies of grid g into snapshot slot s, ordered after the steps that wrote it and made visible to host reads//
+	void recordSnapshotCopies()
+	{
+		const VkDeviceSize gridByteSize = gridElements_ * sizeof(float);
+		VkMemoryBarrier before = {};
+		before.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		before.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		before.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		VkMemoryBarrier after = {};
+		after.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		after.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		after.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		for (uint32_t s = 0; s != NUM_SNAPSHOTS; ++s)
+		{
+			for (uint32_t g = 0; g != 3; ++g)
+			{
+				VkCommandBuffer commands = snapshotCopies_[s][g];
+				vkResetCommandBuffer(commands, 0);
+				VkCommandBufferBeginInfo beginInfo = {};
+				beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+				vkBeginCommandBuffer(commands, &beginInfo);
+				vkCmdPipelineBarrier(commands, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &before, 0, nullptr, 0, nullptr);
+				VkBufferCopy region = { g * gridByteSize, 0, gridByteSize };
+				vkCmdCopyBuffer(commands, modelGrid_.buffer, snapshotFields_[s].buffer, 1, &region);
+				vkCmdPipelineBarrier(commands, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &after, 0, nullptr, 0, nullptr);
+				vkEndCommandBuffer(commands);
+			}
+		}
+	}
+
+	static void computeBarrier(VkCommandBuffer aCommands)
+	{
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(aCommands, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	//Records update/pickup pairs for the longest block the resources take, dispatched indirectly - A shorter block only
+	//zeroes the group counts of the steps it does not run, see setDispatchedSteps()//
+	void recordBlock(VulkanBlockResources& aResources)
+	{
+		VkCommandBuffer commands = aResources.blockCommands_;
+		vkResetCommandBuffer(commands, 0);
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		vkBeginCommandBuffer(commands, &beginInfo);
+
+		//A snapshot copy submitted since the last block may still be reading the grid the first step overwrites//
+		vkCmdPipelineBarrier(commands, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+		vkCmdBindPipeline(commands, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_);
+		vkCmdBindDescriptorSets(commands, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout_, 0, 1, &aResources.descriptorSet_, 0, nullptr);
+
+		for (uint32_t i = 0; i != aResources.stride_; ++i)
+		{
+			PushConstants update = { (int32_t)i, 0 };
+			vkCmdPushConstants(commands, pipelineLayout_, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &update);
+			vkCmdDispatchIndirect(commands, aResources.dispatches_.buffer, (2 * i) * sizeof(VkDispatchIndirectCommand));
+			computeBarrier(commands);
+
+			PushConstants pickup = { (int32_t)i, 1 };
+			vkCmdPushConstants(commands, pipelineLayout_, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &pickup);
+			vkCmdDispatchIndirect(commands, aResources.dispatches_.buffer, (2 * i + 1) * sizeof(VkDispatchIndirectCommand));
+			computeBarrier(commands);
+		}
+
+		vkEndCommandBuffer(commands);
+	}
+	//Writes group counts for the steps between the last block's length and this one's - Steps past aNumSteps dispatch
+	//nothing. Host writes are visible to the indirect reads at the next submit//
+	void setDispatchedSteps(VulkanBlockResources& aResources, uint32_t aNumSteps)
+	{
+		const VkDispatchIndirectCommand update = { (modelWidth_ + localSize_ - 1) / localSize_, (modelHeight_ + localSize_ - 1) / localSize_, 1 };
+		const VkDispatchIndirectCommand pickup = { 1, 1, 1 };
+		const VkDispatchIndirectCommand none = { 0, 0, 0 };
+		VkDispatchIndirectCommand* dispatches = (VkDispatchIndirectCommand*)aResources.dispatches_.mapped;
+		for (uint32_t i = std::min(aNumSteps, aResources.dispatchedSteps_); i != std::max(aNumSteps, aResources.dispatchedSteps_); ++i)
+		{
+			dispatches[2 * i] = i < aNumSteps ? update : none;
+			dispatches[2 * i + 1] = i < aNumSteps ? pickup : none;
+		}
+		aResources.dispatchedSteps_ = aNumSteps;
+	}
+
+	bool createPipeline()
+	{
+		VkShaderModuleCreateInfo moduleInfo = {};
+		moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		moduleInfo.codeSize = sizeof(fdtdShaderSpirv);
+		moduleInfo.pCode = fdtdShaderSpirv;
+		if (!check(vkCreateShaderModule(device_, &moduleInfo, nullptr, &shaderModule_), "creating shader module"))
+			return false;
+
+		VkDescriptorSetLayoutBinding bindings[NUM_BINDINGS] = {};
+		for (uint32_t i = 0; i != NUM_BINDINGS; ++i)
+		{
+			bindings[i].binding = i;
+			bindings[i].descriptorType = i == PARAMS_BINDING ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			bindings[i].descriptorCount = 1;
+			bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		}
+		VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.bindingCount = NUM_BINDINGS;
+		layoutInfo.pBindings = bindings;
+		if (!check(vkCreateDescriptorSetLayout(device_, &layoutInfo, nullptr, &descriptorSetLayout_), "creating descriptor set layout"))
+			return false;
+
+		VkPushConstantRange pushRange = { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants) };
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout_;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushRange;
+		if (!check(vkCreatePipelineLayout(device_, &pipelineLayoutInfo, nullptr, &pipelineLayout_), "creating pipeline layout"))
+			return false;
+
+		VkComputePipelineCreateInfo pipelineInfo = {};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		pipelineInfo.stage.module = shaderModule_;
+		pipelineInfo.stage.pName = "main";
+		pipelineInfo.layout = pipelineLayout_;
+
+		//Seeded from the model cache when it had data for this device - Drivers ignore data from another device or version//
+		VkPipelineCacheCreateInfo cacheInfo = {};
+		cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		cacheInfo.initialDataSize = cachedPipeline_.size();
+		cacheInfo.pInitialData = cachedPipeline_.empty() ? nullptr : cachedPipeline_.data();
+		if (!check(vkCreatePipelineCache(device_, &cacheInfo, nullptr, &pipelineCache_), "creating pipeline cache"))
+			pipelineCache_ = VK_NULL_HANDLE;
+		return check(vkCreateComputePipelines(device_, pipelineCache_, 1, &pipelineInfo, nullptr, &pipeline_), "creating compute pipeline");
+	}
+
+	void writeDescriptors(VulkanBlockResources& aResources)
+	{
+		DeviceBuffer* buffers[NUM_BINDINGS] = { &idGrid_, &modelGrid_, &aResources.excitationBuffer_, &aResources.output_, &outputCells_, &params_, &aResources.positions_ };
+		VkDescriptorBufferInfo bufferInfos[NUM_BINDINGS];
+		VkWriteDescriptorSet writes[NUM_BINDINGS] = {};
+		for (uint32_t i = 0; i != NUM_BINDINGS; ++i)
+		{
+			bufferInfos[i].buffer = buffers[i]->buffer;
+			bufferInfos[i].offset = 0;
+			bufferInfos[i].range = VK_WHOLE_SIZE;
+
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstSet = aResources.descriptorSet_;
+			writes[i].dstBinding = i;
+			writes[i].descriptorCount = 1;
+			writes[i].descriptorType = i == PARAMS_BINDING ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writes[i].pBufferInfo = &bufferInfos[i];
+		}
+		vkUpdateDescriptorSets(device_, NUM_BINDINGS, writes, 0, nullptr);
+	}
+
+	void destroyBlockResources(VulkanBlockResources& aResources)
+	{
+		destroyBuffer(aResources.excitationBuffer_);
+		destroyBuffer(aResources.positions_);
+		destroyBuffer(aResources.output_);
+		destroyBuffer(aResources.dispatches_);
+		vkDestroyCommandPool(device_, aResources.commandPool_, nullptr);
+		vkDestroyDescriptorPool(device_, aResources.descriptorPool_, nullptr);
+	}
+public:
+	~FDTD_Backend_Vulkan()
+	{
+		if (device_)
+		{
+			vkDeviceWaitIdle(device_);
+			DeviceBuffer* buffers[6] = { &idGrid_, &modelGrid_, &outputCells_, &params_, &snapshot_, &regionStaging_ };
+			for (int i = 0; i != 6; ++i)
+				destroyBuffer(*buffers[i]);
+			for (uint32_t i = 0; i != NUM_SNAPSHOTS; ++i)
+				destroyBuffer(snapshotFields_[i]);
+			vkDestroyFence(device_, fence_, nullptr);
+			vkDestroyCommandPool(device_, commandPool_, nullptr);
+			vkDestroyPipeline(device_, pipeline_, nullptr);
+			vkDestroyPipelineCache(device_, pipelineCache_, nullptr);
+			vkDestroyShaderModule(device_, shaderModule_, nullptr);
+			vkDestroyPipelineLayout(device_, pipelineLayout_, nullptr);
+			vkDestroyDescriptorSetLayout(device_, descriptorSetLayout_, nullptr);
+			vkDestroyDevice(device_, nullptr);
+		}
+		if (instance_)
+			vkDestroyInstance(instance_, nullptr);
+	}
+
+	bool init() override
+	{
+		VkApplicationInfo appInfo = {};
+		appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+		appInfo.pApplicationName = "FDTD_Accelerated";
+		appInfo.apiVersion = VK_API_VERSION_1_0;
+
+		VkInstanceCreateInfo instanceInfo = {};
+		instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+		instanceInfo.pApplicationInfo = &appInfo;
+		if (!check(vkCreateInstance(&instanceInfo, nullptr, &instance_), "creating instance"))
+			return false;
+
+		uint32_t deviceCount = 0;
+		vkEnumeratePhysicalDevices(instance_, &deviceCount, nullptr);
+		std::vector<VkPhysicalDevice> devices(deviceCount);
+		vkEnumeratePhysicalDevices(instance_, &deviceCount, devices.data());
+
+		//Prefer a requested device by name, then discrete, then anything with a compute queue (lavapipe is CPU type)//
+		const char* requested = getenv("FDTD_VULKAN_DEVICE");
+		int bestScore = -1;
+		for (size_t i = 0; i != devices.size(); ++i)
+		{
+			VkPhysicalDeviceProperties properties;
+			vkGetPhysicalDeviceProperties(devices[i], &properties);
+
+			uint32_t familyCount = 0;
+			vkGetPhysicalDeviceQueueFamilyProperties(devices[i], &familyCount, nullptr);
+			std::vector<VkQueueFamilyProperties> families(familyCount);
+			vkGetPhysicalDeviceQueueFamilyProperties(devices[i], &familyCount, families.data());
+
+			int family = -1;
+			for (uint32_t f = 0; f != familyCount; ++f)
+			{
+				if (families[f].queueFlags & VK_QUEUE_COMPUTE_BIT)
+				{
+					family = f;
+					break;
+				}
+			}
+			if (family < 0)
+				continue;
+
+			int score = 1;
+			if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+				score = 3;
+			else if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU)
+				score = 2;
+			if (requested && strstr(properties.deviceName, requested))
+				score = 10;
+
+			if (score > bestScore)
+			{
+				bestScore = score;
+				physicalDevice_ = devices[i];
+				queueFamily_ = family;
+			}
+		}
+		if (physicalDevice_ == VK_NULL_HANDLE)
+		{
+			std::cout << "ERROR no Vulkan device with a compute queue." << std::endl;
+			return false;
+		}
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
+		std::cout << "\t\tDevice Name Chosen: " << properties.deviceName << std::endl;
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice_, &memoryProperties_);
+
+		float priority = 1.0f;
+		VkDeviceQueueCreateInfo queueInfo = {};
+		queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+		queueInfo.queueFamilyIndex = queueFamily_;
+		queueInfo.queueCount = 1;
+		queueInfo.pQueuePriorities = &priority;
+
+		VkDeviceCreateInfo deviceInfo = {};
+		deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		deviceInfo.queueCreateInfoCount = 1;
+		deviceInfo.pQueueCreateInfos = &queueInfo;
+		if (!check(vkCreateDevice(physicalDevice_, &deviceInfo, nullptr, &device_), "creating device"))
+			return false;
+		vkGetDeviceQueue(device_, queueFamily_, 0, &queue_);
+
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolInfo.queueFamilyIndex = queueFamily_;
+		if (!check(vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool_), "creating command pool"))
+			return false;
+
+		VkCommandBufferAllocateInfo allocateInfo = {};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.commandPool = commandPool_;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocateInfo.commandBufferCount = 1;
+		vkAllocateCommandBuffers(device_, &allocateInfo, &snapshotCommands_);
+		allocateInfo.commandBufferCount = NUM_SNAPSHOTS * 3;
+		vkAllocateCommandBuffers(device_, &allocateInfo, &snapshotCopies_[0][0]);
+
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		vkCreateFence(device_, &fenceInfo, nullptr, &fence_);
+		return true;
+	}
+
+	//The pipeline is created with the first model so the model cache can seed it//
+	void uploadModel(const ModelData& aModel) override
+	{
+		if (pipeline_ == VK_NULL_HANDLE && !createPipeline())
+			return;
+		//Snapshot copies from the previous model may still be queued//
+		vkQueueWaitIdle(queue_);
+		completeSnapshots();
+
+		modelWidth_ = aModel.width_;
+		modelHeight_ = aModel.height_;
+		gridElements_ = aModel.elements();
+
+		const VkDeviceSize gridByteSize = gridElements_ * sizeof(float);
+		const VkBufferUsageFlags storage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		createBuffer(idGrid_, gridByteSize, storage, false);
+		createBuffer(modelGrid_, gridByteSize * 3, storage, false);
+		createBuffer(outputCells_, gridElements_ * sizeof(int32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true);
+		createBuffer(params_, sizeof(Params), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, true);
+		createBuffer(snapshot_, gridByteSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, true);
+		createBuffer(regionStaging_, gridByteSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, true);
+		for (uint32_t i = 0; i != NUM_SNAPSHOTS; ++i)
+			createBuffer(snapshotFields_[i], gridByteSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, true);
+		recordSnapshotCopies();
+		regionCopies_.clear();
+		regionCopies_.reserve(modelHeight_);
+
+		std::vector<float> temporaryGrid(gridElements_ * 3, 0.0);
+		uploadBuffer(idGrid_, aModel.idGrid_.data(), gridByteSize);
+		uploadBuffer(modelGrid_, temporaryGrid.data(), gridByteSize * 3);
+
+		paramsMapped_ = (Params*)params_.mapped;
+		memset(paramsMapped_, 0, sizeof(Params));
+		paramsMapped_->width = modelWidth_;
+		paramsMapped_->height = modelHeight_;
+		paramsMapped_->rotationBase = 1;
+		setOutputGrid(aModel.outputGrid_.data());
+	}
+
+	//The edited rows are packed into the staging buffer and copied row by row in one submission//
+	void updateModelRegion(const ModelData& aModel, const ModelRegion& aRegion) override
+	{
+		const VkDeviceSize rowBytes = aRegion.width_ * sizeof(int32_t);
+		unsigned char* staging = (unsigned char*)regionStaging_.mapped;
+		VkDeviceSize offset = 0;
+		regionCopies_.clear();
+		for (int y = aRegion.y_; y != aRegion.y_ + aRegion.height_; ++y)
+		{
+			const VkDeviceSize cell = ((VkDeviceSize)y * modelWidth_ + aRegion.x_) * sizeof(int32_t);
+			memcpy(staging + offset, (const unsigned char*)aModel.idGrid_.data() + cell, rowBytes);
+			VkBufferCopy copy = { offset, cell, rowBytes };
+			regionCopies_.push_back(copy);
+			offset += rowBytes;
+		}
+
+		vkResetCommandBuffer(snapshotCommands_, 0);
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(snapshotCommands_, &beginInfo);
+		vkCmdCopyBuffer(snapshotCommands_, regionStaging_.buffer, idGrid_.buffer, aRegion.height_, regionCopies_.data());
+		vkEndCommandBuffer(snapshotCommands_);
+		submitAndWait(snapshotCommands_);
+	}
+
+	//Called off the audio thread - Own pools so nothing here needs external synchronisation with processBlock//
+	BlockResources* createBlockResources(uint32_t aMaxBlockSize, uint32_t aMaxExcitationPoints) override
+	{
+		VulkanBlockResources* resources = new VulkanBlockResources();
+		resources->owner_ = this;
+		resources->stride_ = aMaxBlockSize;
+		createBuffer(resources->excitationBuffer_, aMaxBlockSize * aMaxExcitationPoints * sizeof(float), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true);
+		createBuffer(resources->positions_, aMaxExcitationPoints * sizeof(int32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true);
+		createBuffer(resources->output_, aMaxBlockSize * sizeof(float), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true);
+		memset(resources->excitationBuffer_.mapped, 0, aMaxBlockSize * aMaxExcitationPoints * sizeof(float));
+		resources->excitation_ = (float*)resources->excitationBuffer_.mapped;	//Renderers write straight into the device's rows.
+
+		VkDescriptorPoolSize poolSizes[2] = { { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, NUM_BINDINGS - 1 }, { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 } };
+		VkDescriptorPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.maxSets = 1;
+		poolInfo.poolSizeCount = 2;
+		poolInfo.pPoolSizes = poolSizes;
+		check(vkCreateDescriptorPool(device_, &poolInfo, nullptr, &resources->descriptorPool_), "creating descriptor pool");
+
+		VkDescriptorSetAllocateInfo setInfo = {};
+		setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		setInfo.descriptorPool = resources->descriptorPool_;
+		setInfo.descriptorSetCount = 1;
+		setInfo.pSetLayouts = &descriptorSetLayout_;
+		check(vkAllocateDescriptorSets(device_, &setInfo, &resources->descriptorSet_), "allocating descriptor set");
+		writeDescriptors(*resources);
+
+		VkCommandPoolCreateInfo commandPoolInfo = {};
+		commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		commandPoolInfo.queueFamilyIndex = queueFamily_;
+		check(vkCreateCommandPool(device_, &commandPoolInfo, nullptr, &resources->commandPool_), "creating command pool");
+
+		VkCommandBufferAllocateInfo allocateInfo = {};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.commandPool = resources->commandPool_;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocateInfo.commandBufferCount = 1;
+		vkAllocateCommandBuffers(device_, &allocateInfo, &resources->blockCommands_);
+
+		createBuffer(resources->dispatches_, 2 * aMaxBlockSize * sizeof(VkDispatchIndirectCommand), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, true);
+		memset(resources->dispatches_.mapped, 0, 2 * aMaxBlockSize * sizeof(VkDispatchIndirectCommand));
+		recordBlock(*resources);
+		return resources;
+	}
+
+	void processBlock(BlockResources& aResources, ExcitationBlock& excitation, float* output, uint32_t numSteps)
+	{
+		VulkanBlockResources& resources = static_cast<VulkanBlockResources&>(aResources);
+		if (numSteps != resources.dispatchedSteps_)
+			setDispatchedSteps(resources, numSteps);
+
+		//Excitation already in the mapped rows (rendered in place, possibly part way along them) is read where it is.
+		//Anything else has only the span that is or was non-zero copied - The mapped rows are otherwise already zero//
+		const uint32_t active = excitation.length_ < numSteps ? excitation.length_ : numSteps;
+		float* rows = (float*)resources.excitationBuffer_.mapped;
+		const bool inPlace = excitation.stride_ == resources.stride_ && excitation.samples_ >= rows && excitation.samples_ < rows + resources.stride_;
+		{
+			DeadlineMonitor::ScopedPhase phase(deadlineMonitor_, PHASE_UPLOAD);
+			if (!inPlace)
+			{
+				uint32_t upload = std::min(numSteps, std::max(active, resources.uploadedLength_));
+				if (excitation.points_ != resources.uploadedPoints_)
+					upload = numSteps;
+				for (uint32_t p = 0; p != excitation.points_; ++p)
+				{
+					memcpy(rows + p * resources.stride_, excitation.samples_ + p * excitation.stride_, upload * sizeof(float));
+					memset(excitation.samples_ + p * excitation.stride_, 0, active * sizeof(float));
+				}
+				resources.uploadedLength_ = active;
+				resources.uploadedPoints_ = excitation.points_;
+			}
+			memcpy(resources.positions_.mapped, excitation.positions_, excitation.points_ * sizeof(int32_t));
+		}
+
+		paramsMapped_->excitationPoints = excitation.points_;
+		paramsMapped_->excitationStride = resources.stride_;
+		paramsMapped_->excitationOffset = inPlace ? (int32_t)(excitation.samples_ - rows) : 0;
+		paramsMapped_->excitationLength = active;
+
+		{
+			DeadlineMonitor::ScopedPhase phase(deadlineMonitor_, PHASE_STEPS);
+			submitAndWait(resources.blockCommands_);
+		}
+		if (inPlace)
+		{
+			for (uint32_t p = 0; p != excitation.points_; ++p)
+				memset(excitation.samples_ + p * excitation.stride_, 0, active * sizeof(float));
+		}
+
+		DeadlineMonitor::ScopedPhase phase(deadlineMonitor_, PHASE_READBACK);
+		memcpy(output, resources.output_.mapped, numSteps * sizeof(float));
+		paramsMapped_->rotationBase = (paramsMapped_->rotationBase + numSteps) % 3;
+	}
+
+	void readFieldSnapshot(float* aField) override
+	{
+		const VkDeviceSize gridByteSize = gridElements_ * sizeof(float);
+
+		vkResetCommandBuffer(snapshotCommands_, 0);
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(snapshotCommands_, &beginInfo);
+		VkBufferCopy region = { paramsMapped_->rotationBase * gridByteSize, 0, gridByteSize };
+		vkCmdCopyBuffer(snapshotCommands_, modelGrid_.buffer, snapshot_.buffer, 1, &region);
+		vkEndCommandBuffer(snapshotCommands_);
+		submitAndWait(snapshotCommands_);
+
+		memcpy(aField, snapshot_.mapped, gridByteSize);
+	}
+
+	float* getSnapshotField(uint32_t aSlot) override
+	{
+		return aSlot < NUM_SNAPSHOTS ? (float*)snapshotFields_[aSlot].mapped : nullptr;
+	}
+	//Submits the copy recorded for the slot and the current grid without waiting - The slot completes with the next
+	//block. Slots the engine carved itself take the synchronous default//
+	void requestFieldSnapshot(FieldSnapshot& aSlot) override
+	{
+		uint32_t slot = 0;
+		while (slot != NUM_SNAPSHOTS && snapshotFields_[slot].mapped != aSlot.field_)
+			++slot;
+		if (slot == NUM_SNAPSHOTS)
+		{
+			FDTD_Backend::requestFieldSnapshot(aSlot);
+			return;
+		}
+
+		aSlot.requested_.fetch_add(1, std::memory_order_relaxed);
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &snapshotCopies_[slot][paramsMapped_->rotationBase];
+		vkQueueSubmit(queue_, 1, &submitInfo, VK_NULL_HANDLE);
+		pendingSnapshots_[slot] = &aSlot;
+		++pendingCopies_[slot];
+	}
+
+	void clearField() override
+	{
+		vkResetCommandBuffer(snapshotCommands_, 0);
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(snapshotCommands_, &beginInfo);
+		vkCmdFillBuffer(snapshotCommands_, modelGrid_.buffer, 0, VK_WHOLE_SIZE, 0);
+		vkEndCommandBuffer(snapshotCommands_);
+		submitAndWait(snapshotCommands_);
+	}
+
+	void setCoefficient(uint32_t aIndex, float aValue) override
+	{
+		switch (aIndex)
+		{
+		case 9: paramsMapped_->muOne = aValue; break;
+		case 10: paramsMapped_->lambdaOne = aValue; break;
+		case 11: paramsMapped_->lambdaTwo = aValue; break;
+		case 12: paramsMapped_->muTwo = aValue; break;
+		default: break;
+		}
+	}
+	void setOutputGrid(const int* aOutputGrid) override
+	{
+		int32_t* cells = (int32_t*)outputCells_.mapped;
+		int32_t count = 0;
+		for (int i = 0; i != gridElements_; ++i)
+			if (aOutputGrid[i])
+				cells[count++] = i;
+		paramsMapped_->numOutputCells = count;
+	}
+
+	const char* getName() const override
+	{
+		return "Vulkan";
+	}
+
+	std::string getDeviceSignature() const override
+	{
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
+		char signature[512];
+		int length = snprintf(signature, sizeof(signature), "%s|%s|%08x:%08x|%08x|", getName(), properties.deviceName, properties.vendorID,
+			properties.deviceID, properties.driverVersion);
+		for (uint32_t i = 0; i != 16; ++i)
+			length += snprintf(signature + length, sizeof(signature) - length, "%02x", properties.pipelineCacheUUID[i]);
+		//The pipeline is only valid for the shader it was built from - FNV-1a of the embedded SPIR-V//
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i != sizeof(fdtdShaderSpirv) / sizeof(fdtdShaderSpirv[0]); ++i)
+			hash = (hash ^ fdtdShaderSpirv[i]) * 16777619u;
+		snprintf(signature + length, sizeof(signature) - length, "|spirv:%08x", hash);
+		return signature;
+	}
+	void setProgramBinary(const std::vector<unsigned char>& aBinary) override
+	{
+		cachedPipeline_ = aBinary;
+	}
+	bool getProgramBinary(std::vector<unsigned char>& aBinary) override
+	{
+		size_t bytes = 0;
+		if (pipelineCache_ == VK_NULL_HANDLE || vkGetPipelineCacheData(device_, pipelineCache_, &bytes, nullptr) != VK_SUCCESS || bytes == 0)
+			return false;
+		aBinary.resize(bytes);
+		return vkGetPipelineCacheData(device_, pipelineCache_, &bytes, aBinary.data()) == VK_SUCCESS;
+	}
+};
+
+#endif
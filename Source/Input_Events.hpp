@@ -0,0 +1,52 @@
+#ifndef INPUT_EVENTS_HPP
+#define INPUT_EVENTS_HPP
+
+#include <stdint.h>
+#include <chrono>
+
+//Monotonic capture time in nanoseconds - Taken on the input thread when an event is read from its device//
+inline int64_t inputEventTime()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//A coefficient change stamped at capture. Applied between steps at the matching sample rather than whenever the message
+//thread gets to it//
+struct ParameterEvent
+{
+	int64_t time_;
+	uint32_t index_;		//fdtdKernel argument index, as updateCoefficient().
+	float value_;
+};
+
+//Maps capture times onto sample offsets within the block being rendered, at a fixed latency from capture to the sample
+//being heard - Sample accurate spacing instead of every event snapping to the next block boundary. A block is placed by
+//the samples queued ahead of it rather than by when it happens to be rendered, so the chunks of one callback and the
+//bursts of the simulation thread keep their events apart. The latency is the deepest queue seen plus the block, which
+//with nothing queued lands events captured during the previous block's period at the same relative position in this one.
+class BlockClock
+{
+private:
+	int64_t blockStart_ = 0;		//Capture time that maps to the block's first sample.
+	uint32_t latency_ = 0;			//Samples.
+	double sampleRate_ = 44100.0;
+public:
+	//aQueued is how many samples rendered before this block are not yet heard - Earlier chunks of the same callback, and
+	//on the simulation thread the ring's fill//
+	void beginBlock(double aSampleRate, uint32_t aNumSamples, uint32_t aQueued)
+	{
+		if (aQueued + aNumSamples > latency_)
+			latency_ = aQueued + aNumSamples;
+		sampleRate_ = aSampleRate;
+		blockStart_ = inputEventTime() - (int64_t)(((double)latency_ - aQueued) * 1e9 / aSampleRate);
+	}
+
+	//Samples from the current block's first to aTime, which may be past the block's end - Callers carry those into the
+	//chunk they fall in. Stale events are due at once//
+	uint32_t delayOf(int64_t aTime) const
+	{
+		return aTime > blockStart_ ? (uint32_t)((aTime - blockStart_) * sampleRate_ * 1e-9) : 0;
+	}
+};
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef LATENCY_MONITOR_HPP
+#define LATENCY_MONITOR_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include <ostream>
+
+#include "Input_Events.hpp"
+
+//Durations in fixed 100us bins up to 50ms, the last bin catching everything above. Recording is a couple of relaxed
+//atomic adds so any thread may record, including the audio thread; readers walk the counts without stopping it. A read
+//racing a record can be off by that one sample, which is fine for percentiles.
+class LatencyHistogram
+{
+public:
+	static const uint32_t NUM_BINS = 500;
+	static const uint32_t BIN_WIDTH_US = 100;
+private:
+	std::atomic<uint32_t> counts_[NUM_BINS];
+	std::atomic<uint64_t> total_;
+	std::atomic<int64_t> max_;
+public:
+	LatencyHistogram()
+	{
+		reset();
+	}
+
+	void record(int64_t aMicroseconds)
+	{
+		if (aMicroseconds < 0)
+			aMicroseconds = 0;
+		const uint64_t bin = (uint64_t)aMicroseconds / BIN_WIDTH_US;
+		counts_[bin < NUM_BINS ? bin : NUM_BINS - 1].fetch_add(1, std::memory_order_relaxed);
+		total_.fetch_add(1, std::memory_order_relaxed);
+
+		int64_t max = max_.load(std::memory_order_relaxed);
+		while (aMicroseconds > max && !max_.compare_exchange_weak(max, aMicroseconds, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	//Reader side - Not to be called while another thread is reading//
+	void reset()
+	{
+		for (uint32_t i = 0; i != NUM_BINS; ++i)
+			counts_[i].store(0, std::memory_order_relaxed);
+		total_.store(0, std::memory_order_relaxed);
+		max_.store(0, std::memory_order_relaxed);
+	}
+
+	uint64_t getCount() const
+	{
+		return total_.load(std::memory_order_relaxed);
+	}
+	//Upper edge of the bin holding the aFraction quantile, in milliseconds - 0 with no samples//
+	double getPercentile(double aFraction) const
+	{
+		const uint64_t total = getCount();
+		if (total == 0)
+			return 0.0;
+		const uint64_t target = (uint64_t)(aFraction * (total - 1)) + 1;
+		uint64_t seen = 0;
+		for (uint32_t i = 0; i != NUM_BINS; ++i)
+		{
+			seen += counts_[i].load(std::memory_order_relaxed);
+			if (seen >= target)
+				return (i + 1) * BIN_WIDTH_US / 1000.0;
+		}
+		return getMax();
+	}
+	double getMax() const
+	{
+		return max_.load(std::memory_order_relaxed) / 1000.0;
+	}
+};
+
+//Touch to sound latency, split at each hand-off so a slow response can be pinned on one stage:
+//	capture -> engine		Sensel frame read until the strike is taken by the thread rendering excitation.
+//	capture -> delivered	Until the block holding the onset is handed on towards the device.
+//	touch -> sound			Delivered plus the onset's offset in the block, anything queued ahead of it and the device's
+//							reported output latency - The figure a player hears.
+//Onsets are held only by the rendering thread between onsetApplied() and blockDelivered(), so nothing is shared but the
+//histograms and the device figures.
+class LatencyMonitor
+{
+private:
+	static const uint32_t MAX_ONSETS = 32;	//Per block - Further onsets in the same block are not timed.
+
+	struct Onset
+	{
+		int64_t capture_;
+		uint32_t offset_;
+	};
+
+	LatencyHistogram captureToEngine_;
+	LatencyHistogram captureToDelivered_;
+	LatencyHistogram touchToSound_;
+
+	Onset onsets_[MAX_ONSETS];
+	uint32_t onsetCount_ = 0;
+
+	std::atomic<uint32_t> outputLatency_;
+	std::atomic<uint32_t> sampleRate_;
+public:
+	LatencyMonitor() :
+		outputLatency_(0),
+		sampleRate_(44100)
+	{
+	}
+
+	//Device side figures - Called whenever the device (re)starts//
+	void setDeviceLatency(uint32_t aOutputLatencySamples, double aSampleRate)
+	{
+		outputLatency_.store(aOutputLatencySamples, std::memory_order_relaxed);
+		sampleRate_.store((uint32_t)aSampleRate, std::memory_order_relaxed);
+	}
+
+	//Rendering thread - A strike captured at aCapture starts aOffset samples into the block being rendered//
+	void onsetApplied(int64_t aCapture, uint32_t aOffset)
+	{
+		captureToEngine_.record((inputEventTime() - aCapture) / 1000);
+		if (onsetCount_ == MAX_ONSETS)
+			return;
+		onsets_[onsetCount_].capture_ = aCapture;
+		onsets_[onsetCount_].offset_ = aOffset;
+		++onsetCount_;
+	}
+	//Rendering thread - The block is finished and aQueuedSamples are waiting ahead of it before the device//
+	void blockDelivered(uint32_t aQueuedSamples = 0)
+	{
+		if (onsetCount_ == 0)
+			return;
+
+		const int64_t now = inputEventTime();
+		const double sampleRate = (double)sampleRate_.load(std::memory_order_relaxed);
+		const uint32_t ahead = outputLatency_.load(std::memory_order_relaxed) + aQueuedSamples;
+		for (uint32_t i = 0; i != onsetCount_; ++i)
+		{
+			const int64_t delivered = (now - onsets_[i].capture_) / 1000;
+			captureToDelivered_.record(delivered);
+			touchToSound_.record(delivered + (int64_t)((ahead + onsets_[i].offset_) * 1000000.0 / sampleRate));
+		}
+		onsetCount_ = 0;
+	}
+
+	const LatencyHistogram& getCaptureToEngine() const
+	{
+		return captureToEngine_;
+	}
+	const LatencyHistogram& getCaptureToDelivered() const
+	{
+		return captureToDelivered_;
+	}
+	const LatencyHistogram& getTouchToSound() const
+	{
+		return touchToSound_;
+	}
+
+	void dump(std::ostream& aStream) const
+	{
+		const LatencyHistogram* stages[3] = { &captureToEngine_, &captureToDelivered_, &touchToSound_ };
+		const char* names[3] = { "capture -> engine", "capture -> delivered", "touch -> sound" };
+		aStream << "Latency (ms, " << touchToSound_.getCount() << " strikes)" << std::endl;
+		for (int i = 0; i != 3; ++i)
+		{
+			aStream << "\t" << names[i] << ": p50 " << stages[i]->getPercentile(0.5) << " p99 " << stages[i]->getPercentile(0.99)
+				<< " max " << stages[i]->getMax() << std::endl;
+		}
+	}
+};
+
+#endif
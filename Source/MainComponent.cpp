@@ -1,304 +1,593 @@
-#include "MainComponent.h"
-
-float secondInput[44100];
-double xposInput;
-double yposInput;
-int inputPos[2]{ 0, 0 };
-int outputPos[2]{ 0, 0 };
-
-//==============================================================================
-MainComponent::MainComponent() : wavetableExciter_(10, &(wave[0]), wave.size()),
-									audioSetupComp(deviceManager,
-										0,     // minimum input channels
-										256,   // maximum input channels
-										0,     // minimum output channels
-										256,   // maximum output channels
-										false, // ability to select midi inputs
-										false, // ability to select midi output device
-										false, // treat channels as stereo pairs
-										false) // hide advanced options
-{
-	addAndMakeVisible(audioSetupComp);
-	//addAndMakeVisible(diagnosticsBox);
-
-	diagnosticsBox.setMultiLine(true);
-	diagnosticsBox.setReturnKeyStartsNewLine(true);
-	diagnosticsBox.setReadOnly(true);
-	diagnosticsBox.setScrollbarsShown(true);
-	diagnosticsBox.setCaretVisible(false);
-	diagnosticsBox.setPopupMenuEnabled(true);
-	diagnosticsBox.setColour(juce::TextEditor::backgroundColourId, juce::Colour(0x32ffffff));
-	diagnosticsBox.setColour(juce::TextEditor::outlineColourId, juce::Colour(0x1c000000));
-	diagnosticsBox.setColour(juce::TextEditor::shadowColourId, juce::Colour(0x16000000));
-
-    // Make sure you set the size of the component after
-    // you add any child components.
-    setSize (800, 600);
-
-    // Some platforms require permissions to open input channels so request that here
-    if (juce::RuntimePermissions::isRequired (juce::RuntimePermissions::recordAudio)
-        && ! juce::RuntimePermissions::isGranted (juce::RuntimePermissions::recordAudio))
-    {
-        juce::RuntimePermissions::request (juce::RuntimePermissions::recordAudio,
-                                           [&] (bool granted) { setAudioChannels (granted ? 2 : 0, 2); });
-    }
-    else
-    {
-        // Specify the number of input and output channels that we want to open
-        setAudioChannels (2, 2);
-    }
-
-	//Interface//
-	addAndMakeVisible(lblDrumOne);
-	addAndMakeVisible(sldPropagationOne);
-	sldPropagationOne.setRange(0.0, 0.49, 0.0001);
-	sldPropagationOne.setValue(0.085);
-	sldPropagationOne.addListener(this);
-	addAndMakeVisible(sldDampingOne);
-	sldDampingOne.setRange(0.0, 0.001, 0.000001);
-	sldDampingOne.setValue(0.001);
-	sldDampingOne.addListener(this);
-
-	addAndMakeVisible(lblDrumTwo);
-	addAndMakeVisible(sldPropagationTwo);
-	sldPropagationTwo.setRange(0.0, 0.49, 0.0001);
-	sldPropagationTwo.setValue(0.085);
-	sldPropagationTwo.addListener(this);
-	addAndMakeVisible(sldDampingTwo);
-	sldDampingTwo.setRange(0.0, 0.001, 0.000001);
-	sldDampingTwo.setValue(0.001);
-	sldDampingTwo.addListener(this);
-
-	addAndMakeVisible(sldInputDuration);
-	sldInputDuration.setRange(0.0, 1000, 1.0);
-	sldInputDuration.setValue(10);
-	sldInputDuration.addListener(this);
-
-	//Labels//
-	lblDrumOne.setText("Drum One", dontSendNotification);
-	addAndMakeVisible(lblPropagationOne);
-	lblPropagationOne.setText("Propagation", dontSendNotification);
-	lblPropagationOne.attachToComponent(&sldPropagationOne, true);
-	addAndMakeVisible(lblDampingOne);
-	lblDampingOne.setText("Damping", dontSendNotification);
-	lblDampingOne.attachToComponent(&sldDampingOne, true);
-	lblDrumTwo.setText("Drum Two", dontSendNotification);
-	addAndMakeVisible(lblPropagationTwo);
-	lblPropagationTwo.setText("Propagation", dontSendNotification);
-	lblPropagationTwo.attachToComponent(&sldPropagationTwo, true);
-	addAndMakeVisible(lblDampingTwo);
-	lblDampingTwo.setText("Damping", dontSendNotification);
-	lblDampingTwo.attachToComponent(&sldDampingTwo, true);
-	addAndMakeVisible(lblInputDuration);
-	lblInputDuration.setText("Input Duration", dontSendNotification);
-	lblInputDuration.attachToComponent(&sldInputDuration, true);
-
-	addAndMakeVisible(lblFPS);
-	lblFPS.setText("FPS: ", dontSendNotification);
-	addAndMakeVisible(lblLatency);
-	lblLatency.setText("Latency: ", dontSendNotification);
-
-	mutexInit.lock();
-	Implementation impl = OPENCL;
-	unsigned int bufferFrames = 1024; // 256 sample frames
-	const double gridSpacing = 0.001;
-	simulationModel = new FDTD_Accelerated(impl, bufferFrames, gridSpacing);
-	uint32_t inputPosition[2] = { 0, 0 };
-	uint32_t outputPosition[2] = { 0, 0 };
-	float boundaryValue = 1.0;
-	simulationModel->createModel(physicalModelPath_, boundaryValue, inputPosition, outputPosition);
-	// Update Coefficients.
-	float propagationCoefficientOne = 0.0018;
-	float dampingCoefficientOne = 0.00010;
-	float propagationCoefficientTwo = 0.12;
-	float dampingCoefficientTwo = 0.0008;
-
-	simulationModel->updateCoefficient("muOne", 9, dampingCoefficientOne);
-	simulationModel->updateCoefficient("lambdaOne", 10, propagationCoefficientOne);
-	simulationModel->updateCoefficient("muTwo", 12, dampingCoefficientTwo);
-	simulationModel->updateCoefficient("lambdaTwo", 11, propagationCoefficientOne);
-
-	//Setup output position
-	outputPos[0] = simulationModel->getModelHeight() / 2.0;
-	outputPos[1] = simulationModel->getModelWidth() / 4.0;
-	simulationModel->setOutputPosition(outputPos);
-	outputPos[0] = simulationModel->getModelHeight() / 2.0;
-	outputPos[1] = (simulationModel->getModelWidth() / 4.0) * 2.5;
-	simulationModel->setOutputPosition(outputPos);
-
-	//Timer callback
-	startTimer(1);
-	mutexInit.unlock();
-
-	isInit = true;
-}
-
-MainComponent::~MainComponent()
-{
-    // This shuts down the audio device and clears the audio source.
-    shutdownAudio();
-}
-//==============================================================================
-void MainComponent::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
-{
-    // This function will be called when the audio device is started, or when
-    // its settings (i.e. sample rate, block size, etc) are changed.
-
-    // You can use this function to initialise any resources you might need,
-    // but be careful - it will be called on the audio thread, not the GUI thread.
-
-    // For more details, see the help for AudioProcessor::prepareToPlay()
-}
-
-int counter = 0;
-void MainComponent::getNextAudioBlock (const juce::AudioSourceChannelInfo& bufferToFill)
-{
-	if (isInit)
-	{
-		mutexInit.lock();
-
-		// Your audio-processing code goes here!
-		auto level = 0.125f;
-		auto* leftBuffer = bufferToFill.buffer->getWritePointer(0, bufferToFill.startSample);
-		auto* rightBuffer = bufferToFill.buffer->getWritePointer(1, bufferToFill.startSample);
-
-		//Input excitation//
-		for (int j = 0; j != bufferToFill.numSamples; ++j)
-		{
-			//inputExcitation[j] = sineExciter_.getNextSample();
-			if (wavetableExciter_.isExcitation())
-				inputExcitation[j] = wavetableExciter_.getNextSample();
-			else
-				inputExcitation[j] = 0;
-		}
-
-		// For more details, see the help for AudioProcessor::getNextAudioBlock()
-		simulationModel->fillBuffer(inputExcitation, leftBuffer, bufferToFill.numSamples);
-		memcpy(rightBuffer, leftBuffer, bufferToFill.numSamples * sizeof(float));
-
-		counter += (bufferToFill.numSamples);
-		if (counter > framerate)
-		{
-			simulationModel->renderSimulation();
-			counter = 0;
-		}
-
-		mutexInit.unlock();
-	}
-}
-
-void MainComponent::releaseResources()
-{
-    // This will be called when the audio device stops, or when it is being
-    // restarted due to a setting change.
-
-    // For more details, see the help for AudioProcessor::releaseResources()
-}
-
-//==============================================================================
-void MainComponent::paint (juce::Graphics& g)
-{
-    // (Our component is opaque, so we must completely fill the background with a solid colour)
-    g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
-
-    // You can add your drawing code here!
-}
-
-void MainComponent::resized()
-{
-	auto rect = getLocalBounds();
-
-	audioSetupComp.setBounds(rect.removeFromLeft(proportionOfWidth(0.6f)));
-	rect.reduce(10, 10);
-	audioSetupComp.setVisible(false);
-
-	auto topLine(rect.removeFromTop(20));
-	cpuUsageLabel.setBounds(topLine.removeFromLeft(topLine.getWidth() / 2));
-	cpuUsageText.setBounds(topLine);
-	rect.removeFromTop(20);
-
-	diagnosticsBox.setBounds(rect);
-    // This is called when the MainContentComponent is resized.
-    // If you add any child components, this is where you should
-    // update their positions.
-	uint32_t sliderLeft = 50;
-	lblDrumOne.setBounds(getWidth()/2 - 30, 730, getWidth() - 60, 40);
-	sldPropagationOne.setBounds(80, lblDrumOne.getY() + 40, lblDrumOne.getWidth() - sliderLeft - 10, 40);
-	sldDampingOne.setBounds(sldPropagationOne.getX(), sldPropagationOne.getY() + 40, lblDrumOne.getWidth() - sliderLeft - 10, 40);
-	lblDrumTwo.setBounds(getWidth() / 2 - 30, sldDampingOne.getY() + 40, getWidth() - 60, 40);
-	sldPropagationTwo.setBounds(sldDampingOne.getX(), lblDrumTwo.getY() + 40, lblDrumOne.getWidth() - sliderLeft - 10, 40);
-	sldDampingTwo.setBounds(sldPropagationTwo.getX(), sldPropagationTwo.getY() + 40, lblDrumOne.getWidth() - sliderLeft - 10, 40);
-	sldInputDuration.setBounds(sldDampingTwo.getX(), sldDampingTwo.getY() + 40, lblDrumOne.getWidth() - sliderLeft - 10, 40);
-}
-
-//Interface//
-void MainComponent::buttonClicked(Button* btn)
-{
-	
-}
-void MainComponent::sliderValueChanged(Slider* sld)
-{
-
-}
-void MainComponent::sliderDragEnded(Slider* sld)
-{
-	if (sld == &sldPropagationOne)
-	{
-		//mutexSensel.lock();
-
-		simulationModel->updateCoefficient("lambdaOne", 10, sldPropagationOne.getValue());
-
-		//mutexSensel.unlock();
-	}
-
-	if (sld == &sldDampingOne)
-	{
-		//mutexSensel.lock();
-
-		simulationModel->updateCoefficient("muOne", 9, sldDampingOne.getValue());
-
-		//mutexSensel.unlock();
-	}
-	if (sld == &sldPropagationTwo)
-	{
-		//mutexSensel.lock();
-
-		simulationModel->updateCoefficient("lambdaTwo", 11, sldPropagationTwo.getValue());
-
-		//mutexSensel.unlock();
-	}
-
-	if (sld == &sldDampingTwo)
-	{
-		//mutexSensel.lock();
-
-		simulationModel->updateCoefficient("muTwo", 12, sldDampingTwo.getValue());
-
-		//mutexSensel.unlock();
-	}
-
-	if (sld == &sldInputDuration)
-	{
-		//mutexSensel.lock();
-
-		exciteDuration = sldInputDuration.getValue();
-		wavetableExciter_.setDuration(exciteDuration);
-
-		//mutexSensel.unlock();
-	}
-}
-
-void MainComponent::hiResTimerCallback()
-{
-	senselInterface.check();
-	inputPos[0] = senselInterface.fingers[0].x * simulationModel->getModelWidth();
-	inputPos[1] = senselInterface.fingers[0].y * simulationModel->getModelHeight();
-	simulationModel->setInputPosition(inputPos);
-	if (senselInterface.contactAmount > 0 && senselInterface.fingers[0].state == CONTACT_START)
-	{
-		wavetableExciter_.resetExcitation();
-	}
-
-	//auto cpu = deviceManager.getCpuUsage() * 100;
-	//cpuUsageText.setText(juce::String(cpu, 6) + " %", juce::dontSendNotification);
-}
\ No newline at end of file
+#include "MainComponent.h"
+
+float secondInput[44100];
+double xposInput;
+double yposInput;
+int inputPos[2]{ 0, 0 };
+int outputPos[2]{ 0, 0 };
+
+//==============================================================================
+MainComponent::MainComponent() : simulationThread_(engine_, 256, 16384),
+									voicePool_(8, &(wave[0]), wave.size()),
+									audioSetupComp(deviceManager,
+										0,     // minimum input channels
+										256,   // maximum input channels
+										0,     // minimum output channels
+										256,   // maximum output channels
+										false, // ability to select midi inputs
+										false, // ability to select midi output device
+										false, // treat channels as stereo pairs
+										false) // hide advanced options
+{
+	addAndMakeVisible(audioSetupComp);
+	//addAndMakeVisible(diagnosticsBox);
+
+	diagnosticsBox.setMultiLine(true);
+	diagnosticsBox.setReturnKeyStartsNewLine(true);
+	diagnosticsBox.setReadOnly(true);
+	diagnosticsBox.setScrollbarsShown(true);
+	diagnosticsBox.setCaretVisible(false);
+	diagnosticsBox.setPopupMenuEnabled(true);
+	diagnosticsBox.setColour(juce::TextEditor::backgroundColourId, juce::Colour(0x32ffffff));
+	diagnosticsBox.setColour(juce::TextEditor::outlineColourId, juce::Colour(0x1c000000));
+	diagnosticsBox.setColour(juce::TextEditor::shadowColourId, juce::Colour(0x16000000));
+
+    // Make sure you set the size of the component after
+    // you add any child components.
+    setSize (800, 600);
+
+    // Some platforms require permissions to open input channels so request that here
+    if (juce::RuntimePermissions::isRequired (juce::RuntimePermissions::recordAudio)
+        && ! juce::RuntimePermissions::isGranted (juce::RuntimePermissions::recordAudio))
+    {
+        juce::RuntimePermissions::request (juce::RuntimePermissions::recordAudio,
+                                           [&] (bool granted) { setAudioChannels (granted ? 2 : 0, 2); });
+    }
+    else
+    {
+        // Specify the number of input and output channels that we want to open
+        setAudioChannels (2, 2);
+    }
+
+	//Interface//
+	addAndMakeVisible(lblDrumOne);
+	addAndMakeVisible(sldPropagationOne);
+	sldPropagationOne.setRange(0.0, 0.49, 0.0001);
+	sldPropagationOne.setValue(0.085);
+	sldPropagationOne.addListener(this);
+	addAndMakeVisible(sldDampingOne);
+	sldDampingOne.setRange(0.0, 0.001, 0.000001);
+	sldDampingOne.setValue(0.001);
+	sldDampingOne.addListener(this);
+
+	addAndMakeVisible(lblDrumTwo);
+	addAndMakeVisible(sldPropagationTwo);
+	sldPropagationTwo.setRange(0.0, 0.49, 0.0001);
+	sldPropagationTwo.setValue(0.085);
+	sldPropagationTwo.addListener(this);
+	addAndMakeVisible(sldDampingTwo);
+	sldDampingTwo.setRange(0.0, 0.001, 0.000001);
+	sldDampingTwo.setValue(0.001);
+	sldDampingTwo.addListener(this);
+
+	addAndMakeVisible(sldInputDuration);
+	sldInputDuration.setRange(0.0, 1000, 1.0);
+	sldInputDuration.setValue(10);
+	sldInputDuration.addListener(this);
+
+	//Labels//
+	lblDrumOne.setText("Drum One", dontSendNotification);
+	addAndMakeVisible(lblPropagationOne);
+	lblPropagationOne.setText("Propagation", dontSendNotification);
+	lblPropagationOne.attachToComponent(&sldPropagationOne, true);
+	addAndMakeVisible(lblDampingOne);
+	lblDampingOne.setText("Damping", dontSendNotification);
+	lblDampingOne.attachToComponent(&sldDampingOne, true);
+	lblDrumTwo.setText("Drum Two", dontSendNotification);
+	addAndMakeVisible(lblPropagationTwo);
+	lblPropagationTwo.setText("Propagation", dontSendNotification);
+	lblPropagationTwo.attachToComponent(&sldPropagationTwo, true);
+	addAndMakeVisible(lblDampingTwo);
+	lblDampingTwo.setText("Damping", dontSendNotification);
+	lblDampingTwo.attachToComponent(&sldDampingTwo, true);
+	addAndMakeVisible(lblInputDuration);
+	lblInputDuration.setText("Input Duration", dontSendNotification);
+	lblInputDuration.attachToComponent(&sldInputDuration, true);
+
+	addAndMakeVisible(lblFPS);
+	lblFPS.setText("FPS: ", dontSendNotification);
+	addAndMakeVisible(lblLatency);
+	lblLatency.setText("Latency: ", dontSendNotification);
+	addAndMakeVisible(cpuUsageLabel);
+	cpuUsageLabel.setText("Audio load", dontSendNotification);
+	addAndMakeVisible(cpuUsageText);
+	addAndMakeVisible(btnTrace);
+	btnTrace.setButtonText("Record trace");
+	btnTrace.addListener(this);
+	addAndMakeVisible(btnLiveInput);
+	btnLiveInput.setButtonText("Live input");
+	btnLiveInput.setClickingTogglesState(true);
+	btnLiveInput.addListener(this);
+
+	Implementation impl = OPENCL;
+	unsigned int bufferFrames = 1024; // 256 sample frames
+	const double gridSpacing = 0.001;
+	simulationModel = new ResolutionLadder(impl, bufferFrames, gridSpacing);
+	simulationModel->setHugePages(useHugePages);
+	simulationModel->setModelCache(modelCachePath_, modelCacheBytes);
+	ResolutionPolicy resolutionPolicy;
+	resolutionPolicy.adaptive_ = adaptiveResolution;
+	simulationModel->setPolicy(resolutionPolicy);
+	uint32_t inputPosition[2] = { 0, 0 };
+	uint32_t outputPosition[2] = { 0, 0 };
+	float boundaryValue = 1.0;
+	if (useGeneratedModel)
+		simulationModel->createModels(ModelGeometry::twinMembrane(), generatedModelSizes_, boundaryValue, inputPosition, outputPosition);
+	else
+		simulationModel->createModels(physicalModelPaths_, boundaryValue, inputPosition, outputPosition);
+	if (displayWidth > 0 && displayHeight > 0)
+		simulationModel->setDisplaySize(displayWidth, displayHeight);
+	simulationModel->setSimulationRate(simulationRate);
+	simulationModel->setMaxExcitationPoints(voicePool_.getNumVoices() + 1);
+	lastStrikeIds_.fill(-1);
+	voicePool_.setLatencyMonitor(&latencyMonitor_);
+	if (!useSimulationThread)
+		simulationModel->setDeadlineMonitor(&deadlineMonitor_);
+	if (preparedBlockSize_ > 0)
+		simulationModel->prepare(preparedBlockSize_, preparedSampleRate_);
+	// Update Coefficients.
+	float propagationCoefficientOne = 0.0018;
+	float dampingCoefficientOne = 0.00010;
+	float propagationCoefficientTwo = 0.12;
+	float dampingCoefficientTwo = 0.0008;
+
+	simulationModel->updateCoefficient("muOne", 9, dampingCoefficientOne);
+	simulationModel->updateCoefficient("lambdaOne", 10, propagationCoefficientOne);
+	simulationModel->updateCoefficient("muTwo", 12, dampingCoefficientTwo);
+	simulationModel->updateCoefficient("lambdaTwo", 11, propagationCoefficientOne);
+
+	//Setup output positions - The model's defaults, two pickups for the JSON models//
+	const std::vector<float>& pickups = simulationModel->getDefaultPickups();
+	for (size_t p = 0; p + 1 < pickups.size(); p += 2)
+	{
+		outputPos[0] = pickups[p] * simulationModel->getModelHeight();
+		outputPos[1] = pickups[p + 1] * simulationModel->getModelWidth();
+		simulationModel->setOutputPosition(outputPos);
+	}
+	const float* exciter = simulationModel->getDefaultExciter();
+	centrePosition_ = simulationModel->getFlatPosition((int)(exciter[0] * simulationModel->getModelWidth()), (int)(exciter[1] * simulationModel->getModelHeight()));
+
+	//Visualisation runs on its own thread, fed by the field snapshots of whichever level is playing.
+	FDTD_Accelerated& finest = simulationModel->getLevel(0);
+	renderThread = new RenderThread(finest.getFieldSnapshots(), finest.getBoundaryGrid(), finest.getModelWidth(), finest.getModelHeight(), 60);
+	for (uint32_t l = 1; l < simulationModel->getNumLevels(); ++l)
+	{
+		FDTD_Accelerated& level = simulationModel->getLevel(l);
+		renderThread->addSource(level.getFieldSnapshots(), level.getBoundaryGrid(), level.getModelWidth(), level.getModelHeight());
+	}
+	renderThread->setThreadPolicy(realtimeSetup.render_);
+	renderThread->start();
+
+	//Everything the engine needs is allocated by now//
+	if (realtimeSetup.lockMemory_)
+		lockProcessMemory();
+
+	//Publish the fully built engine to the audio thread.
+	engine_.exchange(simulationModel);
+
+	if (useOscServer)
+	{
+		addOscRoutes(simulationModel->getControllers());
+		oscServer_.setThreadPolicy(realtimeSetup.control_);
+		oscServer_.start(oscPort, oscAddress);
+	}
+
+	if (useSimulationThread)
+	{
+		simulationThread_.setExcitationRenderer([this](ExcitationBlock& aBlock, uint32_t aNumSamples) { return renderExcitation(aBlock, aNumSamples); });
+		simulationThread_.setSnapshotInterval(framerate);
+		simulationThread_.setLatencyMonitor(&latencyMonitor_);
+		simulationThread_.setThreadPolicy(realtimeSetup.simulation_);
+		simulationThread_.start();
+	}
+
+	//Timer callback
+	HighResolutionTimer::startTimer(1);
+	Timer::startTimerHz(statisticsHz);
+}
+
+MainComponent::~MainComponent()
+{
+	HighResolutionTimer::stopTimer();
+	Timer::stopTimer();
+	oscServer_.stop();
+	if (oscServer_.getReceived() != 0)
+	{
+		std::cout << "OSC: " << oscServer_.getReceived() << " messages, " << oscServer_.getDropped() << " dropped, "
+			<< oscServer_.getUnrouted() << " unrouted, " << oscServer_.getMalformed() << " malformed." << std::endl;
+	}
+	latencyMonitor_.dump(std::cout);
+	deadlineMonitor_.writeJson(deadlineStatsPath_);
+	if (realtimeAllocationCount().load() != 0)
+		std::cout << "ERROR " << realtimeAllocationCount().load() << " allocations on real-time threads." << std::endl;
+
+    // This shuts down the audio device and clears the audio source.
+    shutdownAudio();
+
+	simulationThread_.stop();
+	delete renderThread;
+	delete engine_.exchange(nullptr);
+}
+//==============================================================================
+void MainComponent::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
+{
+    // This function will be called when the audio device is started, or when
+    // its settings (i.e. sample rate, block size, etc) are changed.
+
+    // You can use this function to initialise any resources you might need,
+    // but be careful - it will be called on the audio thread, not the GUI thread.
+
+    // For more details, see the help for AudioProcessor::prepareToPlay()
+	preparedBlockSize_ = samplesPerBlockExpected > 0 ? samplesPerBlockExpected : 1;
+	preparedSampleRate_ = sampleRate;
+	voicePool_.setSampleRate(sampleRate);
+	if (auto* device = deviceManager.getCurrentAudioDevice())
+		latencyMonitor_.setDeviceLatency(device->getOutputLatencyInSamples(), sampleRate);
+	else
+		latencyMonitor_.setDeviceLatency(0, sampleRate);
+	if (ResolutionLadder* engine = engine_.peek())
+		engine->prepare(preparedBlockSize_, preparedSampleRate_);
+
+	simulationThread_.setTargetHeadroom(samplesPerBlockExpected + (uint32_t)(sampleRate * simulationHeadroomMs / 1000.0));
+}
+
+int counter = 0;
+void MainComponent::getNextAudioBlock (const juce::AudioSourceChannelInfo& bufferToFill)
+{
+	ScopedRealtimeSection realtimeSection;
+	TraceRecorder::bindThread(audioTrace_);
+	TRACE_SCOPE("audio block");
+	deadlineMonitor_.beginBlock(bufferToFill.numSamples, preparedSampleRate_);
+
+	// Your audio-processing code goes here!
+	auto level = 0.125f;
+	auto* leftBuffer = bufferToFill.buffer->getWritePointer(0, bufferToFill.startSample);
+	auto* rightBuffer = bufferToFill.buffer->getWritePointer(1, bufferToFill.startSample);
+
+	//Threaded mode - The engine already ran ahead, just copy out of the ring//
+	if (simulationThread_.isRunning())
+	{
+		{
+			DeadlineMonitor::ScopedPhase phase(&deadlineMonitor_, PHASE_OUTPUT);
+			simulationThread_.pull(leftBuffer, bufferToFill.numSamples);
+			memcpy(rightBuffer, leftBuffer, bufferToFill.numSamples * sizeof(float));
+		}
+		deadlineMonitor_.endBlock();
+		return;
+	}
+
+	EngineHandoff<ResolutionLadder>::ReadScope engine(engine_);
+	if (engine.get() == nullptr)
+	{
+		bufferToFill.clearActiveBufferRegion();
+		deadlineMonitor_.endBlock();
+		return;
+	}
+
+	//Input excitation is rendered into the engine's prepared staging, split if the device overshoots its block size. The
+	//device's input shares this buffer - Each chunk's input is read by the renderer before that chunk's output is written//
+	liveInput_ = bufferToFill.buffer->getNumChannels() > liveInputChannel ? bufferToFill.buffer->getReadPointer(liveInputChannel, bufferToFill.startSample) : nullptr;
+	engine.get()->renderBlock([this](ExcitationBlock& aBlock, uint32_t aNumSamples) { return renderExcitation(aBlock, aNumSamples); },
+		leftBuffer, bufferToFill.numSamples);
+	liveInput_ = nullptr;
+	{
+		DeadlineMonitor::ScopedPhase phase(&deadlineMonitor_, PHASE_OUTPUT);
+		memcpy(rightBuffer, leftBuffer, bufferToFill.numSamples * sizeof(float));
+	}
+	latencyMonitor_.blockDelivered();
+
+	counter += (bufferToFill.numSamples);
+	if (counter > framerate)
+	{
+		engine.get()->publishFieldSnapshot();
+		counter = 0;
+	}
+	deadlineMonitor_.endBlock();
+}
+
+//Renders the sounding voices into their strike point rows, after live input in row 0 when it is on - Returns the active
+//span so the engine can skip uploading silent blocks. Live input comes first so its row, and resampler channel, stays put
+//as the voices come and go. Rows are the device's mapped excitation staging where the backend has it, so input goes from
+//JUCE's buffer to the device without another copy.
+uint32_t MainComponent::renderExcitation(ExcitationBlock& aBlock, uint32_t aNumSamples)
+{
+	applyControlEvents();
+	if (liveInput_ == nullptr || aBlock.points_ < 2 || !liveInputEnabled_.load(std::memory_order_relaxed))
+		return voicePool_.renderBlock(aBlock, aNumSamples);
+
+	ExcitationBlock voices = aBlock;
+	voices.samples_ += aBlock.stride_;
+	voices.positions_ += 1;
+	voices.points_ = aBlock.points_ - 1;
+	voicePool_.renderBlock(voices, aNumSamples);
+
+	for (uint32_t i = 0; i != aNumSamples; ++i)
+		aBlock.samples_[i] = liveInput_[i] * liveInputGain;
+	liveInput_ += aNumSamples;
+	aBlock.positions_[0] = centrePosition_;
+	aBlock.points_ = voices.points_ + 1;
+	return aNumSamples;
+}
+
+void MainComponent::releaseResources()
+{
+    // This will be called when the audio device stops, or when it is being
+    // restarted due to a setting change.
+
+    // For more details, see the help for AudioProcessor::releaseResources()
+}
+
+//==============================================================================
+void MainComponent::paint (juce::Graphics& g)
+{
+    // (Our component is opaque, so we must completely fill the background with a solid colour)
+    g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
+
+    // You can add your drawing code here!
+}
+
+void MainComponent::resized()
+{
+	auto rect = getLocalBounds();
+
+	audioSetupComp.setBounds(rect.removeFromLeft(proportionOfWidth(0.6f)));
+	rect.reduce(10, 10);
+	audioSetupComp.setVisible(false);
+
+	auto topLine(rect.removeFromTop(20));
+	cpuUsageLabel.setBounds(topLine.removeFromLeft(topLine.getWidth() / 2));
+	cpuUsageText.setBounds(topLine);
+	rect.removeFromTop(20);
+
+	diagnosticsBox.setBounds(rect);
+    // This is called when the MainContentComponent is resized.
+    // If you add any child components, this is where you should
+    // update their positions.
+	uint32_t sliderLeft = 50;
+	lblDrumOne.setBounds(getWidth()/2 - 30, 730, getWidth() - 60, 40);
+	sldPropagationOne.setBounds(80, lblDrumOne.getY() + 40, lblDrumOne.getWidth() - sliderLeft - 10, 40);
+	sldDampingOne.setBounds(sldPropagationOne.getX(), sldPropagationOne.getY() + 40, lblDrumOne.getWidth() - sliderLeft - 10, 40);
+	lblDrumTwo.setBounds(getWidth() / 2 - 30, sldDampingOne.getY() + 40, getWidth() - 60, 40);
+	sldPropagationTwo.setBounds(sldDampingOne.getX(), lblDrumTwo.getY() + 40, lblDrumOne.getWidth() - sliderLeft - 10, 40);
+	sldDampingTwo.setBounds(sldPropagationTwo.getX(), sldPropagationTwo.getY() + 40, lblDrumOne.getWidth() - sliderLeft - 10, 40);
+	sldInputDuration.setBounds(sldDampingTwo.getX(), sldDampingTwo.getY() + 40, lblDrumOne.getWidth() - sliderLeft - 10, 40);
+	lblFPS.setBounds(sldInputDuration.getX(), sldInputDuration.getY() + 40, 120, 20);
+	lblLatency.setBounds(lblFPS.getRight() + 10, lblFPS.getY(), getWidth() - lblFPS.getRight() - 20, 20);
+	btnTrace.setBounds(lblFPS.getX(), lblFPS.getBottom() + 10, 120, 24);
+	btnLiveInput.setBounds(btnTrace.getRight() + 10, btnTrace.getY(), 120, 24);
+}
+
+//Interface//
+void MainComponent::buttonClicked(Button* btn)
+{
+	if (btn == &btnLiveInput)
+	{
+		liveInputEnabled_.store(btnLiveInput.getToggleState(), std::memory_order_relaxed);
+		return;
+	}
+	//First click starts a fresh recording, the second stops it and writes a Chrome trace once in-flight events have landed//
+	if (btn == &btnTrace)
+	{
+		TraceRecorder& recorder = TraceRecorder::get();
+		if (!recorder.isEnabled())
+		{
+			recorder.setEnabled(true);
+			btnTrace.setButtonText("Save trace");
+		}
+		else
+		{
+			recorder.setEnabled(false);
+			btnTrace.setButtonText("Record trace");
+			const std::string path = tracePath_;
+			juce::Timer::callAfterDelay(50, [path]()
+			{
+				if (TraceRecorder::get().writeChromeTrace(path))
+					std::cout << "Trace written to " << path << std::endl;
+			});
+		}
+	}
+}
+void MainComponent::sliderValueChanged(Slider* sld)
+{
+
+}
+void MainComponent::sliderDragEnded(Slider* sld)
+{
+	if (sld == &sldPropagationOne)
+	{
+		//mutexSensel.lock();
+
+		simulationModel->updateCoefficient("lambdaOne", 10, sldPropagationOne.getValue());
+
+		//mutexSensel.unlock();
+	}
+
+	if (sld == &sldDampingOne)
+	{
+		//mutexSensel.lock();
+
+		simulationModel->updateCoefficient("muOne", 9, sldDampingOne.getValue());
+
+		//mutexSensel.unlock();
+	}
+	if (sld == &sldPropagationTwo)
+	{
+		//mutexSensel.lock();
+
+		simulationModel->updateCoefficient("lambdaTwo", 11, sldPropagationTwo.getValue());
+
+		//mutexSensel.unlock();
+	}
+
+	if (sld == &sldDampingTwo)
+	{
+		//mutexSensel.lock();
+
+		simulationModel->updateCoefficient("muTwo", 12, sldDampingTwo.getValue());
+
+		//mutexSensel.unlock();
+	}
+
+	if (sld == &sldInputDuration)
+	{
+		//mutexSensel.lock();
+
+		exciteDuration = sldInputDuration.getValue();
+
+		//mutexSensel.unlock();
+	}
+}
+
+void MainComponent::hiResTimerCallback()
+{
+	if (!inputThreadConfigured_)
+	{
+		applyThreadPolicy("Input", realtimeSetup.input_);
+		inputThreadConfigured_ = true;
+	}
+	TraceRecorder::bindThread(senselTrace_);
+	TRACE_SCOPE("sensel poll");
+	senselInterface.check();
+	traceCounter("contacts", senselInterface.contactAmount);
+	const int64_t captureTime = inputEventTime();	//Strikes start at this point in the audio, not the next block edge.
+
+	//Every new touch takes a voice of its own at its own position, rather than restarting a single strike//
+	for (size_t c = 0; c != senselInterface.fingers.size() && c < (size_t)senselInterface.contactAmount; ++c)
+	{
+		const Contact& finger = senselInterface.fingers[c];
+		if (finger.state != CONTACT_START || finger.fingerID == lastStrikeIds_[c])
+			continue;
+
+		lastStrikeIds_[c] = finger.fingerID;
+		inputPos[0] = finger.x * simulationModel->getModelWidth();
+		inputPos[1] = finger.y * simulationModel->getModelHeight();
+		voicePool_.strike(simulationModel->getFlatPosition(inputPos[0], inputPos[1]), 1.0f, exciteDuration, 1440.0f, captureTime);
+	}
+}
+
+//Message thread - Reads the instrumentation the real-time threads write, never the other way round//
+void MainComponent::timerCallback()
+{
+	const uint32_t level = simulationModel->getActiveLevel();
+	if (renderThread != nullptr)
+	{
+		renderThread->setSource(level);
+		const uint64_t frames = renderThread->getFramesRendered();
+		lblFPS.setText("FPS: " + juce::String((frames - lastFramesRendered_) * statisticsHz), dontSendNotification);
+		lastFramesRendered_ = frames;
+	}
+
+	if (deadlineMonitor_.getBlocks() != 0)
+	{
+		const BlockPhase worst = deadlineMonitor_.getWorstPhase();
+		cpuUsageText.setText(juce::String(deadlineMonitor_.getAverageLoad() * 100.0, 1) + " %  peak " + juce::String(deadlineMonitor_.getPeakLoad() * 100.0, 1)
+			+ " %  overruns " + juce::String((juce::int64)deadlineMonitor_.getOverruns())
+			+ (worst != NUM_BLOCK_PHASES ? " (" + juce::String(blockPhaseNames[worst]) + ")" : juce::String())
+			+ "  grid " + juce::String(simulationModel->getLevel(level).getModelWidth()) + "x" + juce::String(simulationModel->getLevel(level).getModelHeight()), dontSendNotification);
+	}
+
+	const LatencyHistogram& latency = latencyMonitor_.getTouchToSound();
+	if (latency.getCount() == 0)
+		return;
+	lblLatency.setText("Latency: p50 " + juce::String(latency.getPercentile(0.5), 1) + " ms  p99 " + juce::String(latency.getPercentile(0.99), 1)
+		+ " ms  max " + juce::String(latency.getMax(), 1) + " ms", dontSendNotification);
+}
+
+//Fixed addresses for the engine, plus one strike address per model controller that names one. Positions are normalised
+//0-1 across the model, coefficients are raw kernel values as set by the sliders:
+//	/coefficient/muOne f, /coefficient/lambdaOne f, /coefficient/lambdaTwo f, /coefficient/muTwo f
+//	/strike f x f y [f amplitude]
+//	/pickup/1 f x f y, /pickup/2 f x f y
+//	<address> [f x f y] [f amplitude]	Strike - At the model centre unless the controller generates coordinates.
+//	/shape/rectangle f x f y f width f height [f id], /shape/circle f x f y f radius [f id]	Paints id (1 by default) into
+//	the model while it plays - 0 cuts the membrane away. Radii are across the model's width.
+//	<address>/move f x f y				Moves the first pickup, for controllers that generate moves.
+//Touch ends are not routed - A strike is a fixed length burst with nothing to release.
+void MainComponent::addOscRoutes(const std::vector<ModelController>& aControllers)
+{
+	oscServer_.addRoute("/coefficient/muOne", CONTROL_COEFFICIENT, 9);
+	oscServer_.addRoute("/coefficient/lambdaOne", CONTROL_COEFFICIENT, 10);
+	oscServer_.addRoute("/coefficient/lambdaTwo", CONTROL_COEFFICIENT, 11);
+	oscServer_.addRoute("/coefficient/muTwo", CONTROL_COEFFICIENT, 12);
+	oscServer_.addRoute("/strike", CONTROL_STRIKE);
+	oscServer_.addRoute("/pickup/1", CONTROL_PICKUP, 0);
+	oscServer_.addRoute("/pickup/2", CONTROL_PICKUP, 1);
+	oscServer_.addRoute("/shape/rectangle", CONTROL_SHAPE, 0);
+	oscServer_.addRoute("/shape/circle", CONTROL_SHAPE, 1);
+
+	for (const ModelController& controller : aControllers)
+	{
+		if (controller.address_.empty() || controller.address_[0] != '/')
+			continue;
+		oscServer_.addRoute(controller.address_, CONTROL_STRIKE, controller.generateCoords_ ? 0 : 1);
+		if (controller.generateMove_)
+			oscServer_.addRoute(controller.address_ + "/move", CONTROL_PICKUP, 0);
+	}
+}
+
+//Rendering thread, inside the engine's ReadScope - Everything the OSC server queued since the last block//
+void MainComponent::applyControlEvents()
+{
+	ResolutionLadder* engine = engine_.peek();
+	const int width = engine->getModelWidth();
+	const int height = engine->getModelHeight();
+	ControlEvent event;
+	while (oscServer_.read(&event, 1) == 1)
+	{
+		const float* arguments = event.arguments_;
+		switch (event.type_)
+		{
+		case CONTROL_COEFFICIENT:
+			if (event.numArguments_ >= 1)
+				engine->applyCoefficient(event.index_, arguments[0]);
+			break;
+		case CONTROL_STRIKE:
+		{
+			//Routes with index 1 strike the centre and take only an amplitude//
+			const bool located = event.index_ == 0 && event.numArguments_ >= 2;
+			const int position = located ? engine->getFlatPosition((int)(arguments[0] * width), (int)(arguments[1] * height)) : centrePosition_;
+			const uint32_t amplitudeArgument = located ? 2 : 0;
+			const float amplitude = event.numArguments_ > amplitudeArgument ? arguments[amplitudeArgument] : 1.0f;
+			voicePool_.strikeNow(position, amplitude, exciteDuration, 1440.0f, event.time_);
+			break;
+		}
+		case CONTROL_PICKUP:
+			if (event.numArguments_ >= 2)
+				engine->movePickup(event.index_, (int)(arguments[0] * width), (int)(arguments[1] * height));
+			break;
+		case CONTROL_SHAPE:
+		{
+			//Positions and sizes are clamped to the model, and only the membrane ids are painted - Anything else, or any
+			//argument that is not finite, drops the message//
+			const uint32_t sizes = event.index_ == 0 ? 2 : 1;
+			if (event.numArguments_ < 2 + sizes)
+				break;
+			const uint32_t used = std::min<uint32_t>(event.numArguments_, 3 + sizes);
+			bool finite = true;
+			for (uint32_t i = 0; i != used; ++i)
+				finite = finite && std::isfinite(arguments[i]);
+			const float id = used > 2 + sizes ? arguments[2 + sizes] : 1.0f;
+			if (!finite || (id != 0.0f && id != 1.0f && id != 2.0f))
+				break;
+			float unit[4] = {};
+			for (uint32_t i = 0; i != 2 + sizes; ++i)
+				unit[i] = std::min(std::max(arguments[i], 0.0f), 1.0f);
+			if (event.index_ == 0)
+				engine->paintRectangle((int)(unit[0] * width), (int)(unit[1] * height), (int)(unit[2] * width), (int)(unit[3] * height), (int)id);
+			else
+				engine->paintCircle((int)(unit[0] * width), (int)(unit[1] * height), (int)(unit[2] * width), (int)id);
+			break;
+		}
+		}
+	}
+}
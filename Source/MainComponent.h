@@ -1,157 +1,227 @@
-#pragma once
-
-#include <JuceHeader.h>
-
-
-#include "SenselWrapper.h"
-#include "Wavetable_Exciter.h"
-#include "FDTD_Accelerated.hpp"
-
-using namespace juce;
-
-//==============================================================================
-/*
-    This component lives inside our window, and this is where you should put all
-    your controls and content.
-*/
-class MainComponent  : public juce::AudioAppComponent,
-	public  juce::Button::Listener,
-	public  juce::Slider::Listener,
-	public juce::HighResolutionTimer,
-	public juce::ChangeListener
-{
-public:
-    //==============================================================================
-    MainComponent();
-    ~MainComponent() override;
-
-    //==============================================================================
-    void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override;
-    void getNextAudioBlock (const juce::AudioSourceChannelInfo& bufferToFill) override;
-    void releaseResources() override;
-
-	//Interface//
-	void buttonClicked(Button* btn) override;
-	void sliderValueChanged(Slider* sld) override;
-	void sliderDragEnded(Slider* sld) override;
-	void hiResTimerCallback() override;
-
-
-    //==============================================================================
-    void paint (juce::Graphics& g) override;
-    void resized() override;
-
-private:
-    //==============================================================================
-    
-	//Physical Model.
-	const std::string physicalModelPath_ = "../../Source/use_case_001_512.json";
-	FDTD_Accelerated* simulationModel;
-
-	//OpenGL Render.
-	uint32_t framerate = 1000;
-
-	//Synchronisation.
-	std::mutex mutexInit;
-	
-
-	//Wavetable Synthesizer//
-	std::vector<float> wave = { 0.057564,0.114937,0.171929,0.228351,0.284015,0.338738,0.392337,0.444635,0.495459,0.544639,0.592013,0.637424,0.680721,0.721760,0.760406,0.796530,0.830012,0.860742,0.888617,0.913546,0.935444,0.954240,0.969872,0.982287,0.991445,0.997315,0.999877,0.999123,0.995055,0.987688,0.977045,0.963162,0.946085,0.925870,0.902585,0.876307,0.847122,0.815128,0.780430,0.743145,0.703395,0.661312,0.617036,0.570714,0.522499,0.472551,0.421036,0.368125,0.313993,0.258820,0.202788,0.146084,0.088895,0.031412,-0.026176,-0.083677,-0.140900,-0.197656,-0.253757,-0.309016,-0.363250,-0.416280,-0.467929,-0.518026,-0.566405,-0.612906,-0.657374,-0.699662,-0.739630,-0.777145,-0.812083,-0.844327,-0.873771,-0.900318,-0.923879,-0.944376,-0.961741,-0.975916,-0.986855,-0.994522,-0.998890,-0.999945,-0.997684,-0.992115,-0.983255,-0.971135,-0.955794,-0.937283,-0.915664,-0.891008,-0.863397,-0.832923,-0.799686,-0.763798,-0.725376,-0.684549,-0.641452,-0.596227,-0.549025,-0.500003,-0.449322,-0.397151,-0.343663,-0.289035,-0.233449,-0.177088,-0.120140,-0.062794,-0.005240 };
-	WavetableExciter wavetableExciter_;
-	Sensel senselInterface;
-	float inputExcitation[10000];
-	int exciteDuration = 1;
-	bool isInit = false;
-
-	//Interface//
-	TextButton btnExcite;
-	TextButton btnCreateDrum;
-	TextButton btnPresetKick;
-	TextButton btnPresetDrum;
-	TextButton btnPresetCymbal;
-	TextButton btnPresetHighHat;
-	TextButton btnPresetWood;
-	TextButton btnControlExcitation;
-	TextButton btnControlListener;
-	TextButton btnRectangle;
-	TextButton btnCircle;
-	TextButton btnTogglePixelated;
-	Slider sldGridWidth, sldGridHeight;
-	Label lblDrumOne;
-	Slider sldPropagationOne;
-	Slider sldDampingOne;
-	Label lblDrumTwo;
-	Slider sldPropagationTwo;
-	Slider sldDampingTwo;
-	Slider sldInputDuration;
-	Label lblGridWidth;
-	Label lblGridHeight;
-	Label lblPropagationOne;
-	Label lblDampingOne;
-	Label lblPropagationTwo;
-	Label lblDampingTwo;
-	Label lblBoundary;
-	Label lblInputDuration;
-	Label lblPresets;
-	Label lblControl;
-	Label lblShape;
-	Label lblFPS;
-	Label lblLatency;
-
-	//Control Audio Devices
-	juce::Random random;
-	juce::AudioDeviceSelectorComponent audioSetupComp;
-	juce::Label cpuUsageLabel;
-	juce::Label cpuUsageText;
-	juce::TextEditor diagnosticsBox;
-
-	void changeListenerCallback(juce::ChangeBroadcaster*) override
-	{
-		mutexInit.lock();
-		dumpDeviceInfo();
-		mutexInit.unlock();
-	}
-
-	static juce::String getListOfActiveBits(const juce::BigInteger& b)
-	{
-		juce::StringArray bits;
-
-		for (auto i = 0; i <= b.getHighestBit(); ++i)
-			if (b[i])
-				bits.add(juce::String(i));
-
-		return bits.joinIntoString(", ");
-	}
-
-	void dumpDeviceInfo()
-	{
-		logMessage("--------------------------------------");
-		logMessage("Current audio device type: " + (deviceManager.getCurrentDeviceTypeObject() != nullptr
-			? deviceManager.getCurrentDeviceTypeObject()->getTypeName()
-			: "<none>"));
-
-		if (auto* device = deviceManager.getCurrentAudioDevice())
-		{
-			logMessage("Current audio device: " + device->getName().quoted());
-			logMessage("Sample rate: " + juce::String(device->getCurrentSampleRate()) + " Hz");
-			logMessage("Block size: " + juce::String(device->getCurrentBufferSizeSamples()) + " samples");
-			logMessage("Bit depth: " + juce::String(device->getCurrentBitDepth()));
-			logMessage("Input channel names: " + device->getInputChannelNames().joinIntoString(", "));
-			logMessage("Active input channels: " + getListOfActiveBits(device->getActiveInputChannels()));
-			logMessage("Output channel names: " + device->getOutputChannelNames().joinIntoString(", "));
-			logMessage("Active output channels: " + getListOfActiveBits(device->getActiveOutputChannels()));
-		}
-		else
-		{
-			logMessage("No audio device open");
-		}
-	}
-
-	void logMessage(const juce::String& m)
-	{
-		diagnosticsBox.moveCaretToEnd();
-		diagnosticsBox.insertTextAtCaret(m + juce::newLine);
-	}
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainComponent)
-};
+#pragma once
+
+#include <JuceHeader.h>
+
+
+#include "SenselWrapper.h"
+#include "Wavetable_Exciter.h"
+#include "Exciter_Voice_Pool.hpp"
+#include "Resolution_Ladder.hpp"
+#include "Engine_Handoff.hpp"
+#include "Render_Thread.hpp"
+#include "Simulation_Thread.hpp"
+#include "Realtime_Check.hpp"
+#include "Latency_Monitor.hpp"
+#include "Deadline_Monitor.hpp"
+#include "Trace_Recorder.hpp"
+#include "Realtime_Setup.hpp"
+#include "Osc_Server.hpp"
+
+using namespace juce;
+
+//==============================================================================
+/*
+    This component lives inside our window, and this is where you should put all
+    your controls and content.
+*/
+class MainComponent  : public juce::AudioAppComponent,
+	public  juce::Button::Listener,
+	public  juce::Slider::Listener,
+	public juce::HighResolutionTimer,
+	public juce::Timer,
+	public juce::ChangeListener
+{
+public:
+    //==============================================================================
+    MainComponent();
+    ~MainComponent() override;
+
+    //==============================================================================
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override;
+    void getNextAudioBlock (const juce::AudioSourceChannelInfo& bufferToFill) override;
+    void releaseResources() override;
+
+	//Interface//
+	void buttonClicked(Button* btn) override;
+	void sliderValueChanged(Slider* sld) override;
+	void sliderDragEnded(Slider* sld) override;
+	void hiResTimerCallback() override;
+	void timerCallback() override;
+
+
+    //==============================================================================
+    void paint (juce::Graphics& g) override;
+    void resized() override;
+
+private:
+    //==============================================================================
+    
+	//Physical Model - One instrument at falling resolutions, finest first. With adaptiveResolution the engine drops a level
+	//when blocks run close to their deadline and climbs back when there is headroom - A single path fixes the resolution.
+	const std::vector<std::string> physicalModelPaths_ = { "../../Source/use_case_001_512.json", "../../Source/use_case_001_256.json", "../../Source/use_case_001_128.json" };
+	const bool adaptiveResolution = true;
+	//Generates the levels from ModelGeometry::twinMembrane() at these sizes instead of reading physicalModelPaths_//
+	const bool useGeneratedModel = false;
+	const std::vector<std::pair<int, int>> generatedModelSizes_ = { { 512, 512 }, { 256, 256 }, { 128, 128 } };
+	const std::string modelCachePath_ = "../../ModelCache";	//Loaded models and compiled programs per device - Empty disables.
+	const uint64_t modelCacheBytes = 256ull << 20;
+	ResolutionLadder* simulationModel;
+
+	//OpenGL Render - Snapshots are published every framerate samples and drawn on renderThread.
+	uint32_t framerate = 1000;
+	//Snapshots drawn at this size as colormapped RGBA8 - On OpenCL the device does the downsampling, and only the pixels are read back. 0 draws the float field.
+	const int displayWidth = 128;
+	const int displayHeight = 128;
+	RenderThread* renderThread = nullptr;
+
+	//Synchronisation - The audio thread only sees the engine through this handoff.
+	EngineHandoff<ResolutionLadder> engine_;
+
+	//Optional simulation thread - Runs the engine ahead of the device by simulationHeadroomMs.
+	const bool useSimulationThread = false;
+	const double simulationHeadroomMs = 3.0;
+	SimulationThread simulationThread_;
+
+	//Real-time setup for the engine's own threads (Linux, best effort) - { lockMemory, simulation, render, input, control }
+	//with each thread as { SCHED_FIFO priority or 0, CPU or -1 }. The audio thread's priority is left to JUCE.
+	const RealtimeSetup realtimeSetup = { true, { 80, 2 }, { 0, 3 }, { 70, 1 }, { 60, 1 } };
+	bool inputThreadConfigured_ = false;
+	const bool useHugePages = false;	//Back the engine's arenas with huge pages where the system has them.
+
+	//Rate the grid is stepped at, resampled to and from the device - 0 steps once per device sample.
+	const double simulationRate = 0.0;
+
+	//Device settings from the last prepareToPlay - Applied to the engine once it exists.
+	uint32_t preparedBlockSize_ = 0;
+	double preparedSampleRate_ = 44100.0;
+	
+
+	//Wavetable Synthesizer//
+	std::vector<float> wave = { 0.057564,0.114937,0.171929,0.228351,0.284015,0.338738,0.392337,0.444635,0.495459,0.544639,0.592013,0.637424,0.680721,0.721760,0.760406,0.796530,0.830012,0.860742,0.888617,0.913546,0.935444,0.954240,0.969872,0.982287,0.991445,0.997315,0.999877,0.999123,0.995055,0.987688,0.977045,0.963162,0.946085,0.925870,0.902585,0.876307,0.847122,0.815128,0.780430,0.743145,0.703395,0.661312,0.617036,0.570714,0.522499,0.472551,0.421036,0.368125,0.313993,0.258820,0.202788,0.146084,0.088895,0.031412,-0.026176,-0.083677,-0.140900,-0.197656,-0.253757,-0.309016,-0.363250,-0.416280,-0.467929,-0.518026,-0.566405,-0.612906,-0.657374,-0.699662,-0.739630,-0.777145,-0.812083,-0.844327,-0.873771,-0.900318,-0.923879,-0.944376,-0.961741,-0.975916,-0.986855,-0.994522,-0.998890,-0.999945,-0.997684,-0.992115,-0.983255,-0.971135,-0.955794,-0.937283,-0.915664,-0.891008,-0.863397,-0.832923,-0.799686,-0.763798,-0.725376,-0.684549,-0.641452,-0.596227,-0.549025,-0.500003,-0.449322,-0.397151,-0.343663,-0.289035,-0.233449,-0.177088,-0.120140,-0.062794,-0.005240 };
+	ExciterVoicePool voicePool_;
+	Sensel senselInterface;
+	std::array<int, 20> lastStrikeIds_;	//Finger ID last struck per contact slot - One strike per touch.
+	int exciteDuration = 10;	//Milliseconds - Matches sldInputDuration's initial value.
+
+	//Live input - An input channel streamed into the membrane as excitation row 0, ahead of the voices, so the drum
+	//resonates whatever is played into it. Direct mode only - The simulation thread runs ahead of the device's input.
+	const int liveInputChannel = 0;
+	const float liveInputGain = 0.5f;
+	std::atomic<bool> liveInputEnabled_{ false };
+	int centrePosition_ = 0;				//Model's default exciter position - Also where OSC strikes without a position land.
+	const float* liveInput_ = nullptr;		//Audio thread - This callback's input, advanced chunk by chunk.
+
+	//OSC control - Coefficients, strikes and pickup moves over UDP, applied by the rendering thread at the top of each block.
+	const bool useOscServer = true;
+	const uint16_t oscPort = 9000;
+	const char* oscAddress = "127.0.0.1";	//Loopback only - "0.0.0.0" accepts controllers on other machines too.
+	OscServer oscServer_;
+
+	//Instrumentation - Written by the input and audio threads, read by the message thread for lblLatency and lblFPS.
+	LatencyMonitor latencyMonitor_;
+	DeadlineMonitor deadlineMonitor_;
+	const std::string deadlineStatsPath_ = "deadline_stats.json";
+
+	//Trace tracks for the threads JUCE owns - Created before the device starts, bound at the top of each callback.
+	TraceBuffer* audioTrace_ = TraceRecorder::get().createBuffer("Audio");
+	TraceBuffer* senselTrace_ = TraceRecorder::get().createBuffer("Sensel");
+	const std::string tracePath_ = "trace.json";
+	uint64_t lastFramesRendered_ = 0;
+	const int statisticsHz = 4;
+
+	//Interface//
+	TextButton btnExcite;
+	TextButton btnCreateDrum;
+	TextButton btnPresetKick;
+	TextButton btnPresetDrum;
+	TextButton btnPresetCymbal;
+	TextButton btnPresetHighHat;
+	TextButton btnPresetWood;
+	TextButton btnControlExcitation;
+	TextButton btnControlListener;
+	TextButton btnRectangle;
+	TextButton btnCircle;
+	TextButton btnTogglePixelated;
+	TextButton btnTrace;
+	TextButton btnLiveInput;
+	Slider sldGridWidth, sldGridHeight;
+	Label lblDrumOne;
+	Slider sldPropagationOne;
+	Slider sldDampingOne;
+	Label lblDrumTwo;
+	Slider sldPropagationTwo;
+	Slider sldDampingTwo;
+	Slider sldInputDuration;
+	Label lblGridWidth;
+	Label lblGridHeight;
+	Label lblPropagationOne;
+	Label lblDampingOne;
+	Label lblPropagationTwo;
+	Label lblDampingTwo;
+	Label lblBoundary;
+	Label lblInputDuration;
+	Label lblPresets;
+	Label lblControl;
+	Label lblShape;
+	Label lblFPS;
+	Label lblLatency;
+
+	//Control Audio Devices
+	juce::Random random;
+	juce::AudioDeviceSelectorComponent audioSetupComp;
+	juce::Label cpuUsageLabel;
+	juce::Label cpuUsageText;
+	juce::TextEditor diagnosticsBox;
+
+	uint32_t renderExcitation(ExcitationBlock& aBlock, uint32_t aNumSamples);
+	void addOscRoutes(const std::vector<ModelController>& aControllers);
+	void applyControlEvents();
+
+	void changeListenerCallback(juce::ChangeBroadcaster*) override
+	{
+		dumpDeviceInfo();
+	}
+
+	static juce::String getListOfActiveBits(const juce::BigInteger& b)
+	{
+		juce::StringArray bits;
+
+		for (auto i = 0; i <= b.getHighestBit(); ++i)
+			if (b[i])
+				bits.add(juce::String(i));
+
+		return bits.joinIntoString(", ");
+	}
+
+	void dumpDeviceInfo()
+	{
+		logMessage("--------------------------------------");
+		logMessage("Current audio device type: " + (deviceManager.getCurrentDeviceTypeObject() != nullptr
+			? deviceManager.getCurrentDeviceTypeObject()->getTypeName()
+			: "<none>"));
+
+		if (auto* device = deviceManager.getCurrentAudioDevice())
+		{
+			logMessage("Current audio device: " + device->getName().quoted());
+			logMessage("Sample rate: " + juce::String(device->getCurrentSampleRate()) + " Hz");
+			logMessage("Block size: " + juce::String(device->getCurrentBufferSizeSamples()) + " samples");
+			logMessage("Bit depth: " + juce::String(device->getCurrentBitDepth()));
+			logMessage("Input channel names: " + device->getInputChannelNames().joinIntoString(", "));
+			logMessage("Active input channels: " + getListOfActiveBits(device->getActiveInputChannels()));
+			logMessage("Output channel names: " + device->getOutputChannelNames().joinIntoString(", "));
+			logMessage("Active output channels: " + getListOfActiveBits(device->getActiveOutputChannels()));
+		}
+		else
+		{
+			logMessage("No audio device open");
+		}
+	}
+
+	void logMessage(const juce::String& m)
+	{
+		diagnosticsBox.moveCaretToEnd();
+		diagnosticsBox.insertTextAtCaret(m + juce::newLine);
+	}
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainComponent)
+};
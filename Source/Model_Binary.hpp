@@ -0,0 +1,400 @@
+#ifndef MODEL_BINARY_HPP
+#define MODEL_BINARY_HPP
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "FDTD_Backend.hpp"
+#include "Model_Preprocess.hpp"
+
+//Compact binary model - Everything loadModelJSON produces, laid out to be used straight from a read-only mapping. All
+//values are little endian and every section starts on an 8 byte boundary:
+//	ModelFileHeader
+//	ModelFileMaterial[numMaterials_]		Ids present and how many cells each covers.
+//	Cell ids							bitsPerCell_ bits each (1, 2, 4, 8, 16 or 32), lowest bits first, row after row.
+//	Boundary mask						1 bit per cell, set where loadModelJSON puts the boundary value.
+//	Pickups								numPickups_ pairs of floats - Default output positions, normalised.
+//	Controllers							ModelFileController records, each followed by its address padded to 4 bytes.
+//	Kernel source						kernelBytes_ characters, not terminated.
+//Convert with Tools/Model_Converter.cpp.
+static const char MODEL_FILE_MAGIC[4] = { 'T', 'W', 'M', 'B' };
+static const uint32_t MODEL_FILE_VERSION = 1;
+static const uint32_t MODEL_FILE_BYTE_ORDER = 0x01020304;
+static const char* MODEL_FILE_EXTENSION = ".tmod";
+static const uint32_t MODEL_FILE_MAX_SIDE = 4096;		//Cells per side - Well past any model that steps in real time.
+
+struct ModelFileHeader
+{
+	char magic_[4];
+	uint32_t version_;
+	uint32_t byteOrder_;		//MODEL_FILE_BYTE_ORDER as written - Reads back differently on the other endianness.
+	uint32_t headerBytes_;
+	uint32_t width_;
+	uint32_t height_;
+	uint32_t bitsPerCell_;
+	uint32_t numMaterials_;
+	uint32_t numPickups_;
+	uint32_t numControllers_;
+	float exciter_[2];			//Default strike position, normalised.
+	uint64_t materialsOffset_;
+	uint64_t cellsOffset_;
+	uint64_t boundaryOffset_;
+	uint64_t pickupsOffset_;
+	uint64_t controllersOffset_;
+	uint64_t kernelOffset_;
+	uint64_t kernelBytes_;
+	uint64_t fileBytes_;
+};
+
+struct ModelFileMaterial
+{
+	int32_t id_;
+	uint32_t cells_;
+};
+
+struct ModelFileController
+{
+	int32_t id_;
+	uint32_t flags_;			//MODEL_CONTROLLER_* bits.
+	uint32_t addressBytes_;
+};
+static const uint32_t MODEL_CONTROLLER_COORDS = 1;
+static const uint32_t MODEL_CONTROLLER_MOVE = 2;
+static const uint32_t MODEL_CONTROLLER_END = 4;
+
+//Read-only view of a whole file, released with the object//
+class MappedFile
+{
+private:
+	const char* data_ = nullptr;
+	size_t size_ = 0;
+#if defined(_WIN32)
+	HANDLE file_ = INVALID_HANDLE_VALUE;
+	HANDLE mapping_ = NULL;
+#endif
+public:
+	MappedFile() {}
+	~MappedFile()
+	{
+		close();
+	}
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& aPath)
+	{
+		close();
+#if defined(_WIN32)
+		file_ = CreateFileA(aPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (file_ == INVALID_HANDLE_VALUE)
+			return false;
+		LARGE_INTEGER size;
+		GetFileSizeEx(file_, &size);
+		size_ = (size_t)size.QuadPart;
+		mapping_ = size_ != 0 ? CreateFileMappingA(file_, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+		data_ = mapping_ != NULL ? (const char*)MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0) : nullptr;
+#else
+		const int file = ::open(aPath.c_str(), O_RDONLY);
+		if (file < 0)
+			return false;
+		struct stat status;
+		if (fstat(file, &status) == 0 && status.st_size > 0)
+		{
+			size_ = (size_t)status.st_size;
+			void* memory = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+			if (memory != MAP_FAILED)
+			{
+				madvise(memory, size_, MADV_WILLNEED);
+				data_ = (const char*)memory;
+			}
+		}
+		::close(file);
+#endif
+		if (data_ == nullptr)
+		{
+			close();
+			return false;
+		}
+		return true;
+	}
+	void close()
+	{
+#if defined(_WIN32)
+		if (data_ != nullptr)
+			UnmapViewOfFile(data_);
+		if (mapping_ != NULL)
+			CloseHandle(mapping_);
+		if (file_ != INVALID_HANDLE_VALUE)
+			CloseHandle(file_);
+		mapping_ = NULL;
+		file_ = INVALID_HANDLE_VALUE;
+#else
+		if (data_ != nullptr)
+			munmap((void*)data_, size_);
+#endif
+		data_ = nullptr;
+		size_ = 0;
+	}
+
+	const char* data() const
+	{
+		return data_;
+	}
+	size_t size() const
+	{
+		return size_;
+	}
+};
+
+static bool isModelBinaryPath(const std::string& aPath)
+{
+	const size_t length = strlen(MODEL_FILE_EXTENSION);
+	return aPath.size() >= length && aPath.compare(aPath.size() - length, length, MODEL_FILE_EXTENSION) == 0;
+}
+
+//Maps the file and expands it into aModel - Cell ids are unpacked and the boundary mask becomes aBoundaryValue cells,
+//everything else is copied as it lies. Nothing is parsed//
+static bool loadModelBinary(const std::string& aPath, float aBoundaryValue, ModelData& aModel)
+{
+	MappedFile file;
+	if (!file.open(aPath))
+	{
+		std::cout << "ERROR opening model file: " << aPath << std::endl;
+		return false;
+	}
+	const char* data = file.data();
+	const size_t size = file.size();
+
+	ModelFileHeader header;
+	if (size < sizeof(header))
+	{
+		std::cout << "ERROR model file too small: " << aPath << std::endl;
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic_, MODEL_FILE_MAGIC, 4) != 0 || header.byteOrder_ != MODEL_FILE_BYTE_ORDER)
+	{
+		std::cout << "ERROR not a binary model file (or written on the other endianness): " << aPath << std::endl;
+		return false;
+	}
+	if (header.version_ != MODEL_FILE_VERSION)
+	{
+		std::cout << "ERROR binary model version " << header.version_ << ", expected " << MODEL_FILE_VERSION << " - Reconvert " << aPath << std::endl;
+		return false;
+	}
+
+	//Every section must lie inside the file before anything is read from it, checked so a corrupt offset cannot wrap the
+	//sum. The sides are bounded first, so neither the sizes nor the grids allocated from them can run away//
+	if (header.width_ > MODEL_FILE_MAX_SIDE || header.height_ > MODEL_FILE_MAX_SIDE)
+	{
+		std::cout << "ERROR binary model is " << header.width_ << "x" << header.height_ << ", larger than " << MODEL_FILE_MAX_SIDE
+			<< " a side: " << aPath << std::endl;
+		return false;
+	}
+	auto inside = [size](uint64_t aOffset, uint64_t aBytes) { return aOffset <= size && aBytes <= size - aOffset; };
+	const uint64_t cells = (uint64_t)header.width_ * header.height_;
+	const uint32_t bits = header.bitsPerCell_;
+	const uint64_t cellsBytes = (cells * bits + 7) / 8;
+	const uint64_t boundaryBytes = (cells + 7) / 8;
+	const bool validBits = bits == 1 || bits == 2 || bits == 4 || bits == 8 || bits == 16 || bits == 32;
+	if (header.fileBytes_ != size || cells == 0 || !validBits ||
+		!inside(header.cellsOffset_, cellsBytes) || !inside(header.boundaryOffset_, boundaryBytes) ||
+		!inside(header.pickupsOffset_, (uint64_t)header.numPickups_ * 2 * sizeof(float)) ||
+		!inside(header.controllersOffset_, 0) || !inside(header.kernelOffset_, header.kernelBytes_))
+	{
+		std::cout << "ERROR binary model file is truncated or corrupt: " << aPath << std::endl;
+		return false;
+	}
+
+	aModel.width_ = (int)header.width_;
+	aModel.height_ = (int)header.height_;
+	aModel.exciter_[0] = header.exciter_[0];
+	aModel.exciter_[1] = header.exciter_[1];
+
+	//Cells never straddle a byte at power of two widths below 8 - One shift and mask each//
+	aModel.idGrid_.resize((size_t)cells);
+	int* ids = aModel.idGrid_.data();
+	const unsigned char* packed = (const unsigned char*)data + header.cellsOffset_;
+	if (bits < 8)
+	{
+		const uint32_t perByte = 8 / bits;
+		const unsigned char mask = (unsigned char)((1 << bits) - 1);
+		const uint64_t whole = cells / perByte;
+		for (uint64_t byte = 0; byte != whole; ++byte)
+		{
+			const unsigned char value = packed[byte];
+			int* out = ids + byte * perByte;
+			for (uint32_t c = 0; c != perByte; ++c)
+				out[c] = (value >> (c * bits)) & mask;
+		}
+		for (uint64_t i = whole * perByte; i != cells; ++i)
+			ids[i] = (packed[i / perByte] >> ((i % perByte) * bits)) & mask;
+	}
+	else if (bits == 8)
+	{
+		for (uint64_t i = 0; i != cells; ++i)
+			ids[i] = packed[i];
+	}
+	else if (bits == 16)
+	{
+		for (uint64_t i = 0; i != cells; ++i)
+			ids[i] = packed[2 * i] | (packed[2 * i + 1] << 8);
+	}
+	else
+	{
+		memcpy(ids, packed, (size_t)cells * sizeof(int32_t));
+	}
+
+	aModel.boundaryGrid_.resize((size_t)cells);
+	float* boundary = aModel.boundaryGrid_.data();
+	const unsigned char* mask = (const unsigned char*)data + header.boundaryOffset_;
+	const float values[2] = { 0.0f, aBoundaryValue };
+	for (uint64_t i = 0; i != cells; ++i)
+		boundary[i] = values[(mask[i >> 3] >> (i & 7)) & 1];
+
+	const float* pickups = (const float*)(data + header.pickupsOffset_);
+	aModel.pickups_.assign(pickups, pickups + header.numPickups_ * 2);
+
+	aModel.controllers_.clear();
+	const char* record = data + header.controllersOffset_;
+	for (uint32_t c = 0; c != header.numControllers_; ++c)
+	{
+		ModelFileController stored;
+		if ((size_t)(data + size - record) < sizeof(stored))
+			break;
+		memcpy(&stored, record, sizeof(stored));
+		record += sizeof(stored);
+		const size_t padded = ((size_t)stored.addressBytes_ + 3) & ~(size_t)3;
+		if ((size_t)(data + size - record) < padded)
+			break;
+		ModelController controller;
+		controller.id_ = stored.id_;
+		controller.address_.assign(record, stored.addressBytes_);
+		controller.generateCoords_ = (stored.flags_ & MODEL_CONTROLLER_COORDS) != 0;
+		controller.generateMove_ = (stored.flags_ & MODEL_CONTROLLER_MOVE) != 0;
+		controller.generateEnd_ = (stored.flags_ & MODEL_CONTROLLER_END) != 0;
+		aModel.controllers_.push_back(controller);
+		record += padded;
+	}
+	if (aModel.controllers_.size() != header.numControllers_)
+	{
+		std::cout << "ERROR binary model controllers are truncated: " << aPath << std::endl;
+		return false;
+	}
+
+	aModel.kernelSource_.assign(data + header.kernelOffset_, (size_t)header.kernelBytes_);
+
+	//Everything else derived from the ids - The stored boundary stands//
+	ModelPreprocessor::get().run(aModel, aBoundaryValue, true);
+	return true;
+}
+
+//Converter side - Writes aModel as loaded from JSON. The boundary mask marks every non-zero boundary cell//
+static bool saveModelBinary(const std::string& aPath, const ModelData& aModel)
+{
+	const uint64_t cells = (uint64_t)aModel.elements();
+	if (cells == 0)
+		return false;
+
+	//Narrowest power of two width that holds every id - Two bits for the twin membranes' three materials//
+	if (aModel.materials_.empty() || aModel.materials_.front().id_ < 0)
+	{
+		std::cout << "ERROR model has not been preprocessed or has negative ids, cannot be stored." << std::endl;
+		return false;
+	}
+	std::vector<ModelFileMaterial> materials;
+	for (const ModelMaterial& material : aModel.materials_)
+	{
+		ModelFileMaterial stored = { material.id_, material.cells_ };
+		materials.push_back(stored);
+	}
+	const int maxId = aModel.materials_.back().id_;
+	uint32_t bits = 1;
+	while (bits < 32 && (uint64_t)maxId >= (1ull << bits))
+		bits *= 2;
+
+	std::vector<unsigned char> packed((size_t)((cells * bits + 7) / 8), 0);
+	for (uint64_t i = 0; i != cells; ++i)
+	{
+		const uint32_t id = (uint32_t)aModel.idGrid_[i];
+		if (bits < 8)
+			packed[(size_t)(i * bits / 8)] |= (unsigned char)(id << ((i * bits) % 8));
+		else
+			for (uint32_t b = 0; b != bits / 8; ++b)
+				packed[(size_t)(i * bits / 8 + b)] = (unsigned char)(id >> (b * 8));
+	}
+	std::vector<unsigned char> boundary((size_t)((cells + 7) / 8), 0);
+	for (uint64_t i = 0; i != cells; ++i)
+		if (aModel.boundaryGrid_[i] != 0.0f)
+			boundary[(size_t)(i >> 3)] |= (unsigned char)(1 << (i & 7));
+
+	std::vector<char> controllers;
+	for (const ModelController& controller : aModel.controllers_)
+	{
+		ModelFileController stored;
+		stored.id_ = controller.id_;
+		stored.flags_ = (controller.generateCoords_ ? MODEL_CONTROLLER_COORDS : 0) | (controller.generateMove_ ? MODEL_CONTROLLER_MOVE : 0) |
+			(controller.generateEnd_ ? MODEL_CONTROLLER_END : 0);
+		stored.addressBytes_ = (uint32_t)controller.address_.size();
+		controllers.insert(controllers.end(), (const char*)&stored, (const char*)&stored + sizeof(stored));
+		controllers.insert(controllers.end(), controller.address_.begin(), controller.address_.end());
+		controllers.resize((controllers.size() + 3) & ~(size_t)3, 0);
+	}
+
+	//Sections in file order, each aligned to 8 bytes//
+	std::vector<char> file(sizeof(ModelFileHeader), 0);
+	auto append = [&file](const void* aData, size_t aBytes) -> uint64_t
+	{
+		file.resize((file.size() + 7) & ~(size_t)7, 0);
+		const uint64_t offset = file.size();
+		file.insert(file.end(), (const char*)aData, (const char*)aData + aBytes);
+		return offset;
+	};
+
+	ModelFileHeader header = {};
+	memcpy(header.magic_, MODEL_FILE_MAGIC, 4);
+	header.version_ = MODEL_FILE_VERSION;
+	header.byteOrder_ = MODEL_FILE_BYTE_ORDER;
+	header.headerBytes_ = sizeof(ModelFileHeader);
+	header.width_ = (uint32_t)aModel.width_;
+	header.height_ = (uint32_t)aModel.height_;
+	header.bitsPerCell_ = bits;
+	header.numMaterials_ = (uint32_t)materials.size();
+	header.numPickups_ = (uint32_t)(aModel.pickups_.size() / 2);
+	header.numControllers_ = (uint32_t)aModel.controllers_.size();
+	header.exciter_[0] = aModel.exciter_[0];
+	header.exciter_[1] = aModel.exciter_[1];
+	header.materialsOffset_ = append(materials.data(), materials.size() * sizeof(ModelFileMaterial));
+	header.cellsOffset_ = append(packed.data(), packed.size());
+	header.boundaryOffset_ = append(boundary.data(), boundary.size());
+	header.pickupsOffset_ = append(aModel.pickups_.data(), header.numPickups_ * 2 * sizeof(float));
+	header.controllersOffset_ = append(controllers.data(), controllers.size());
+	header.kernelOffset_ = append(aModel.kernelSource_.data(), aModel.kernelSource_.size());
+	header.kernelBytes_ = aModel.kernelSource_.size();
+	header.fileBytes_ = file.size();
+	memcpy(file.data(), &header, sizeof(header));
+
+	std::ofstream output(aPath, std::ios::binary);
+	if (!output.is_open() || !output.write(file.data(), file.size()))
+	{
+		std::cout << "ERROR writing binary model file: " << aPath << std::endl;
+		return false;
+	}
+	return true;
+}
+
+#endif
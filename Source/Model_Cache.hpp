@@ -0,0 +1,277 @@
+#ifndef MODEL_CACHE_HPP
+#define MODEL_CACHE_HPP
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <utime.h>
+#endif
+
+#include "Model_Binary.hpp"
+
+//Content addressed cache of loaded models. Entries are keyed by a hash of the model file's bytes, the boundary value and
+//the backend's device signature, and each is two files in the cache directory:
+//	<key>.tmod		The model as loaded - Ids, boundary mask, controllers and kernel source in the binary model format.
+//	<key>.prog		The program the backend compiled for it. Absent for backends that compile nothing.
+//A hit maps the first and offers the second to the backend, leaving only the device uploads. Whenever an entry is stored
+//the least recently used ones are evicted until the directory is back under its byte budget.
+static const uint32_t MODEL_CACHE_VERSION = 1;		//Bump when loading or compiling changes what an entry would hold.
+static const char* MODEL_CACHE_PROGRAM_EXTENSION = ".prog";
+
+class ModelCache
+{
+public:
+	static const uint64_t DEFAULT_MAX_BYTES = 256ull << 20;
+private:
+	struct Entry
+	{
+		std::string key_;
+		uint64_t bytes_ = 0;
+		int64_t used_ = 0;		//Latest modification time of its files - Hits touch them.
+	};
+
+	std::string directory_;
+	uint64_t maxBytes_ = DEFAULT_MAX_BYTES;
+
+	uint64_t hits_ = 0;
+	uint64_t misses_ = 0;
+	uint64_t evictions_ = 0;
+	uint64_t bytes_ = 0;		//Directory total when opened or after the last store.
+
+	//FNV-1a - Only needs to tell model files apart, not resist anyone//
+	static uint64_t hash(uint64_t aHash, const void* aData, size_t aBytes)
+	{
+		const unsigned char* data = (const unsigned char*)aData;
+		for (size_t i = 0; i != aBytes; ++i)
+			aHash = (aHash ^ data[i]) * 0x100000001b3ull;
+		return aHash;
+	}
+
+	std::string path(const std::string& aKey, const char* aExtension) const
+	{
+		return directory_ + "/" + aKey + aExtension;
+	}
+	static bool isKey(const std::string& aName)
+	{
+		return aName.size() == 16 && aName.find_first_not_of("0123456789abcdef") == std::string::npos;
+	}
+
+	static void touch(const std::string& aPath)
+	{
+#if defined(_WIN32)
+		HANDLE file = CreateFileA(aPath.c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+			return;
+		FILETIME now;
+		GetSystemTimeAsFileTime(&now);
+		SetFileTime(file, NULL, NULL, &now);
+		CloseHandle(file);
+#else
+		utime(aPath.c_str(), nullptr);
+#endif
+	}
+	static bool writeFile(const std::string& aPath, const void* aData, size_t aBytes)
+	{
+		std::ofstream file(aPath, std::ios::binary);
+		return file.is_open() && file.write((const char*)aData, aBytes);
+	}
+	//Written beside the entry and renamed over it, so a crash or a second instance never sees half an entry//
+	static bool replaceFile(const std::string& aTemporary, const std::string& aPath)
+	{
+		remove(aPath.c_str());
+		if (rename(aTemporary.c_str(), aPath.c_str()) == 0)
+			return true;
+		remove(aTemporary.c_str());
+		return false;
+	}
+
+	//Every entry in the directory, grouped from its files. Anything not named like an entry is left alone//
+	std::vector<Entry> listEntries() const
+	{
+		std::vector<Entry> entries;
+		auto add = [&entries](const std::string& aName, uint64_t aBytes, int64_t aTime)
+		{
+			const size_t dot = aName.find('.');
+			if (dot == std::string::npos || !isKey(aName.substr(0, dot)))
+				return;
+			const std::string extension = aName.substr(dot);
+			if (extension != MODEL_FILE_EXTENSION && extension != MODEL_CACHE_PROGRAM_EXTENSION)
+				return;
+			const std::string key = aName.substr(0, dot);
+			std::vector<Entry>::iterator entry = std::find_if(entries.begin(), entries.end(), [&key](const Entry& e) { return e.key_ == key; });
+			if (entry == entries.end())
+			{
+				entries.push_back(Entry());
+				entry = entries.end() - 1;
+				entry->key_ = key;
+			}
+			entry->bytes_ += aBytes;
+			entry->used_ = std::max(entry->used_, aTime);
+		};
+#if defined(_WIN32)
+		WIN32_FIND_DATAA found;
+		HANDLE search = FindFirstFileA((directory_ + "\\*").c_str(), &found);
+		if (search == INVALID_HANDLE_VALUE)
+			return entries;
+		do
+		{
+			if (!(found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+				add(found.cFileName, ((uint64_t)found.nFileSizeHigh << 32) | found.nFileSizeLow,
+					(int64_t)(((uint64_t)found.ftLastWriteTime.dwHighDateTime << 32) | found.ftLastWriteTime.dwLowDateTime));
+		} while (FindNextFileA(search, &found));
+		FindClose(search);
+#else
+		DIR* directory = opendir(directory_.c_str());
+		if (directory == nullptr)
+			return entries;
+		while (dirent* file = readdir(directory))
+		{
+			struct stat status;
+			if (stat((directory_ + "/" + file->d_name).c_str(), &status) == 0 && S_ISREG(status.st_mode))
+				add(file->d_name, (uint64_t)status.st_size, (int64_t)status.st_mtime);
+		}
+		closedir(directory);
+#endif
+		return entries;
+	}
+
+	//Oldest first until the rest fit, never aKeep - The entry just stored//
+	void evict(const std::string& aKeep)
+	{
+		std::vector<Entry> entries = listEntries();
+		std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.used_ < b.used_; });
+		bytes_ = 0;
+		for (const Entry& entry : entries)
+			bytes_ += entry.bytes_;
+		for (const Entry& entry : entries)
+		{
+			if (bytes_ <= maxBytes_)
+				break;
+			if (entry.key_ == aKeep)
+				continue;
+			remove(path(entry.key_, MODEL_FILE_EXTENSION).c_str());
+			remove(path(entry.key_, MODEL_CACHE_PROGRAM_EXTENSION).c_str());
+			bytes_ -= entry.bytes_;
+			++evictions_;
+		}
+	}
+public:
+	//Empty disables the cache. The directory is created if missing (its parent is not) and trimmed to aMaxBytes//
+	void setDirectory(const std::string& aDirectory, uint64_t aMaxBytes = DEFAULT_MAX_BYTES)
+	{
+		directory_ = aDirectory;
+		maxBytes_ = aMaxBytes;
+		if (directory_.empty())
+			return;
+#if defined(_WIN32)
+		CreateDirectoryA(directory_.c_str(), NULL);
+#else
+		mkdir(directory_.c_str(), 0755);
+#endif
+		evict("");
+	}
+	bool isEnabled() const
+	{
+		return !directory_.empty();
+	}
+
+	//Hashes the whole model file - Empty when it cannot be read, which the caller treats as a miss it cannot store//
+	std::string key(const std::string& aModelPath, float aBoundaryValue, const std::string& aDeviceSignature) const
+	{
+		MappedFile model;
+		if (!model.open(aModelPath))
+			return "";
+		const uint32_t versions[2] = { MODEL_CACHE_VERSION, MODEL_FILE_VERSION };
+		uint64_t key = 0xcbf29ce484222325ull;
+		key = hash(key, versions, sizeof(versions));
+		key = hash(key, &aBoundaryValue, sizeof(aBoundaryValue));
+		key = hash(key, aDeviceSignature.data(), aDeviceSignature.size());
+		key = hash(key, model.data(), model.size());
+		char hex[17];
+		snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)key);
+		return hex;
+	}
+
+	//Fills aModel and aProgram from the entry and marks it used. aProgram is left empty when the entry has none//
+	bool load(const std::string& aKey, float aBoundaryValue, ModelData& aModel, std::vector<unsigned char>& aProgram)
+	{
+		aProgram.clear();
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		const std::string modelPath = path(aKey, MODEL_FILE_EXTENSION);
+		if (!std::ifstream(modelPath).is_open() || !loadModelBinary(modelPath, aBoundaryValue, aModel))
+		{
+			++misses_;
+			std::cout << "Model cache miss " << aKey << std::endl;
+			return false;
+		}
+
+		const std::string programPath = path(aKey, MODEL_CACHE_PROGRAM_EXTENSION);
+		std::ifstream program(programPath, std::ios::binary | std::ios::ate);
+		if (program.is_open())
+		{
+			aProgram.resize((size_t)program.tellg());
+			program.seekg(0);
+			if (!program.read((char*)aProgram.data(), aProgram.size()))
+				aProgram.clear();
+			program.close();
+			touch(programPath);
+		}
+		touch(modelPath);
+
+		++hits_;
+		std::cout << "Model cache hit " << aKey << (aProgram.empty() ? "" : " with program") << " - Loaded in "
+			<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+		return true;
+	}
+
+	//Writes the entry for a freshly loaded model and its program (empty for none), then evicts down to the budget//
+	bool store(const std::string& aKey, const ModelData& aModel, const std::vector<unsigned char>& aProgram)
+	{
+		const std::string modelPath = path(aKey, MODEL_FILE_EXTENSION);
+		const std::string programPath = path(aKey, MODEL_CACHE_PROGRAM_EXTENSION);
+		if (!saveModelBinary(modelPath + ".tmp", aModel) || !replaceFile(modelPath + ".tmp", modelPath))
+		{
+			std::cout << "ERROR storing model cache entry " << aKey << " in " << directory_ << std::endl;
+			return false;
+		}
+		if (!aProgram.empty() && (!writeFile(programPath + ".tmp", aProgram.data(), aProgram.size()) || !replaceFile(programPath + ".tmp", programPath)))
+			std::cout << "ERROR storing program for model cache entry " << aKey << std::endl;
+		evict(aKey);
+		return true;
+	}
+
+	uint64_t getHits() const
+	{
+		return hits_;
+	}
+	uint64_t getMisses() const
+	{
+		return misses_;
+	}
+	uint64_t getEvictions() const
+	{
+		return evictions_;
+	}
+	uint64_t getBytes() const
+	{
+		return bytes_;
+	}
+	uint64_t getMaxBytes() const
+	{
+		return maxBytes_;
+	}
+};
+
+#endif
@@ -0,0 +1,357 @@
+#ifndef MODEL_GEOMETRY_HPP
+#define MODEL_GEOMETRY_HPP
+
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GEOMETRY_USE_SSE
+#endif
+
+#include "FDTD_Backend.hpp"
+#include "Model_Preprocess.hpp"
+
+//The twin-membrane update the model files carry in their first controller, for models generated without one. Same
+//arguments as every fdtdKernel - ids 1 and 2 take lambdaOne/muOne and lambdaTwo/muTwo, id 0 is held at rest.
+static const char* twinMembraneKernelSource =
+	"int rem(int x, int y)\n"
+	"{\n"
+	"	return (x % y + y) % y;\n"
+	"}\n"
+	"__kernel void fdtdKernel(__global int* idGrid, __global float* modelGrid, __global float* boundaryGrid, int idxRotate, int idxSample,\n"
+	"	__global float* input, __global float* output, int inputPosition, __global int* outputPosition, float muOne, float lambdaOne,\n"
+	"	float lambdaTwo, float muTwo)\n"
+	"{\n"
+	"	int width = get_global_size(0);\n"
+	"	int gridSize = width * get_global_size(1);\n"
+	"	int centreIdx = get_global_id(1) * width + get_global_id(0);\n"
+	"	__global float* current = modelGrid + gridSize * rem(idxRotate, 3);\n"
+	"	__global float* previous = modelGrid + gridSize * rem(idxRotate - 1, 3);\n"
+	"	__global float* next = modelGrid + gridSize * rem(idxRotate + 1, 3);\n"
+	"	float centre = current[centreIdx];\n"
+	"	float neighbours = current[centreIdx + 1] + current[centreIdx - 1] + current[centreIdx + width] + current[centreIdx - width];\n"
+	"	float value = 0.0f;\n"
+	"	int id = idGrid[centreIdx];\n"
+	"	if (id == 1)\n"
+	"		value = ((2 * centre) + ((muOne - 1.0) * previous[centreIdx]) + (lambdaOne * (neighbours - (4 * centre)))) * (1.0 / (muOne + 1.0));\n"
+	"	if (id == 2)\n"
+	"		value = ((2 * centre) + ((muTwo - 1.0) * previous[centreIdx]) + (lambdaTwo * (neighbours - (4 * centre)))) * (1.0 / (muTwo + 1.0));\n"
+	"	if (outputPosition[centreIdx] == 1)\n"
+	"		output[idxSample] += centre;\n"
+	"	if (centreIdx == inputPosition)\n"
+	"		value += input[idxSample];\n"
+	"	next[centreIdx] = value;\n"
+	"}\n";
+
+//One signed distance primitive, negative inside. Coordinates are in model widths from the top left - x runs 0-1 across
+//the model and y 0 to height / width down it, so circles stay round on any grid//
+struct GeometryShape
+{
+	enum Primitive { CIRCLE, RECTANGLE, POLYGON };
+
+	Primitive primitive_ = CIRCLE;
+	int id_ = 1;
+	float centre_[2] = { 0.0f, 0.0f };
+	float size_[2] = { 0.0f, 0.0f };	//Radius, or the rectangle's half width and half height.
+	std::vector<float> points_;			//Polygon vertices as x, y pairs in order - Either winding, may be concave.
+	float bounds_[4] = { 0.0f, 0.0f, 0.0f, 0.0f };	//Left, top, right, bottom - Nothing outside is inside the shape.
+
+	float distance(float aX, float aY) const
+	{
+		switch (primitive_)
+		{
+		case CIRCLE:
+			return sqrtf((aX - centre_[0]) * (aX - centre_[0]) + (aY - centre_[1]) * (aY - centre_[1])) - size_[0];
+		case RECTANGLE:
+		{
+			const float qx = fabsf(aX - centre_[0]) - size_[0];
+			const float qy = fabsf(aY - centre_[1]) - size_[1];
+			const float ox = std::max(qx, 0.0f);
+			const float oy = std::max(qy, 0.0f);
+			return sqrtf(ox * ox + oy * oy) + std::min(std::max(qx, qy), 0.0f);
+		}
+		case POLYGON:
+		{
+			//Nearest edge for the distance, crossings of a ray along x for the sign//
+			const size_t n = points_.size() / 2;
+			if (n < 3)
+				return 1.0f;
+			const float* v = points_.data();
+			float nearest = (aX - v[0]) * (aX - v[0]) + (aY - v[1]) * (aY - v[1]);
+			float sign = 1.0f;
+			for (size_t i = 0, j = n - 1; i != n; j = i++)
+			{
+				const float ex = v[j * 2] - v[i * 2];
+				const float ey = v[j * 2 + 1] - v[i * 2 + 1];
+				const float wx = aX - v[i * 2];
+				const float wy = aY - v[i * 2 + 1];
+				const float length = ex * ex + ey * ey;
+				const float t = length > 0.0f ? std::min(std::max((wx * ex + wy * ey) / length, 0.0f), 1.0f) : 0.0f;
+				const float bx = wx - ex * t;
+				const float by = wy - ey * t;
+				nearest = std::min(nearest, bx * bx + by * by);
+				const bool c0 = aY >= v[i * 2 + 1];
+				const bool c1 = aY < v[j * 2 + 1];
+				const bool c2 = ex * wy > ey * wx;
+				if ((c0 && c1 && c2) || (!c0 && !c1 && !c2))
+					sign = -sign;
+			}
+			return sign * sqrtf(nearest);
+		}
+		}
+		return 1.0f;
+	}
+
+#ifdef GEOMETRY_USE_SSE
+	//distance() for four points at once//
+	__m128 distance4(__m128 aX, __m128 aY) const
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 signBit = _mm_set1_ps(-0.0f);
+		switch (primitive_)
+		{
+		case CIRCLE:
+		{
+			const __m128 dx = _mm_sub_ps(aX, _mm_set1_ps(centre_[0]));
+			const __m128 dy = _mm_sub_ps(aY, _mm_set1_ps(centre_[1]));
+			return _mm_sub_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy))), _mm_set1_ps(size_[0]));
+		}
+		case RECTANGLE:
+		{
+			const __m128 qx = _mm_sub_ps(_mm_andnot_ps(signBit, _mm_sub_ps(aX, _mm_set1_ps(centre_[0]))), _mm_set1_ps(size_[0]));
+			const __m128 qy = _mm_sub_ps(_mm_andnot_ps(signBit, _mm_sub_ps(aY, _mm_set1_ps(centre_[1]))), _mm_set1_ps(size_[1]));
+			const __m128 ox = _mm_max_ps(qx, zero);
+			const __m128 oy = _mm_max_ps(qy, zero);
+			return _mm_add_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(ox, ox), _mm_mul_ps(oy, oy))), _mm_min_ps(_mm_max_ps(qx, qy), zero));
+		}
+		case POLYGON:
+		{
+			const size_t n = points_.size() / 2;
+			if (n < 3)
+				return _mm_set1_ps(1.0f);
+			const float* v = points_.data();
+			__m128 dx = _mm_sub_ps(aX, _mm_set1_ps(v[0]));
+			__m128 dy = _mm_sub_ps(aY, _mm_set1_ps(v[1]));
+			__m128 nearest = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+			__m128 sign = _mm_set1_ps(1.0f);
+			const __m128 one = _mm_set1_ps(1.0f);
+			for (size_t i = 0, j = n - 1; i != n; j = i++)
+			{
+				const float ex = v[j * 2] - v[i * 2];
+				const float ey = v[j * 2 + 1] - v[i * 2 + 1];
+				const float length = ex * ex + ey * ey;
+				const __m128 ex4 = _mm_set1_ps(ex);
+				const __m128 ey4 = _mm_set1_ps(ey);
+				const __m128 wx = _mm_sub_ps(aX, _mm_set1_ps(v[i * 2]));
+				const __m128 wy = _mm_sub_ps(aY, _mm_set1_ps(v[i * 2 + 1]));
+				__m128 t = zero;
+				if (length > 0.0f)
+					t = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(wx, ex4), _mm_mul_ps(wy, ey4)), _mm_set1_ps(1.0f / length)), zero), one);
+				const __m128 bx = _mm_sub_ps(wx, _mm_mul_ps(ex4, t));
+				const __m128 by = _mm_sub_ps(wy, _mm_mul_ps(ey4, t));
+				nearest = _mm_min_ps(nearest, _mm_add_ps(_mm_mul_ps(bx, bx), _mm_mul_ps(by, by)));
+
+				//Sign flips where all three conditions hold or none do//
+				const __m128 c0 = _mm_cmpge_ps(aY, _mm_set1_ps(v[i * 2 + 1]));
+				const __m128 c1 = _mm_cmplt_ps(aY, _mm_set1_ps(v[j * 2 + 1]));
+				const __m128 c2 = _mm_cmpgt_ps(_mm_mul_ps(ex4, wy), _mm_mul_ps(ey4, wx));
+				const __m128 all = _mm_and_ps(_mm_and_ps(c0, c1), c2);
+				const __m128 none = _mm_andnot_ps(_mm_or_ps(_mm_or_ps(c0, c1), c2), _mm_castsi128_ps(_mm_set1_epi32(-1)));
+				sign = _mm_xor_ps(sign, _mm_and_ps(_mm_or_ps(all, none), signBit));
+			}
+			return _mm_mul_ps(sign, _mm_sqrt_ps(nearest));
+		}
+		}
+		return _mm_set1_ps(1.0f);
+	}
+#endif
+};
+
+//Parametric models without a model file. Shapes are painted in the order they were added, each setting the cells whose
+//centres it covers to its id - Shapes of one id make their union, and id 0 subtracts whatever it covers. generate()
+//rasterises the description at any resolution in bands of rows, one per hardware thread and four cells per SSE2 step
+//where the CPU has it, then runs the usual preprocessing. The outer ring of cells always stays 0//
+class ModelGeometry
+{
+public:
+	static const int MIN_BAND_ROWS = 64;	//As ModelPreprocessor.
+private:
+	std::vector<GeometryShape> shapes_;
+	std::string kernelSource_;
+	uint32_t threads_;
+
+	GeometryShape& addShape(GeometryShape::Primitive aPrimitive, int aId)
+	{
+		shapes_.push_back(GeometryShape());
+		shapes_.back().primitive_ = aPrimitive;
+		shapes_.back().id_ = aId;
+		return shapes_.back();
+	}
+
+	void rasteriseRows(ModelData& aModel, int aFirstRow, int aEndRow) const
+	{
+		const int width = aModel.width_;
+		const int height = aModel.height_;
+		const float cell = 1.0f / width;
+		for (int y = aFirstRow; y != aEndRow; ++y)
+		{
+			int* row = aModel.idGrid_.data() + y * width;
+			std::fill(row, row + width, 0);
+			if (y == 0 || y == height - 1)
+				continue;
+			const float py = (y + 0.5f) * cell;
+			for (const GeometryShape& shape : shapes_)
+			{
+				if (py < shape.bounds_[1] || py > shape.bounds_[3])
+					continue;
+				int x = std::max(1, (int)floorf(shape.bounds_[0] * width - 0.5f));
+				const int end = std::min(width - 1, (int)ceilf(shape.bounds_[2] * width + 0.5f));
+#ifdef GEOMETRY_USE_SSE
+				const __m128 y4 = _mm_set1_ps(py);
+				const __m128i id4 = _mm_set1_epi32(shape.id_);
+				const __m128 zero = _mm_setzero_ps();
+				for (; x + 4 <= end; x += 4)
+				{
+					const __m128 x4 = _mm_mul_ps(_mm_add_ps(_mm_cvtepi32_ps(_mm_setr_epi32(x, x + 1, x + 2, x + 3)), _mm_set1_ps(0.5f)), _mm_set1_ps(cell));
+					const __m128i inside = _mm_castps_si128(_mm_cmple_ps(shape.distance4(x4, y4), zero));
+					const __m128i ids = _mm_loadu_si128((const __m128i*)(row + x));
+					_mm_storeu_si128((__m128i*)(row + x), _mm_or_si128(_mm_and_si128(inside, id4), _mm_andnot_si128(inside, ids)));
+				}
+#endif
+				for (; x < end; ++x)
+					if (shape.distance((x + 0.5f) * cell, py) <= 0.0f)
+						row[x] = shape.id_;
+			}
+		}
+	}
+public:
+	ModelGeometry() :
+		kernelSource_(twinMembraneKernelSource),
+		threads_(std::max(1u, std::thread::hardware_concurrency()))
+	{
+	}
+
+	//aX, aY is the centre//
+	ModelGeometry& addCircle(float aX, float aY, float aRadius, int aId)
+	{
+		GeometryShape& shape = addShape(GeometryShape::CIRCLE, aId);
+		shape.centre_[0] = aX;
+		shape.centre_[1] = aY;
+		shape.size_[0] = aRadius;
+		shape.bounds_[0] = aX - aRadius;
+		shape.bounds_[1] = aY - aRadius;
+		shape.bounds_[2] = aX + aRadius;
+		shape.bounds_[3] = aY + aRadius;
+		return *this;
+	}
+	//aX, aY is the top left corner//
+	ModelGeometry& addRectangle(float aX, float aY, float aWidth, float aHeight, int aId)
+	{
+		GeometryShape& shape = addShape(GeometryShape::RECTANGLE, aId);
+		shape.centre_[0] = aX + aWidth * 0.5f;
+		shape.centre_[1] = aY + aHeight * 0.5f;
+		shape.size_[0] = aWidth * 0.5f;
+		shape.size_[1] = aHeight * 0.5f;
+		shape.bounds_[0] = aX;
+		shape.bounds_[1] = aY;
+		shape.bounds_[2] = aX + aWidth;
+		shape.bounds_[3] = aY + aHeight;
+		return *this;
+	}
+	//aPoints as x, y pairs - At least three vertices//
+	ModelGeometry& addPolygon(const std::vector<float>& aPoints, int aId)
+	{
+		GeometryShape& shape = addShape(GeometryShape::POLYGON, aId);
+		shape.points_.assign(aPoints.begin(), aPoints.end() - aPoints.size() % 2);
+		if (shape.points_.size() < 6)
+			std::cout << "ERROR geometry polygon needs at least three vertices." << std::endl;
+		shape.bounds_[0] = shape.bounds_[1] = 1e30f;
+		shape.bounds_[2] = shape.bounds_[3] = -1e30f;
+		for (size_t i = 0; i + 1 < shape.points_.size(); i += 2)
+		{
+			shape.bounds_[0] = std::min(shape.bounds_[0], shape.points_[i]);
+			shape.bounds_[1] = std::min(shape.bounds_[1], shape.points_[i + 1]);
+			shape.bounds_[2] = std::max(shape.bounds_[2], shape.points_[i]);
+			shape.bounds_[3] = std::max(shape.bounds_[3], shape.points_[i + 1]);
+		}
+		return *this;
+	}
+	void clear()
+	{
+		shapes_.clear();
+	}
+	const std::vector<GeometryShape>& getShapes() const
+	{
+		return shapes_;
+	}
+
+	//Defaults to twinMembraneKernelSource//
+	void setKernelSource(const std::string& aSource)
+	{
+		kernelSource_ = aSource;
+	}
+	void setThreads(uint32_t aThreads)
+	{
+		threads_ = std::max(1u, aThreads);
+	}
+
+	//Id of the shape covering (aX, aY) last, as rasterised - 0 outside every shape//
+	int idAt(float aX, float aY) const
+	{
+		int id = 0;
+		for (const GeometryShape& shape : shapes_)
+			if (shape.distance(aX, aY) <= 0.0f)
+				id = shape.id_;
+		return id;
+	}
+
+	//Fills aModel as loadModel() would from a file - Ids, kernel, then everything ModelPreprocessor derives//
+	bool generate(int aWidth, int aHeight, float aBoundaryValue, ModelData& aModel) const
+	{
+		if (aWidth < 3 || aHeight < 3)
+		{
+			std::cout << "ERROR geometry model must be at least 3x3, not " << aWidth << "x" << aHeight << std::endl;
+			return false;
+		}
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		aModel.width_ = aWidth;
+		aModel.height_ = aHeight;
+		aModel.idGrid_.resize((size_t)aWidth * aHeight);
+		aModel.kernelSource_ = kernelSource_;
+		aModel.controllers_.clear();
+
+		const uint32_t bands = std::min(threads_, (uint32_t)std::max(1, aHeight / MIN_BAND_ROWS));
+		const int bandRows = (aHeight + (int)bands - 1) / (int)bands;
+		std::vector<std::thread> workers;
+		for (uint32_t b = 1; b < bands; ++b)
+			workers.emplace_back(&ModelGeometry::rasteriseRows, this, std::ref(aModel), (int)b * bandRows, std::min(aHeight, ((int)b + 1) * bandRows));
+		rasteriseRows(aModel, 0, std::min(aHeight, bandRows));
+		for (std::thread& worker : workers)
+			worker.join();
+
+		ModelPreprocessor::get().run(aModel, aBoundaryValue);
+
+		std::cout << "Generated " << shapes_.size() << " shape model (" << aWidth << "x" << aHeight << ") in "
+			<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+		return true;
+	}
+
+	//The layout of use_case_001 - Two rectangular membranes, one above the other//
+	static ModelGeometry twinMembrane()
+	{
+		ModelGeometry geometry;
+		geometry.addRectangle(0.02f, 0.02f, 0.9f, 0.43f, 1);
+		geometry.addRectangle(0.02f, 0.48f, 0.9f, 0.43f, 2);
+		return geometry;
+	}
+};
+
+#endif
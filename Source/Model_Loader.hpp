@@ -0,0 +1,220 @@
+#ifndef MODEL_LOADER_HPP
+#define MODEL_LOADER_HPP
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <chrono>
+
+//Parsing parameters as json file//
+#include "json.hpp"
+using nlohmann::json;
+
+#include "FDTD_Backend.hpp"
+#include "Model_Binary.hpp"
+#include "Model_Preprocess.hpp"
+
+//Single pass over the model file with nlohmann's SAX interface - No DOM is built. Buffer rows are decoded straight into
+//the id grid as their numbers arrive, and the controllers, including the physics kernel, are read on the way past.
+class ModelSaxHandler : public nlohmann::json_sax<json>
+{
+private:
+	enum Section { SECTION_OTHER, SECTION_BUFFER, SECTION_CONTROLLERS };
+
+	ModelData& model_;
+	Section section_ = SECTION_OTHER;
+	std::string field_;			//Key inside the current controller.
+	int depth_ = 0;				//Objects and arrays currently open.
+	int rows_ = 0;
+	int columns_ = 0;			//Cells in the row being read.
+	bool valid_ = true;
+
+	//A cell is a number three levels down the buffer - The document, the buffer and its row//
+	bool inRow() const
+	{
+		return section_ == SECTION_BUFFER && depth_ == 3;
+	}
+	bool inController() const
+	{
+		return section_ == SECTION_CONTROLLERS && depth_ == 3;
+	}
+	bool cell(int aId)
+	{
+		model_.idGrid_.push_back(aId);
+		++columns_;
+		return true;
+	}
+public:
+	explicit ModelSaxHandler(ModelData& aModel) :
+		model_(aModel)
+	{
+	}
+
+	int getRows() const
+	{
+		return rows_;
+	}
+	bool isValid() const
+	{
+		return valid_;
+	}
+
+	bool null() override
+	{
+		return true;
+	}
+	bool boolean(bool aValue) override
+	{
+		if (inController())
+		{
+			ModelController& controller = model_.controllers_.back();
+			if (field_ == "generate_coords")
+				controller.generateCoords_ = aValue;
+			else if (field_ == "generate_move")
+				controller.generateMove_ = aValue;
+			else if (field_ == "generate_end")
+				controller.generateEnd_ = aValue;
+		}
+		return true;
+	}
+	bool number_integer(number_integer_t aValue) override
+	{
+		if (inRow())
+			return cell((int)aValue);
+		if (inController() && field_ == "id")
+			model_.controllers_.back().id_ = (int)aValue;
+		return true;
+	}
+	bool number_unsigned(number_unsigned_t aValue) override
+	{
+		return number_integer((number_integer_t)aValue);
+	}
+	bool number_float(number_float_t aValue, const string_t&) override
+	{
+		return number_integer((number_integer_t)aValue);
+	}
+	bool string(string_t& aValue) override
+	{
+		if (inController())
+		{
+			if (field_ == "address")
+				model_.controllers_.back().address_ = aValue;
+			else if (field_ == "physics_kernel" && model_.controllers_.size() == 1)
+				model_.kernelSource_.swap(aValue);
+		}
+		return true;
+	}
+	bool binary(binary_t&) override
+	{
+		return true;
+	}
+	bool start_object(std::size_t) override
+	{
+		++depth_;
+		if (inController())
+			model_.controllers_.push_back(ModelController());
+		return true;
+	}
+	bool key(string_t& aKey) override
+	{
+		if (depth_ == 1)
+			section_ = aKey == "buffer" ? SECTION_BUFFER : aKey == "controllers" ? SECTION_CONTROLLERS : SECTION_OTHER;
+		else if (inController())
+			field_.swap(aKey);
+		return true;
+	}
+	bool end_object() override
+	{
+		--depth_;
+		return true;
+	}
+	bool start_array(std::size_t) override
+	{
+		++depth_;
+		if (inRow())
+			columns_ = 0;
+		return true;
+	}
+	bool end_array() override
+	{
+		if (inRow())
+		{
+			//Every row must match the first - The grids are rectangular//
+			if (rows_ != 0 && columns_ != model_.height_)
+			{
+				std::cout << "ERROR model buffer row " << rows_ << " has " << columns_ << " cells, expected " << model_.height_ << std::endl;
+				valid_ = false;
+				return false;
+			}
+			model_.height_ = columns_;
+			++rows_;
+		}
+		--depth_;
+		return true;
+	}
+	bool parse_error(std::size_t aPosition, const std::string&, const nlohmann::detail::exception& aError) override
+	{
+		std::cout << "ERROR parsing model at byte " << aPosition << ": " << aError.what() << std::endl;
+		valid_ = false;
+		return false;
+	}
+};
+
+//Reads the model json file into host side grids ready for a backend to upload//
+static bool loadModelJSON(const std::string aPath, float aBoundaryValue, ModelData& aModel)
+{
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	//Whole file in one read - Parsing from contiguous memory is much quicker than from the stream//
+	std::ifstream ifs(aPath, std::ios::binary | std::ios::ate);
+	if (!ifs.is_open())
+	{
+		std::cout << "ERROR opening model file: " << aPath << std::endl;
+		return false;
+	}
+	std::string text((size_t)ifs.tellg(), '\0');
+	ifs.seekg(0);
+	ifs.read(&text[0], text.size());
+
+	//Every cell takes at least a digit and a comma, so this reserve is never outgrown//
+	aModel.idGrid_.clear();
+	aModel.idGrid_.reserve(text.size() / 2);
+	aModel.controllers_.clear();
+	aModel.kernelSource_.clear();
+	aModel.height_ = 0;
+	ModelSaxHandler handler(aModel);
+	if (!json::sax_parse(text, &handler) || !handler.isValid() || handler.getRows() == 0)
+	{
+		std::cout << "ERROR reading model file: " << aPath << std::endl;
+		return false;
+	}
+
+	const int modelWidth = handler.getRows();
+	const int modelHeight = aModel.height_;
+
+	aModel.width_ = modelWidth;
+
+	//Boundary, neighbour masks, active tiles and material counts - In parallel bands, see Model_Preprocess.hpp//
+	ModelPreprocessor::get().run(aModel, aBoundaryValue);
+
+	std::cout << "Loaded " << aPath << " (" << modelWidth << "x" << modelHeight << ") in "
+		<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+
+	return true;
+}
+
+//Binary models (MODEL_FILE_EXTENSION) are mapped, anything else is read as JSON//
+static bool loadModel(const std::string aPath, float aBoundaryValue, ModelData& aModel)
+{
+	if (!isModelBinaryPath(aPath))
+		return loadModelJSON(aPath, aBoundaryValue, aModel);
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	if (!loadModelBinary(aPath, aBoundaryValue, aModel))
+		return false;
+	std::cout << "Loaded " << aPath << " (" << aModel.width_ << "x" << aModel.height_ << ") in "
+		<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+	return true;
+}
+
+#endif
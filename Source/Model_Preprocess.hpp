@@ -0,0 +1,428 @@
+#ifndef MODEL_PREPROCESS_HPP
+#define MODEL_PREPROCESS_HPP
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PREPROCESS_USE_SSE
+#endif
+
+#include "FDTD_Backend.hpp"
+
+//Rows of a model handed to a stage - One row of tiles from the band a thread owns. A stage may write anything belonging
+//to these rows and tiles, and read ids anywhere. Columns span the whole width except for region updates//
+struct PreprocessBand
+{
+	ModelData* model_;
+	float boundaryValue_;
+	int firstRow_;
+	int endRow_;
+	int firstColumn_;
+	int endColumn_;
+	uint32_t index_;		//Band (thread) number, 0 to bands - 1 - Keeps per band results apart until the merge.
+};
+
+//Derives everything the engine wants to know about a model's cells beyond their ids. The grid is cut into bands of rows
+//and each band runs every stage in order on its own thread, a tile row at a time. Then each stage's merge runs once on
+//the calling thread:
+//	STAGE_NEIGHBOURS	neighbourMask_ - Which of a cell's four neighbours lie inside a material.
+//	STAGE_BOUNDARY		boundaryGrid_ - Material cells with a neighbour outside, the one-cell ring excepted.
+//	STAGE_TILES			activeTiles_ - MODEL_TILE_SIZE tiles holding any material cell.
+//	STAGE_MATERIALS		materials_ - Cells and boundary cells per id.
+//Any stage can be replaced or switched off (a null stage) through setStage(). A stage sees the results of earlier stages
+//for the rows it is given only.
+class ModelPreprocessor
+{
+public:
+	enum StageIndex { STAGE_NEIGHBOURS, STAGE_BOUNDARY, STAGE_TILES, STAGE_MATERIALS, NUM_STAGES };
+	typedef std::function<void(const PreprocessBand& aBand)> Stage;
+	typedef std::function<void(ModelData& aModel, uint32_t aBands)> Merge;
+
+	static const int MIN_BAND_ROWS = 64;	//Below this a band costs more to start than it saves.
+private:
+	Stage stages_[NUM_STAGES];
+	Merge merges_[NUM_STAGES];
+	uint32_t threads_;
+
+	//Per band results of the default stages, merged once every band is done//
+	std::vector<unsigned char> tileFlags_;
+	std::vector<std::vector<ModelMaterial>> bandMaterials_;
+
+	ModelPreprocessor() :
+		threads_(std::max(1u, std::thread::hardware_concurrency()))
+	{
+		setDefaultStages();
+	}
+
+	//Bit 0 left, 1 right, 2 up (row - 1), 3 down (row + 1), set when that neighbour's id is non-zero. Off-grid neighbours
+	//count as outside//
+	static void neighbourStage(const PreprocessBand& aBand)
+	{
+		const ModelData& model = *aBand.model_;
+		const int width = model.width_;
+		const int height = model.height_;
+		const int* ids = model.idGrid_.data();
+		unsigned char* masks = aBand.model_->neighbourMask_.data();
+		for (int y = aBand.firstRow_; y != aBand.endRow_; ++y)
+		{
+			const int* row = ids + y * width;
+			unsigned char* mask = masks + y * width;
+			if (y == 0 || y == height - 1 || width < 3)
+			{
+				for (int x = aBand.firstColumn_; x != aBand.endColumn_; ++x)
+					mask[x] = (unsigned char)((x > 0 && row[x - 1] != 0 ? 1 : 0) | (x < width - 1 && row[x + 1] != 0 ? 2 : 0) |
+						(y > 0 && row[x - width] != 0 ? 4 : 0) | (y < height - 1 && row[x + width] != 0 ? 8 : 0));
+				continue;
+			}
+
+			const int* above = row - width;
+			const int* below = row + width;
+			if (aBand.firstColumn_ == 0)
+				mask[0] = (unsigned char)((row[1] != 0 ? 2 : 0) | (above[0] != 0 ? 4 : 0) | (below[0] != 0 ? 8 : 0));
+			int x = std::max(aBand.firstColumn_, 1);
+			const int end = std::min(aBand.endColumn_, width - 1);
+#ifdef PREPROCESS_USE_SSE
+			//Four cells per compare - Each lane's compare is all ones or zero, so ANDing with the bit leaves the bit//
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i bits[4] = { _mm_set1_epi32(1), _mm_set1_epi32(2), _mm_set1_epi32(4), _mm_set1_epi32(8) };
+			for (; x + 4 <= end; x += 4)
+			{
+				const __m128i left = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(row + x - 1)), zero);
+				const __m128i right = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(row + x + 1)), zero);
+				const __m128i up = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(above + x)), zero);
+				const __m128i down = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(below + x)), zero);
+				__m128i lanes = _mm_or_si128(_mm_or_si128(_mm_andnot_si128(left, bits[0]), _mm_andnot_si128(right, bits[1])),
+					_mm_or_si128(_mm_andnot_si128(up, bits[2]), _mm_andnot_si128(down, bits[3])));
+				lanes = _mm_packus_epi16(_mm_packs_epi32(lanes, zero), zero);
+				const int packed = _mm_cvtsi128_si32(lanes);
+				memcpy(mask + x, &packed, 4);
+			}
+#endif
+			for (; x < end; ++x)
+				mask[x] = (unsigned char)((row[x - 1] != 0 ? 1 : 0) | (row[x + 1] != 0 ? 2 : 0) | (above[x] != 0 ? 4 : 0) | (below[x] != 0 ? 8 : 0));
+			if (aBand.endColumn_ == width)
+				mask[width - 1] = (unsigned char)((row[width - 2] != 0 ? 1 : 0) | (above[width - 1] != 0 ? 4 : 0) | (below[width - 1] != 0 ? 8 : 0));
+		}
+	}
+
+	//A material cell is boundary unless all four neighbours are inside - The outer ring is never stepped, so never boundary//
+	static void boundaryStage(const PreprocessBand& aBand)
+	{
+		const ModelData& model = *aBand.model_;
+		const int width = model.width_;
+		const int height = model.height_;
+		const int* ids = model.idGrid_.data();
+		const unsigned char* masks = model.neighbourMask_.data();
+		float* boundary = aBand.model_->boundaryGrid_.data();
+		for (int y = aBand.firstRow_; y != aBand.endRow_; ++y)
+		{
+			float* out = boundary + y * width;
+			if (y == 0 || y == height - 1 || width < 3)
+			{
+				memset(out + aBand.firstColumn_, 0, (aBand.endColumn_ - aBand.firstColumn_) * sizeof(float));
+				continue;
+			}
+			if (aBand.firstColumn_ == 0)
+				out[0] = 0.0f;
+			if (aBand.endColumn_ == width)
+				out[width - 1] = 0.0f;
+			const int* row = ids + y * width;
+			const unsigned char* mask = masks + y * width;
+			int x = std::max(aBand.firstColumn_, 1);
+			const int end = std::min(aBand.endColumn_, width - 1);
+#ifdef PREPROCESS_USE_SSE
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i full = _mm_set1_epi32(15);
+			const __m128 value = _mm_set1_ps(aBand.boundaryValue_);
+			for (; x + 4 <= end; x += 4)
+			{
+				int packed;
+				memcpy(&packed, mask + x, 4);
+				const __m128i masks4 = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+				const __m128i outside = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(row + x)), zero);
+				const __m128i enclosed = _mm_cmpeq_epi32(masks4, full);
+				const __m128i edge = _mm_andnot_si128(_mm_or_si128(outside, enclosed), _mm_set1_epi32(-1));
+				_mm_storeu_ps(out + x, _mm_and_ps(_mm_castsi128_ps(edge), value));
+			}
+#endif
+			for (; x < end; ++x)
+				out[x] = row[x] != 0 && mask[x] != 15 ? aBand.boundaryValue_ : 0.0f;
+		}
+	}
+
+	//Bands start on tile rows, so each band owns the flags of the tiles its rows cover//
+	void tileStage(const PreprocessBand& aBand)
+	{
+		const ModelData& model = *aBand.model_;
+		const int width = model.width_;
+		const int tilesX = (width + MODEL_TILE_SIZE - 1) / MODEL_TILE_SIZE;
+		const int* ids = model.idGrid_.data();
+		for (int y = aBand.firstRow_; y != aBand.endRow_; ++y)
+		{
+			unsigned char* flags = tileFlags_.data() + (y / MODEL_TILE_SIZE) * tilesX;
+			const int* row = ids + y * width;
+			for (int tx = 0; tx != tilesX; ++tx)
+			{
+				if (flags[tx])
+					continue;
+				const int end = std::min(width, (tx + 1) * MODEL_TILE_SIZE);
+				for (int x = tx * MODEL_TILE_SIZE; x != end; ++x)
+				{
+					if (row[x] != 0)
+					{
+						flags[tx] = 1;
+						break;
+					}
+				}
+			}
+		}
+	}
+	void tileMerge(ModelData& aModel, uint32_t aBands)
+	{
+		aModel.activeTiles_.clear();
+		for (size_t t = 0; t != tileFlags_.size(); ++t)
+			if (tileFlags_[t])
+				aModel.activeTiles_.push_back((uint32_t)t);
+	}
+
+	void materialStage(const PreprocessBand& aBand)
+	{
+		const ModelData& model = *aBand.model_;
+		const int* ids = model.idGrid_.data() + aBand.firstRow_ * model.width_;
+		const float* boundary = model.boundaryGrid_.data() + aBand.firstRow_ * model.width_;
+		const int cells = (aBand.endRow_ - aBand.firstRow_) * model.width_;
+		std::vector<ModelMaterial>& materials = bandMaterials_[aBand.index_];
+
+		//Ids come in long runs - Each run is measured and counted four cells at a time and searches the list once//
+		for (int i = 0; i != cells;)
+		{
+			const int id = ids[i];
+			int end = i + 1;
+			uint32_t edges = 0;
+			int k = i;
+#ifdef PREPROCESS_USE_SSE
+			const __m128i ids4 = _mm_set1_epi32(id);
+			while (end + 4 <= cells && _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(ids + end)), ids4)) == 0xFFFF)
+				end += 4;
+#endif
+			while (end != cells && ids[end] == id)
+				++end;
+#ifdef PREPROCESS_USE_SSE
+			//Not-equal lanes are -1, so subtracting them counts up//
+			const __m128 zero = _mm_setzero_ps();
+			__m128i counts = _mm_setzero_si128();
+			for (; k + 4 <= end; k += 4)
+				counts = _mm_sub_epi32(counts, _mm_castps_si128(_mm_cmpneq_ps(_mm_loadu_ps(boundary + k), zero)));
+			alignas(16) uint32_t lanes[4];
+			_mm_store_si128((__m128i*)lanes, counts);
+			edges = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+			for (; k != end; ++k)
+				edges += boundary[k] != 0.0f ? 1 : 0;
+
+			std::vector<ModelMaterial>::iterator found = std::find_if(materials.begin(), materials.end(), [id](const ModelMaterial& m) { return m.id_ == id; });
+			if (found == materials.end())
+			{
+				materials.push_back(ModelMaterial());
+				materials.back().id_ = id;
+				found = materials.end() - 1;
+			}
+			found->cells_ += (uint32_t)(end - i);
+			found->boundaryCells_ += edges;
+			i = end;
+		}
+	}
+	void materialMerge(ModelData& aModel, uint32_t aBands)
+	{
+		aModel.materials_.clear();
+		for (uint32_t b = 0; b != aBands; ++b)
+		{
+			for (const ModelMaterial& material : bandMaterials_[b])
+			{
+				std::vector<ModelMaterial>::iterator found = std::find_if(aModel.materials_.begin(), aModel.materials_.end(),
+					[&material](const ModelMaterial& m) { return m.id_ == material.id_; });
+				if (found == aModel.materials_.end())
+				{
+					aModel.materials_.push_back(material);
+				}
+				else
+				{
+					found->cells_ += material.cells_;
+					found->boundaryCells_ += material.boundaryCells_;
+				}
+			}
+		}
+		std::sort(aModel.materials_.begin(), aModel.materials_.end(), [](const ModelMaterial& a, const ModelMaterial& b) { return a.id_ < b.id_; });
+	}
+	//Adds aSign times the cells and boundary cells of aRegion to the material list, keeping it sorted by id//
+	static void countRegion(ModelData& aModel, const ModelRegion& aRegion, int aSign)
+	{
+		std::vector<ModelMaterial>& materials = aModel.materials_;
+		for (int y = aRegion.y_; y != aRegion.y_ + aRegion.height_; ++y)
+		{
+			const int* ids = aModel.idGrid_.data() + y * aModel.width_;
+			const float* boundary = aModel.boundaryGrid_.data() + y * aModel.width_;
+			for (int x = aRegion.x_, end = aRegion.x_ + aRegion.width_; x != end;)
+			{
+				const int id = ids[x];
+				uint32_t cells = 0;
+				uint32_t edges = 0;
+				for (; x != end && ids[x] == id; ++x, ++cells)
+					edges += boundary[x] != 0.0f ? 1 : 0;
+
+				std::vector<ModelMaterial>::iterator found = std::lower_bound(materials.begin(), materials.end(), id,
+					[](const ModelMaterial& m, int aId) { return m.id_ < aId; });
+				if (found == materials.end() || found->id_ != id)
+				{
+					found = materials.insert(found, ModelMaterial());
+					found->id_ = id;
+				}
+				found->cells_ += aSign * cells;
+				found->boundaryCells_ += aSign * edges;
+			}
+		}
+	}
+	//A tile is active while any of its cells holds a material//
+	static void updateTiles(ModelData& aModel, const ModelRegion& aRegion)
+	{
+		const int tilesX = (aModel.width_ + MODEL_TILE_SIZE - 1) / MODEL_TILE_SIZE;
+		std::vector<uint32_t>& tiles = aModel.activeTiles_;
+		for (int ty = aRegion.y_ / MODEL_TILE_SIZE; ty <= (aRegion.y_ + aRegion.height_ - 1) / MODEL_TILE_SIZE; ++ty)
+		{
+			for (int tx = aRegion.x_ / MODEL_TILE_SIZE; tx <= (aRegion.x_ + aRegion.width_ - 1) / MODEL_TILE_SIZE; ++tx)
+			{
+				bool active = false;
+				const int endY = std::min(aModel.height_, (ty + 1) * MODEL_TILE_SIZE);
+				const int endX = std::min(aModel.width_, (tx + 1) * MODEL_TILE_SIZE);
+				for (int y = ty * MODEL_TILE_SIZE; y != endY && !active; ++y)
+				{
+					const int* row = aModel.idGrid_.data() + y * aModel.width_;
+					for (int x = tx * MODEL_TILE_SIZE; x != endX && !active; ++x)
+						active = row[x] != 0;
+				}
+
+				const uint32_t tile = (uint32_t)(ty * tilesX + tx);
+				std::vector<uint32_t>::iterator found = std::lower_bound(tiles.begin(), tiles.end(), tile);
+				const bool listed = found != tiles.end() && *found == tile;
+				if (active && !listed)
+					tiles.insert(found, tile);
+				else if (!active && listed)
+					tiles.erase(found);
+			}
+		}
+	}
+public:
+	static ModelPreprocessor& get()
+	{
+		static ModelPreprocessor preprocessor;
+		return preprocessor;
+	}
+
+	//Stages and threads are set from setup code, before models load//
+	void setStage(StageIndex aStage, Stage aFunction, Merge aMerge = nullptr)
+	{
+		stages_[aStage] = aFunction;
+		merges_[aStage] = aMerge;
+	}
+	void setDefaultStages()
+	{
+		setStage(STAGE_NEIGHBOURS, &ModelPreprocessor::neighbourStage);
+		setStage(STAGE_BOUNDARY, &ModelPreprocessor::boundaryStage);
+		setStage(STAGE_TILES, [this](const PreprocessBand& aBand) { tileStage(aBand); },
+			[this](ModelData& aModel, uint32_t aBands) { tileMerge(aModel, aBands); });
+		setStage(STAGE_MATERIALS, [this](const PreprocessBand& aBand) { materialStage(aBand); },
+			[this](ModelData& aModel, uint32_t aBands) { materialMerge(aModel, aBands); });
+	}
+	void setThreads(uint32_t aThreads)
+	{
+		threads_ = std::max(1u, aThreads);
+	}
+
+	//Incremental update for an edit - aEdit() changes ids inside aRegion and nowhere else. The neighbour and boundary stages
+	//rerun over aRegion and the ring of cells around it, materials_ is adjusted by the difference and activeTiles_ for the
+	//tiles aRegion overlaps, so the cost follows the edit rather than the model. Replaced tile and material stages are
+	//only run by run(). Returns the cells whose ids or boundary may have changed//
+	template<class Edit>
+	ModelRegion runRegion(ModelData& aModel, float aBoundaryValue, const ModelRegion& aRegion, Edit aEdit)
+	{
+		if (aRegion.isEmpty())
+			return aRegion;
+		const ModelRegion changed = aRegion.expanded(1, aModel.width_, aModel.height_);
+		if (stages_[STAGE_MATERIALS])
+			countRegion(aModel, changed, -1);
+
+		aEdit();
+
+		PreprocessBand band = { &aModel, aBoundaryValue, changed.y_, changed.y_ + changed.height_, changed.x_, changed.x_ + changed.width_, 0 };
+		for (int s = STAGE_NEIGHBOURS; s <= STAGE_BOUNDARY; ++s)
+			if (stages_[s])
+				stages_[s](band);
+		if (stages_[STAGE_MATERIALS])
+		{
+			countRegion(aModel, changed, 1);
+			aModel.materials_.erase(std::remove_if(aModel.materials_.begin(), aModel.materials_.end(),
+				[](const ModelMaterial& m) { return m.cells_ == 0; }), aModel.materials_.end());
+		}
+		if (stages_[STAGE_TILES])
+			updateTiles(aModel, aRegion);
+		return changed;
+	}
+
+	//Fills everything derived from aModel's ids. With aKeepBoundary the boundary grid is left as loaded - Binary models
+	//carry it already//
+	void run(ModelData& aModel, float aBoundaryValue, bool aKeepBoundary = false)
+	{
+		const int width = aModel.width_;
+		const int height = aModel.height_;
+		const size_t cells = (size_t)aModel.elements();
+		aModel.neighbourMask_.resize(cells);
+		aModel.boundaryGrid_.resize(cells);
+		aModel.outputGrid_.assign(cells, 0);
+		aModel.activeTiles_.clear();
+		aModel.materials_.clear();
+		if (cells == 0)
+			return;
+
+		const int tileRows = (height + MODEL_TILE_SIZE - 1) / MODEL_TILE_SIZE;
+		const int tilesX = (width + MODEL_TILE_SIZE - 1) / MODEL_TILE_SIZE;
+		tileFlags_.assign((size_t)tileRows * tilesX, 0);
+
+		//Whole tile rows per band, no more bands than threads or than rows worth starting a thread for//
+		uint32_t bands = std::min(threads_, (uint32_t)std::max(1, height / MIN_BAND_ROWS));
+		bands = std::min(bands, (uint32_t)tileRows);
+		const int bandTileRows = (tileRows + bands - 1) / bands;
+		bands = (tileRows + bandTileRows - 1) / bandTileRows;
+		bandMaterials_.assign(bands, std::vector<ModelMaterial>());
+
+		//Within a band every stage runs one tile row at a time, while that row's cells are still in cache//
+		auto runBand = [this, &aModel, aBoundaryValue, aKeepBoundary, width, height, bandTileRows](uint32_t aBand)
+		{
+			const int endRow = std::min(height, ((int)aBand + 1) * bandTileRows * MODEL_TILE_SIZE);
+			for (int row = (int)aBand * bandTileRows * MODEL_TILE_SIZE; row < endRow; row += MODEL_TILE_SIZE)
+			{
+				PreprocessBand band = { &aModel, aBoundaryValue, row, std::min(endRow, row + MODEL_TILE_SIZE), 0, width, aBand };
+				for (int s = 0; s != NUM_STAGES; ++s)
+					if (stages_[s] && !(aKeepBoundary && s == STAGE_BOUNDARY))
+						stages_[s](band);
+			}
+		};
+		std::vector<std::thread> workers;
+		for (uint32_t b = 1; b < bands; ++b)
+			workers.emplace_back(runBand, b);
+		runBand(0);
+		for (std::thread& worker : workers)
+			worker.join();
+
+		for (int s = 0; s != NUM_STAGES; ++s)
+			if (stages_[s] && merges_[s])
+				merges_[s](aModel, bands);
+	}
+};
+
+#endif
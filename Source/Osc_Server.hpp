@@ -0,0 +1,385 @@
+#ifndef OSC_SERVER_HPP
+#define OSC_SERVER_HPP
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+typedef SOCKET OscSocket;
+static const OscSocket OSC_INVALID_SOCKET = INVALID_SOCKET;
+#else
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+typedef int OscSocket;
+static const OscSocket OSC_INVALID_SOCKET = -1;
+#endif
+
+#include "Spsc_Ring.hpp"
+#include "Input_Events.hpp"
+#include "Realtime_Setup.hpp"
+#include "Trace_Recorder.hpp"
+
+static void closeOscSocket(OscSocket aSocket)
+{
+#if defined(_WIN32)
+	closesocket(aSocket);
+#else
+	close(aSocket);
+#endif
+}
+
+//What a routed OSC address drives//
+enum ControlType { CONTROL_COEFFICIENT, CONTROL_STRIKE, CONTROL_PICKUP, CONTROL_SHAPE };
+
+//One routed message as queued for the rendering thread - Plain data so it can travel through the ring by copy//
+struct ControlEvent
+{
+	static const uint32_t MAX_ARGUMENTS = 5;
+
+	int64_t time_;			//inputEventTime() at receipt.
+	ControlType type_;
+	uint32_t index_;		//Kernel argument for coefficients, pickup number for pickups, 0 rectangle or 1 circle for shapes.
+	uint32_t numArguments_;
+	float arguments_[MAX_ARGUMENTS];	//Numeric arguments in order, as floats. True/False arrive as 1/0.
+};
+
+//Minimal OSC 1.0 over UDP. Messages and (nested) bundles are decoded on the server's own thread, matched exactly against
+//routes set up before start(), and queued lock-free for the thread rendering the engine to apply at the top of its next
+//block. Bundle time tags are ignored - Everything is applied as soon as it arrives. Receiving allocates nothing, so a
+//flood of messages costs the network thread time and, once the queue fills, dropped events - Never the audio thread.
+class OscServer
+{
+public:
+	static const uint32_t MAX_PACKET = 65536;
+private:
+	struct Route
+	{
+		std::string address_;
+		ControlType type_;
+		uint32_t index_;
+	};
+
+	std::vector<Route> routes_;
+	SpscRing<ControlEvent> events_;
+	std::vector<char> packet_;
+	ThreadPolicy policy_;
+	OscSocket socket_ = OSC_INVALID_SOCKET;
+
+	std::thread thread_;
+	std::atomic<bool> running_;
+	std::atomic<uint64_t> received_;
+	std::atomic<uint64_t> dropped_;
+	std::atomic<uint64_t> unrouted_;
+	std::atomic<uint64_t> malformed_;
+
+	static uint32_t readBigEndian(const char* aData)
+	{
+		const unsigned char* bytes = (const unsigned char*)aData;
+		return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | (uint32_t)bytes[3];
+	}
+	//Length of the padded OSC string at aData, or 0 if it is not terminated before aEnd//
+	static size_t paddedLength(const char* aData, const char* aEnd)
+	{
+		const char* terminator = (const char*)memchr(aData, 0, aEnd - aData);
+		if (terminator == nullptr)
+			return 0;
+		return ((terminator - aData) / 4 + 1) * 4;
+	}
+
+	void decodePacket(const char* aData, size_t aSize, int64_t aTime)
+	{
+		const char* end = aData + aSize;
+		if (aSize >= 16 && memcmp(aData, "#bundle", 8) == 0)
+		{
+			//Bundle - 8 byte tag, 8 byte time tag, then size prefixed elements//
+			const char* element = aData + 16;
+			while (element + 4 <= end)
+			{
+				const uint32_t size = readBigEndian(element);
+				element += 4;
+				if (size > (size_t)(end - element) || size % 4 != 0)
+				{
+					malformed_.fetch_add(1, std::memory_order_relaxed);
+					return;
+				}
+				decodePacket(element, size, aTime);
+				element += size;
+			}
+			return;
+		}
+		decodeMessage(aData, end, aTime);
+	}
+	void decodeMessage(const char* aData, const char* aEnd, int64_t aTime)
+	{
+		received_.fetch_add(1, std::memory_order_relaxed);
+		const size_t addressLength = aData < aEnd && *aData == '/' ? paddedLength(aData, aEnd) : 0;
+		if (addressLength == 0 || aData + addressLength > aEnd)
+		{
+			malformed_.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		const Route* route = nullptr;
+		for (const Route& candidate : routes_)
+		{
+			if (strcmp(candidate.address_.c_str(), aData) == 0)
+			{
+				route = &candidate;
+				break;
+			}
+		}
+		if (route == nullptr)
+		{
+			unrouted_.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		ControlEvent event = {};
+		event.time_ = aTime;
+		event.type_ = route->type_;
+		event.index_ = route->index_;
+
+		//Type tags are optional in OSC 1.0 - A message without them has no arguments//
+		const char* tags = aData + addressLength;
+		if (tags < aEnd && *tags == ',')
+		{
+			const size_t tagsLength = paddedLength(tags, aEnd);
+			if (tagsLength == 0 || tagsLength > (size_t)(aEnd - tags))
+			{
+				malformed_.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			const char* argument = tags + tagsLength;
+			for (const char* tag = tags + 1; *tag != 0; ++tag)
+			{
+				const size_t size = *tag == 'f' || *tag == 'i' ? 4 : *tag == 'd' ? 8 : 0;
+				if ((size == 0 && *tag != 'T' && *tag != 'F') || size > (size_t)(aEnd - argument))
+				{
+					malformed_.fetch_add(1, std::memory_order_relaxed);
+					return;
+				}
+				float value = *tag == 'T' ? 1.0f : 0.0f;
+				if (*tag == 'f')
+				{
+					const uint32_t bits = readBigEndian(argument);
+					memcpy(&value, &bits, sizeof(value));
+				}
+				else if (*tag == 'i')
+				{
+					value = (float)(int32_t)readBigEndian(argument);
+				}
+				else if (*tag == 'd')
+				{
+					const uint64_t bits = ((uint64_t)readBigEndian(argument) << 32) | readBigEndian(argument + 4);
+					double wide;
+					memcpy(&wide, &bits, sizeof(wide));
+					value = (float)wide;
+				}
+				argument += size;
+				if (event.numArguments_ != ControlEvent::MAX_ARGUMENTS)
+					event.arguments_[event.numArguments_++] = value;
+			}
+		}
+
+		if (events_.write(&event, 1) != 1)
+			dropped_.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void run()
+	{
+		TraceRecorder::get().registerThread("OSC");
+		applyThreadPolicy("OSC", policy_);
+		while (running_.load(std::memory_order_acquire))
+		{
+			//Times out every 50ms so stop() is noticed - Otherwise wakes the moment a packet lands//
+			const int size = (int)recv(socket_, packet_.data(), (int)packet_.size(), 0);
+			if (size <= 0)
+				continue;
+			const int64_t time = inputEventTime();
+			TRACE_SCOPE("osc packet");
+			decodePacket(packet_.data(), (size_t)size, time);
+		}
+	}
+public:
+	explicit OscServer(uint32_t aQueueSize = 1024) :
+		events_(aQueueSize),
+		running_(false),
+		received_(0),
+		dropped_(0),
+		unrouted_(0),
+		malformed_(0)
+	{
+	}
+	~OscServer()
+	{
+		stop();
+	}
+
+	//Setup - Call before start(). Addresses are matched exactly//
+	void addRoute(const std::string& aAddress, ControlType aType, uint32_t aIndex = 0)
+	{
+		Route route = { aAddress, aType, aIndex };
+		routes_.push_back(route);
+	}
+	void setThreadPolicy(const ThreadPolicy& aPolicy)
+	{
+		policy_ = aPolicy;
+	}
+
+	//Binds aPort on the IPv4 interface aAddress and starts receiving - Loopback unless asked otherwise, as anything that can
+	//reach the port can play and reshape the instrument. Returns false, and leaves the engine without OSC, if the port
+	//cannot be bound//
+	bool start(uint16_t aPort, const char* aAddress = "127.0.0.1")
+	{
+		if (running_.load())
+			return true;
+#if defined(_WIN32)
+		WSADATA data;
+		WSAStartup(MAKEWORD(2, 2), &data);
+#endif
+		socket_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		if (socket_ == OSC_INVALID_SOCKET)
+		{
+			std::cout << "ERROR creating OSC socket." << std::endl;
+			return false;
+		}
+
+		//A deep kernel buffer rides out bursts while this thread is descheduled//
+		int receiveBuffer = 1 << 20;
+		setsockopt(socket_, SOL_SOCKET, SO_RCVBUF, (const char*)&receiveBuffer, sizeof(receiveBuffer));
+#if defined(_WIN32)
+		DWORD timeout = 50;
+#else
+		timeval timeout = { 0, 50000 };
+#endif
+		setsockopt(socket_, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+
+		sockaddr_in address = {};
+		address.sin_family = AF_INET;
+		address.sin_port = htons(aPort);
+		if (inet_pton(AF_INET, aAddress, &address.sin_addr) != 1)
+		{
+			std::cout << "ERROR OSC server address " << aAddress << " is not an IPv4 address." << std::endl;
+			closeOscSocket(socket_);
+			socket_ = OSC_INVALID_SOCKET;
+			return false;
+		}
+		if (bind(socket_, (const sockaddr*)&address, sizeof(address)) != 0)
+		{
+			std::cout << "ERROR binding OSC server to UDP " << aAddress << ":" << aPort << "." << std::endl;
+			closeOscSocket(socket_);
+			socket_ = OSC_INVALID_SOCKET;
+			return false;
+		}
+
+		packet_.assign(MAX_PACKET, 0);
+		running_.store(true, std::memory_order_release);
+		thread_ = std::thread(&OscServer::run, this);
+		std::cout << "OSC server listening on UDP " << aAddress << ":" << aPort << std::endl;
+		return true;
+	}
+	void stop()
+	{
+		running_.store(false, std::memory_order_release);
+		if (thread_.joinable())
+			thread_.join();
+		if (socket_ != OSC_INVALID_SOCKET)
+		{
+			closeOscSocket(socket_);
+			socket_ = OSC_INVALID_SOCKET;
+		}
+	}
+	bool isRunning() const
+	{
+		return running_.load(std::memory_order_acquire);
+	}
+
+	//Rendering thread - Wait-free. Returns the number of events taken//
+	uint32_t read(ControlEvent* aEvents, uint32_t aMaxEvents)
+	{
+		return events_.read(aEvents, aMaxEvents);
+	}
+
+	//Statistics - Any thread//
+	uint64_t getReceived() const
+	{
+		return received_.load(std::memory_order_relaxed);
+	}
+	uint64_t getDropped() const
+	{
+		return dropped_.load(std::memory_order_relaxed);
+	}
+	uint64_t getUnrouted() const
+	{
+		return unrouted_.load(std::memory_order_relaxed);
+	}
+	uint64_t getMalformed() const
+	{
+		return malformed_.load(std::memory_order_relaxed);
+	}
+};
+
+//Loopback sender - Encodes float argument messages for driving a running server from another thread or process, and for
+//checking one without a controller attached//
+class OscSender
+{
+private:
+	OscSocket socket_ = OSC_INVALID_SOCKET;
+	sockaddr_in target_ = {};
+	std::vector<char> packet_;
+
+	void appendString(const char* aString)
+	{
+		const size_t length = strlen(aString);
+		packet_.insert(packet_.end(), aString, aString + length);
+		packet_.insert(packet_.end(), 4 - length % 4, 0);
+	}
+public:
+	OscSender(uint16_t aPort, const char* aHost = "127.0.0.1")
+	{
+#if defined(_WIN32)
+		WSADATA data;
+		WSAStartup(MAKEWORD(2, 2), &data);
+#endif
+		socket_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		target_.sin_family = AF_INET;
+		target_.sin_port = htons(aPort);
+		inet_pton(AF_INET, aHost, &target_.sin_addr);
+	}
+	~OscSender()
+	{
+		if (socket_ != OSC_INVALID_SOCKET)
+			closeOscSocket(socket_);
+	}
+	OscSender(const OscSender&) = delete;
+	OscSender& operator=(const OscSender&) = delete;
+
+	bool send(const char* aAddress, const float* aArguments = nullptr, uint32_t aNumArguments = 0)
+	{
+		packet_.clear();
+		appendString(aAddress);
+		std::string tags(",");
+		tags.append(aNumArguments, 'f');
+		appendString(tags.c_str());
+		for (uint32_t i = 0; i != aNumArguments; ++i)
+		{
+			uint32_t bits;
+			memcpy(&bits, &aArguments[i], sizeof(bits));
+			const char bytes[4] = { (char)(bits >> 24), (char)(bits >> 16), (char)(bits >> 8), (char)bits };
+			packet_.insert(packet_.end(), bytes, bytes + 4);
+		}
+		return sendto(socket_, packet_.data(), (int)packet_.size(), 0, (const sockaddr*)&target_, sizeof(target_)) == (int)packet_.size();
+	}
+};
+
+#endif
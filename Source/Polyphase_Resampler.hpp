@@ -0,0 +1,273 @@
+#ifndef POLYPHASE_RESAMPLER_HPP
+#define POLYPHASE_RESAMPLER_HPP
+
+#include <stdint.h>
+#include <string.h>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define POLYPHASE_USE_SSE
+#endif
+
+//Streaming rational resampler. The rates are reduced to upFactor/downFactor and a windowed sinc prototype is split into
+//upFactor phases, each stored reversed and padded to a multiple of four so one output is a single contiguous dot product.
+//The input history is kept twice back to back so the window never wraps. Everything is sized in the constructor - The
+//process calls do not allocate.
+class PolyphaseResampler
+{
+private:
+	uint32_t upFactor_ = 1;
+	uint32_t downFactor_ = 1;
+	uint32_t tapsPerPhase_ = 0;
+	std::vector<float> coefficients_;	//upFactor_ phases of tapsPerPhase_ taps.
+	std::vector<float> history_;		//2 * tapsPerPhase_, written twice per push.
+	uint32_t writeIndex_ = 0;
+	uint32_t phase_ = 0;
+
+	static uint32_t greatestCommonDivisor(uint32_t aA, uint32_t aB)
+	{
+		while (aB != 0)
+		{
+			const uint32_t remainder = aA % aB;
+			aA = aB;
+			aB = remainder;
+		}
+		return aA;
+	}
+
+	void push(float aSample)
+	{
+		writeIndex_ = writeIndex_ + 1 == tapsPerPhase_ ? 0 : writeIndex_ + 1;
+		history_[writeIndex_] = aSample;
+		history_[writeIndex_ + tapsPerPhase_] = aSample;
+	}
+
+	float dot(const float* aCoefficients) const
+	{
+		//Oldest to newest - Matches the reversed phase coefficients//
+		const float* window = &history_[writeIndex_ + 1];
+#ifdef POLYPHASE_USE_SSE
+		__m128 sum = _mm_setzero_ps();
+		for (uint32_t i = 0; i != tapsPerPhase_; i += 4)
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(window + i), _mm_loadu_ps(aCoefficients + i)));
+		sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+		sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+		return _mm_cvtss_f32(sum);
+#else
+		float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (uint32_t i = 0; i != tapsPerPhase_; i += 4)
+		{
+			sum[0] += window[i] * aCoefficients[i];
+			sum[1] += window[i + 1] * aCoefficients[i + 1];
+			sum[2] += window[i + 2] * aCoefficients[i + 2];
+			sum[3] += window[i + 3] * aCoefficients[i + 3];
+		}
+		return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+#endif
+	}
+
+	void designFilter(uint32_t aTapsPerPhase)
+	{
+		//Taps per phase grow with the decimation ratio so the transition band stays the same width at the lower rate//
+		const double ratio = downFactor_ > upFactor_ ? (double)downFactor_ / upFactor_ : 1.0;
+		tapsPerPhase_ = ((uint32_t)std::ceil(aTapsPerPhase * ratio) + 3) & ~3u;
+
+		const uint32_t length = upFactor_ * tapsPerPhase_;
+		const double cutoff = 0.5 * 0.9 / (upFactor_ > downFactor_ ? upFactor_ : downFactor_);	//Cycles per prototype sample.
+		const double centre = (length - 1) * 0.5;
+		const double pi = 3.14159265358979323846;
+
+		coefficients_.assign(length, 0.0f);
+		for (uint32_t i = 0; i != length; ++i)
+		{
+			const double t = i - centre;
+			const double sinc = t == 0.0 ? 2.0 * cutoff : std::sin(2.0 * pi * cutoff * t) / (pi * t);
+			const double window = 0.42 - 0.5 * std::cos(2.0 * pi * i / (length - 1)) + 0.08 * std::cos(4.0 * pi * i / (length - 1));
+
+			//Tap i lands in phase i % upFactor_ as delay i / upFactor_, stored reversed within the phase//
+			const uint32_t phase = i % upFactor_;
+			const uint32_t delay = i / upFactor_;
+			coefficients_[phase * tapsPerPhase_ + (tapsPerPhase_ - 1 - delay)] = (float)(sinc * window * upFactor_);
+		}
+	}
+public:
+	PolyphaseResampler(uint32_t aInputRate, uint32_t aOutputRate, uint32_t aTapsPerPhase = 16)
+	{
+		const uint32_t divisor = greatestCommonDivisor(aInputRate, aOutputRate);
+		upFactor_ = aOutputRate / divisor;
+		downFactor_ = aInputRate / divisor;
+		if (upFactor_ > 4096)
+			std::cout << "ERROR resampling " << aInputRate << " to " << aOutputRate << " Hz needs " << upFactor_ << " phases." << std::endl;
+
+		designFilter(aTapsPerPhase);
+		history_.assign(tapsPerPhase_ * 2, 0.0f);
+		reset();
+	}
+
+	void reset()
+	{
+		memset(history_.data(), 0, history_.size() * sizeof(float));
+		writeIndex_ = 0;
+		phase_ = 0;
+	}
+
+	//Input samples that must be pushed before aNumOutputs more outputs can be produced//
+	uint32_t getRequiredInput(uint32_t aNumOutputs) const
+	{
+		if (aNumOutputs == 0)
+			return 0;
+		return (uint32_t)((phase_ + (uint64_t)(aNumOutputs - 1) * downFactor_) / upFactor_);
+	}
+	//Most outputs aNumInputs can ever produce - For sizing//
+	uint32_t getMaxOutput(uint32_t aNumInputs) const
+	{
+		return (uint32_t)(((uint64_t)aNumInputs * upFactor_ + downFactor_ - 1) / downFactor_) + 1;
+	}
+
+	//Consumes all of aInput unless aMaxOutputs is reached first. Returns the number of outputs written//
+	uint32_t process(const float* aInput, uint32_t aNumInputs, float* aOutput, uint32_t aMaxOutputs)
+	{
+		uint32_t consumed = 0;
+		uint32_t produced = 0;
+		while (produced != aMaxOutputs)
+		{
+			while (phase_ >= upFactor_)
+			{
+				if (consumed == aNumInputs)
+					return produced;
+				push(aInput[consumed++]);
+				phase_ -= upFactor_;
+			}
+			aOutput[produced++] = dot(&coefficients_[phase_ * tapsPerPhase_]);
+			phase_ += downFactor_;
+		}
+		return produced;
+	}
+
+	uint32_t getLatency() const
+	{
+		return tapsPerPhase_ / 2;
+	}
+	uint32_t getHistoryLength() const
+	{
+		return tapsPerPhase_;
+	}
+};
+
+//Runs the simulation at its own rate inside a device block. Each excitation point is taken down to the simulation rate
+//into a small pending queue, the number of steps is chosen so the output side yields exactly the device block, and the
+//steps' output is taken back up. Both directions share one ratio so the queue only ever drifts by a sample or two. Every
+//point's resampler sees the same sample counts, so one pending count serves all of them. A block may carry fewer points
+//than the last - The steps keep the dropped rows until their filters have flushed, so a finished strike keeps its tail.
+class SimulationRateConverter
+{
+private:
+	std::vector<PolyphaseResampler> toSimulation_;	//One per excitation point.
+	PolyphaseResampler toDevice_;
+	uint32_t points_;
+	uint32_t maxSteps_;
+
+	std::vector<float> pending_;		//Per point rows of excitation at the simulation rate not yet stepped.
+	uint32_t pendingCapacity_;
+	uint32_t pendingCount_;
+	std::vector<float> silence_;		//Input for points the block does not use.
+	std::vector<float> stepExcitation_;	//Per point rows of maxSteps_.
+	std::vector<float> stepOutput_;
+	uint32_t steps_;
+
+	//Device samples of silence after which the history and pending queue can only hold zeros//
+	uint32_t flushLength_;
+	uint32_t quietSamples_;
+	std::vector<uint32_t> pointQuiet_;	//Device samples since each point was last given, up to flushLength_.
+	uint32_t stepPoints_;
+public:
+	SimulationRateConverter(uint32_t aDeviceRate, uint32_t aSimulationRate, uint32_t aMaxDeviceBlock, uint32_t aPoints) :
+		toSimulation_(aPoints, PolyphaseResampler(aDeviceRate, aSimulationRate)),
+		toDevice_(aSimulationRate, aDeviceRate),
+		points_(aPoints),
+		maxSteps_(toSimulation_[0].getMaxOutput(aMaxDeviceBlock) + 1),
+		pending_(maxSteps_ * 4 * aPoints, 0.0f),
+		pendingCapacity_(maxSteps_ * 4),
+		pendingCount_(2),	//Primed so the first blocks never pad.
+		silence_(aMaxDeviceBlock, 0.0f),
+		stepExcitation_(maxSteps_ * aPoints, 0.0f),
+		stepOutput_(maxSteps_, 0.0f),
+		steps_(0),
+		flushLength_(toSimulation_[0].getHistoryLength() + aMaxDeviceBlock * 2 + 4),
+		quietSamples_(0),
+		pointQuiet_(aPoints, flushLength_),
+		stepPoints_(0)
+	{
+	}
+
+	uint32_t getMaxSteps() const
+	{
+		return maxSteps_;
+	}
+
+	//Converts aNumSamples of device excitation (aPoints rows of aStride) and returns how many simulation steps to run//
+	uint32_t beginBlock(const float* aExcitation, uint32_t aStride, uint32_t aPoints, uint32_t aNumSamples, uint32_t aExcitationLength)
+	{
+		quietSamples_ = aExcitationLength == 0 ? quietSamples_ + aNumSamples : 0;
+		if (quietSamples_ > flushLength_)
+			quietSamples_ = flushLength_;
+
+		steps_ = toDevice_.getRequiredInput(aNumSamples);
+		const uint32_t space = pendingCapacity_ - pendingCount_;
+		uint32_t produced = 0;
+		stepPoints_ = aPoints;
+		for (uint32_t p = 0; p != points_; ++p)
+		{
+			pointQuiet_[p] = p < aPoints ? 0 : std::min(pointQuiet_[p] + aNumSamples, flushLength_);
+			if (pointQuiet_[p] < flushLength_)
+				stepPoints_ = std::max(stepPoints_, p + 1);
+			const float* input = p < aPoints ? aExcitation + p * aStride : silence_.data();
+			float* pending = &pending_[p * pendingCapacity_];
+			produced = toSimulation_[p].process(input, aNumSamples, pending + pendingCount_, space);
+
+			const uint32_t queued = pendingCount_ + produced;
+			const uint32_t available = steps_ < queued ? steps_ : queued;
+			float* step = &stepExcitation_[p * maxSteps_];
+			memcpy(step, pending, available * sizeof(float));
+			memset(step + available, 0, (steps_ - available) * sizeof(float));
+			memmove(pending, pending + available, (queued - available) * sizeof(float));
+		}
+		const uint32_t queued = pendingCount_ + produced;
+		pendingCount_ = queued - (steps_ < queued ? steps_ : queued);
+		return steps_;
+	}
+	//Steps whose excitation may be non-zero - Either all of them or, once the filters have flushed, none//
+	uint32_t getStepExcitationLength() const
+	{
+		return quietSamples_ >= flushLength_ ? 0 : steps_;
+	}
+	//Rows of the step excitation to add - At least the block's points, plus any dropped ones still flushing//
+	uint32_t getStepPoints() const
+	{
+		return stepPoints_;
+	}
+	float* getStepExcitation()
+	{
+		return stepExcitation_.data();
+	}
+	uint32_t getStepStride() const
+	{
+		return maxSteps_;
+	}
+	float* getStepOutput()
+	{
+		return stepOutput_.data();
+	}
+
+	//Takes the steps' output back to exactly aNumSamples at the device rate//
+	void endBlock(float* aOutput, uint32_t aNumSamples)
+	{
+		toDevice_.process(stepOutput_.data(), steps_, aOutput, aNumSamples);
+	}
+};
+
+#endif
@@ -0,0 +1,50 @@
+#include "Realtime_Check.hpp"
+
+#if FDTD_REALTIME_CHECKS
+
+#include <cstdlib>
+#include <new>
+
+//Global allocation hooks - Assert if anything allocates or frees inside a ScopedRealtimeSection//
+void* operator new(std::size_t aSize)
+{
+	realtimeAssertNoAllocation();
+	void* memory = std::malloc(aSize ? aSize : 1);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+	return memory;
+}
+void* operator new[](std::size_t aSize)
+{
+	return operator new(aSize);
+}
+void* operator new(std::size_t aSize, const std::nothrow_t&) noexcept
+{
+	realtimeAssertNoAllocation();
+	return std::malloc(aSize ? aSize : 1);
+}
+void* operator new[](std::size_t aSize, const std::nothrow_t&) noexcept
+{
+	return operator new(aSize, std::nothrow);
+}
+
+void operator delete(void* aMemory) noexcept
+{
+	if (aMemory != nullptr)
+		realtimeAssertNoAllocation();
+	std::free(aMemory);
+}
+void operator delete[](void* aMemory) noexcept
+{
+	operator delete(aMemory);
+}
+void operator delete(void* aMemory, std::size_t) noexcept
+{
+	operator delete(aMemory);
+}
+void operator delete[](void* aMemory, std::size_t) noexcept
+{
+	operator delete(aMemory);
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef REALTIME_CHECK_HPP
+#define REALTIME_CHECK_HPP
+
+#include <cassert>
+#include <atomic>
+#include <stdint.h>
+
+//Debug checks for code that must stay wait-free. A ScopedRealtimeSection marks the current thread as real-time; while it
+//is alive the operator new/delete replacements in Realtime_Check.cpp assert, as does realtimeAssertNonBlocking() which
+//blocking calls (locks, blocking device transfers) use to guard themselves. Compiled out when NDEBUG is defined.
+#if !defined(FDTD_REALTIME_CHECKS)
+#if defined(NDEBUG)
+#define FDTD_REALTIME_CHECKS 0
+#else
+#define FDTD_REALTIME_CHECKS 1
+#endif
+#endif
+
+//Not static - One counter per thread shared by every translation unit//
+inline int& realtimeSectionDepth()
+{
+	static thread_local int depth = 0;
+	return depth;
+}
+
+inline bool isRealtimeThread()
+{
+	return realtimeSectionDepth() > 0;
+}
+
+inline void realtimeAssertNonBlocking(const char* aWhat)
+{
+#if FDTD_REALTIME_CHECKS
+	assert(!isRealtimeThread() && aWhat);
+#endif
+	(void)aWhat;
+}
+
+//Allocations and frees caught inside real-time sections. Debug builds assert on the first; a release build with
+//FDTD_REALTIME_CHECKS=1 only counts, so a soak test can run the engine and fail on anything but 0//
+inline std::atomic<uint64_t>& realtimeAllocationCount()
+{
+	static std::atomic<uint64_t> count(0);
+	return count;
+}
+
+inline void realtimeAssertNoAllocation()
+{
+#if FDTD_REALTIME_CHECKS
+	if (isRealtimeThread())
+		realtimeAllocationCount().fetch_add(1, std::memory_order_relaxed);
+	assert(!isRealtimeThread() && "Allocation inside a real-time section.");
+#endif
+}
+
+struct ScopedRealtimeSection
+{
+	ScopedRealtimeSection()
+	{
+		++realtimeSectionDepth();
+	}
+	~ScopedRealtimeSection()
+	{
+		--realtimeSectionDepth();
+	}
+	ScopedRealtimeSection(const ScopedRealtimeSection&) = delete;
+	ScopedRealtimeSection& operator=(const ScopedRealtimeSection&) = delete;
+};
+
+//Temporarily lifts the checks, e.g. for a deliberate one-off allocation during a device reset//
+struct ScopedRealtimeExemption
+{
+	int saved_;
+	ScopedRealtimeExemption() : saved_(realtimeSectionDepth())
+	{
+		realtimeSectionDepth() = 0;
+	}
+	~ScopedRealtimeExemption()
+	{
+		realtimeSectionDepth() = saved_;
+	}
+	ScopedRealtimeExemption(const ScopedRealtimeExemption&) = delete;
+	ScopedRealtimeExemption& operator=(const ScopedRealtimeExemption&) = delete;
+};
+
+#endif
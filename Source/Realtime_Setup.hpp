@@ -0,0 +1,118 @@
+#ifndef REALTIME_SETUP_HPP
+#define REALTIME_SETUP_HPP
+
+#include <stdint.h>
+#include <string.h>
+#include <iostream>
+
+#if defined(__linux__)
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <malloc.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#endif
+
+//Scheduling for one engine thread - Applied by the thread itself as it starts//
+struct ThreadPolicy
+{
+	int priority_ = 0;		//SCHED_FIFO priority, 1-99. 0 leaves the thread on the normal scheduler.
+	int cpu_ = -1;			//CPU to pin to. -1 lets it run anywhere.
+};
+
+//What MainComponent asks for. Every part is best effort - Without the privileges for it the setup reports what it could
+//not apply and the engine carries on as a normal process.
+struct RealtimeSetup
+{
+	bool lockMemory_ = false;
+	ThreadPolicy simulation_;
+	ThreadPolicy render_;
+	ThreadPolicy input_;
+	ThreadPolicy control_;
+};
+
+//Touches the next 256KB of stack so a real-time thread never takes a page fault growing into it mid block//
+static void prefaultStack()
+{
+	volatile char stack[256 * 1024];
+	for (size_t i = 0; i < sizeof(stack); i += 4096)
+		stack[i] = 0;
+}
+
+//Called on the thread to configure. Returns true only if everything asked for was applied//
+static bool applyThreadPolicy(const char* aName, const ThreadPolicy& aPolicy)
+{
+	if (aPolicy.priority_ == 0 && aPolicy.cpu_ < 0)
+		return true;
+
+#if defined(__linux__)
+	bool applied = true;
+	if (aPolicy.priority_ > 0)
+	{
+		sched_param parameters = {};
+		parameters.sched_priority = aPolicy.priority_;
+		const int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters);
+		if (result == 0)
+		{
+			std::cout << "Realtime: " << aName << " thread running SCHED_FIFO at priority " << aPolicy.priority_ << std::endl;
+			prefaultStack();
+		}
+		else
+		{
+			std::cout << "Realtime: " << aName << " thread left on the normal scheduler - SCHED_FIFO " << aPolicy.priority_
+				<< " refused (" << strerror(result) << "). Grant rtprio in /etc/security/limits.conf or CAP_SYS_NICE." << std::endl;
+			applied = false;
+		}
+	}
+	if (aPolicy.cpu_ >= 0)
+	{
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		CPU_SET(aPolicy.cpu_, &cpus);
+		const int result = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+		if (result == 0)
+		{
+			std::cout << "Realtime: " << aName << " thread pinned to CPU " << aPolicy.cpu_ << std::endl;
+		}
+		else
+		{
+			std::cout << "Realtime: " << aName << " thread not pinned to CPU " << aPolicy.cpu_ << " (" << strerror(result) << ")." << std::endl;
+			applied = false;
+		}
+	}
+	return applied;
+#else
+	std::cout << "Realtime: " << aName << " thread policy not supported on this platform." << std::endl;
+	return false;
+#endif
+}
+
+//Keeps everything already allocated resident and, where the memlock limit allows, everything allocated later too. malloc
+//is told not to hand freed memory back, so block resources rebuilt on a device restart reuse pages that are already
+//faulted in. The engine's buffers are value initialised as they are allocated, so locking is all it takes to pre-fault
+//them - Call once the model is loaded and prepared.
+static bool lockProcessMemory()
+{
+#if defined(__linux__)
+	mallopt(M_TRIM_THRESHOLD, -1);
+	mallopt(M_MMAP_MAX, 0);
+
+	//MCL_FUTURE under a finite limit turns later allocations into failures once the limit is reached//
+	rlimit limit = {};
+	const bool unlimited = getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur == RLIM_INFINITY;
+	const int flags = unlimited ? MCL_CURRENT | MCL_FUTURE : MCL_CURRENT;
+	if (mlockall(flags) != 0)
+	{
+		std::cout << "Realtime: memory not locked (" << strerror(errno) << "). Raise memlock in /etc/security/limits.conf." << std::endl;
+		return false;
+	}
+	std::cout << "Realtime: memory locked" << (unlimited ? ", including future allocations." : " - Future allocations are not (memlock limit is finite).") << std::endl;
+	return true;
+#else
+	std::cout << "Realtime: memory locking not supported on this platform." << std::endl;
+	return false;
+#endif
+}
+
+#endif
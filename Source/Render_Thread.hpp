@@ -0,0 +1,174 @@
+#ifndef RENDER_THREAD_HPP
+#define RENDER_THREAD_HPP
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "FDTD_Backend.hpp"
+#include "Triple_Buffer.hpp"
+#include "Visualizer.hpp"
+#include "Trace_Recorder.hpp"
+#include "Realtime_Setup.hpp"
+
+//Owns the Visualizer and its GL context on a dedicated thread. Consumes field snapshots published by the engine through
+//the triple buffer, so the audio thread never waits on a readback, texture upload or buffer swap.
+class RenderThread
+{
+private:
+	//An engine's snapshots - Sources smaller than the first are scaled up to it here, off the audio thread//
+	struct Source
+	{
+		TripleBuffer<FieldSnapshot>* snapshots_;
+		const float* boundaryGrid_;
+		uint32_t width_;
+		uint32_t height_;
+		float gain_;
+	};
+
+	std::vector<Source> sources_;
+	uint32_t width_;
+	uint32_t height_;
+	uint32_t framesPerSecond_;
+
+	std::thread thread_;
+	std::atomic<bool> running_;
+	std::atomic<uint32_t> source_;
+	std::atomic<uint64_t> framesRendered_;
+	ThreadPolicy policy_;
+
+	//Nearest neighbour up to the first source's size//
+	void scale(const Source& aSource, const float* aGrid, float aGain, float* aScaled) const
+	{
+		for (uint32_t y = 0; y != height_; ++y)
+		{
+			const float* row = aGrid + (y * aSource.height_ / height_) * aSource.width_;
+			for (uint32_t x = 0; x != width_; ++x)
+				aScaled[y * width_ + x] = row[x * aSource.width_ / width_] * aGain;
+		}
+	}
+
+	void run()
+	{
+		TraceRecorder::get().registerThread("Render");
+		applyThreadPolicy("Render", policy_);
+
+		//GL context is created and only ever made current on this thread//
+		Visualizer* vis = new Visualizer(width_, height_);
+
+		const std::chrono::microseconds framePeriod(1000000 / framesPerSecond_);
+		auto nextFrame = std::chrono::steady_clock::now();
+		bool pendingDraw = false;
+		uint32_t drawing = UINT32_MAX;
+		std::vector<float> field(width_ * height_);
+		std::vector<float> boundary(width_ * height_);
+		while (running_.load(std::memory_order_acquire))
+		{
+			const uint32_t source = source_.load(std::memory_order_relaxed);
+			if (source != drawing)
+			{
+				drawing = source;
+				pendingDraw = false;
+			}
+			const Source& current = sources_[drawing];
+			const bool scaled = current.width_ != width_ || current.height_ != height_;
+
+			//Draw each published snapshot once, as soon as its copy has landed//
+			if (current.snapshots_->update())
+				pendingDraw = true;
+			FieldSnapshot& snapshot = current.snapshots_->readSlot();
+			if (pendingDraw && snapshot.isComplete())
+			{
+				TRACE_SCOPE("draw frame");
+				//Display snapshots are drawn at their own size, coloured here when the backend left that to the host. Field
+				//snapshots bring the boundary too, as shape edits can change it at any time//
+				if (snapshot.pixels_ != nullptr)
+				{
+					if (!snapshot.coloured_)
+					{
+						DisplayFormat format;
+						format.fieldWidth_ = current.width_;
+						format.fieldHeight_ = current.height_;
+						format.width_ = snapshot.pixelWidth_;
+						format.height_ = snapshot.pixelHeight_;
+						format.gain_ = current.gain_;
+						colormapField(snapshot.field_, format, snapshot.pixels_);
+					}
+					vis->renderPixels(snapshot.pixels_, snapshot.pixelWidth_, snapshot.pixelHeight_);
+				}
+				else
+				{
+					if (scaled)
+					{
+						scale(current, snapshot.field_, current.gain_, field.data());
+						scale(current, current.boundaryGrid_, 1.0f, boundary.data());
+					}
+					vis->render(scaled ? field.data() : snapshot.field_, scaled ? boundary.data() : const_cast<float*>(current.boundaryGrid_));
+				}
+				framesRendered_.fetch_add(1, std::memory_order_relaxed);
+				pendingDraw = false;
+			}
+
+			nextFrame += framePeriod;
+			std::this_thread::sleep_until(nextFrame);
+		}
+
+		delete vis;
+	}
+public:
+	RenderThread(TripleBuffer<FieldSnapshot>& aSnapshots, const float* aBoundaryGrid, uint32_t aWidth, uint32_t aHeight, uint32_t aFramesPerSecond) :
+		width_(aWidth),
+		height_(aHeight),
+		framesPerSecond_(aFramesPerSecond),
+		running_(false),
+		source_(0),
+		framesRendered_(0)
+	{
+		addSource(aSnapshots, aBoundaryGrid, aWidth, aHeight);
+	}
+	~RenderThread()
+	{
+		stop();
+	}
+
+	//Call before start()//
+	void setThreadPolicy(const ThreadPolicy& aPolicy)
+	{
+		policy_ = aPolicy;
+	}
+	//Another engine to draw from, no larger than the first, e.g. a coarser level of a ResolutionLadder. Its field is scaled
+	//by its cell count relative to the first, as the ladder scales its output. Returns its index//
+	uint32_t addSource(TripleBuffer<FieldSnapshot>& aSnapshots, const float* aBoundaryGrid, uint32_t aWidth, uint32_t aHeight)
+	{
+		const float gain = (float)((double)aWidth * aHeight / ((double)width_ * height_));
+		sources_.push_back({ &aSnapshots, aBoundaryGrid, aWidth, aHeight, gain });
+		return (uint32_t)sources_.size() - 1;
+	}
+
+	//Any thread - Draws from source aSource from the next frame//
+	void setSource(uint32_t aSource)
+	{
+		if (aSource < sources_.size())
+			source_.store(aSource, std::memory_order_relaxed);
+	}
+
+	void start()
+	{
+		running_.store(true, std::memory_order_release);
+		thread_ = std::thread(&RenderThread::run, this);
+	}
+	void stop()
+	{
+		running_.store(false, std::memory_order_release);
+		if (thread_.joinable())
+			thread_.join();
+	}
+
+	uint64_t getFramesRendered() const
+	{
+		return framesRendered_.load(std::memory_order_relaxed);
+	}
+};
+
+#endif
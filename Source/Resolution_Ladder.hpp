@@ -0,0 +1,512 @@
+#ifndef RESOLUTION_LADDER_HPP
+#define RESOLUTION_LADDER_HPP
+
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "FDTD_Accelerated.hpp"
+#include "Engine_Handoff.hpp"
+#include "Deadline_Monitor.hpp"
+#include "Realtime_Check.hpp"
+
+//When the ladder moves between levels. Loads are the time spent rendering a block over the real time of the audio it
+//rendered, smoothed across blocks - 1.0 is a block that only just made its deadline//
+struct ResolutionPolicy
+{
+	bool adaptive_ = true;			//False stays on whichever level requestLevel() last chose.
+	double lowerAbove_ = 0.7;		//Steps down a level once the load has stayed above this for holdBlocks_.
+	double raiseBelow_ = 0.3;		//Steps up once it has stayed below this, unless the finer level was recently measured over lowerAbove_.
+	uint32_t holdBlocks_ = 32;
+	uint32_t retryBlocks_ = 8192;	//Age at which a finer level's measured load no longer keeps the ladder off it.
+	uint32_t maxWaitBlocks_ = 64;	//Blocks a switch waits for a gap between notes before crossfading anyway.
+	float quietLevel_ = 0.001f;		//Output peak under which a block with no strike sounding counts as a gap.
+	double crossfadeMs_ = 10.0;
+};
+
+//One instrument as models of falling resolution, finest first, each a complete engine. The rendering thread times every
+//block and moves down a level when the load runs high, or back up when there is headroom. A switch waits for a gap
+//between notes where it can, then crossfades from the old level to the new one, running both for crossfadeMs_. The new
+//level starts from rest, so anything still ringing fades out with the old one.
+//Everything outside is in the finest level's terms - Positions are on its grid and coefficients are the values it takes.
+//Each level maps them to its own grid, and scales lambda and its output by its cell count relative to the finest level.
+//This keeps the modes at the same pitch, and strikes at the same loudness, on every level.
+class ResolutionLadder
+{
+private:
+	struct Level
+	{
+		FDTD_Accelerated* engine_ = nullptr;
+		int width_ = 0;
+		int height_ = 0;
+		float scale_ = 1.0f;		//Cells relative to the finest level.
+		double load_ = -1.0;		//Smoothed load when it last ran - Negative until it has.
+		uint64_t loadBlock_ = 0;	//Block load_ was measured at.
+	};
+
+	//Crossfade scratch sized by prepare() and swapped in whole, as the engines swap their block resources//
+	struct LadderResources
+	{
+		uint32_t maxBlockSize_ = 0;
+		uint32_t maxPoints_ = 0;
+		uint32_t crossfadeSamples_ = 1;
+		double sampleRate_ = 0.0;
+		std::vector<float> excitation_;		//The chunk's excitation as rendered, replayed into the outgoing level.
+		std::vector<int> positions_;		//Finest grid.
+		uint32_t points_ = 0;
+		uint32_t length_ = 0;
+		std::vector<float> output_;			//Outgoing level's output, before mixing.
+	};
+
+	//Stability limit of the explicit scheme on a square grid - Lambdas scaled past it are clamped//
+	static constexpr float MAX_PROPAGATION = 0.5f;
+	static constexpr double LOAD_SMOOTHING = 0.125;
+
+	Implementation implementation_;
+	uint32_t bufferFrames_;
+	float gridSpacing_;
+	bool hugePages_ = false;
+	std::string cacheDirectory_;
+	uint64_t cacheBytes_ = ModelCache::DEFAULT_MAX_BYTES;
+
+	std::vector<Level> levels_;
+	ResolutionPolicy policy_;
+	EngineHandoff<LadderResources> resources_;
+
+	//Rendering thread//
+	int fadingFrom_ = -1;		//Outgoing level while a crossfade runs.
+	uint32_t fadePosition_ = 0;
+	int pending_ = -1;			//Level a switch is waiting to go to.
+	uint32_t waited_ = 0;
+	double load_ = 0.0;
+	uint32_t above_ = 0;
+	uint32_t below_ = 0;
+	uint64_t blocks_ = 0;
+
+	//Published//
+	std::atomic<uint32_t> active_;
+	std::atomic<int> requested_;
+	std::atomic<uint64_t> switches_;
+
+	//lambdaOne and lambdaTwo - Indexed as the fdtdKernel arguments//
+	static bool isPropagation(uint32_t aIndex)
+	{
+		return aIndex == 10 || aIndex == 11;
+	}
+	static float levelCoefficient(const Level& aLevel, uint32_t aIndex, float aValue)
+	{
+		return isPropagation(aIndex) ? std::min(aValue * aLevel.scale_, MAX_PROPAGATION) : aValue;
+	}
+	int levelX(const Level& aLevel, int aX) const
+	{
+		return aX * aLevel.width_ / levels_[0].width_;
+	}
+	int levelY(const Level& aLevel, int aY) const
+	{
+		return aY * aLevel.height_ / levels_[0].height_;
+	}
+	int levelPosition(const Level& aLevel, int aPosition) const
+	{
+		if (aLevel.width_ == levels_[0].width_ && aLevel.height_ == levels_[0].height_)
+			return aPosition;
+		const int width = levels_[0].width_;
+		return aLevel.engine_->getFlatPosition(levelX(aLevel, aPosition % width), levelY(aLevel, aPosition / width));
+	}
+
+	FDTD_Accelerated* createEngine()
+	{
+		FDTD_Accelerated* engine = new FDTD_Accelerated(implementation_, bufferFrames_, gridSpacing_);
+		engine->setHugePages(hugePages_);
+		engine->setModelCache(cacheDirectory_, cacheBytes_);
+		return engine;
+	}
+	void addLevel(FDTD_Accelerated* aEngine, const std::string& aName)
+	{
+		Level level;
+		level.engine_ = aEngine;
+		level.width_ = aEngine->getModelWidth();
+		level.height_ = aEngine->getModelHeight();
+		if (!levels_.empty() && (level.width_ > levels_.back().width_ || level.height_ > levels_.back().height_))
+			std::cout << "ERROR resolution ladder level " << aName << " is finer than the one before it." << std::endl;
+		levels_.push_back(level);
+	}
+	void finishLevels(uint32_t aInputPosition[2])
+	{
+		if (levels_.empty())
+		{
+			std::cout << "ERROR resolution ladder has no models." << std::endl;
+			return;
+		}
+		for (Level& level : levels_)
+		{
+			level.scale_ = (float)((double)level.width_ * level.height_ / ((double)levels_[0].width_ * levels_[0].height_));
+			int input[2] = { levelX(level, (int)aInputPosition[0]), levelY(level, (int)aInputPosition[1]) };
+			level.engine_->setInputPosition(input);
+			std::cout << "Resolution level " << &level - levels_.data() << ": " << level.width_ << "x" << level.height_ << ", scale " << level.scale_ << std::endl;
+		}
+		buildResources(levels_[0].engine_->getMaxBlockSize(), levels_[0].engine_->getSampleRate());
+	}
+
+	void buildResources(uint32_t aMaxBlockSize, double aSampleRate)
+	{
+		LadderResources* resources = new LadderResources();
+		resources->maxBlockSize_ = aMaxBlockSize > 0 ? aMaxBlockSize : 1;
+		resources->maxPoints_ = levels_.empty() ? 1 : levels_[0].engine_->getMaxExcitationPoints();
+		resources->crossfadeSamples_ = std::max(1u, (uint32_t)(policy_.crossfadeMs_ * aSampleRate / 1000.0));
+		resources->sampleRate_ = aSampleRate;
+		resources->excitation_.assign((size_t)resources->maxBlockSize_ * resources->maxPoints_, 0.0f);
+		resources->positions_.assign(resources->maxPoints_, 0);
+		resources->output_.assign(resources->maxBlockSize_, 0.0f);
+		delete resources_.exchange(resources);
+	}
+
+	//One chunk of at most the prepared block size - The active level renders into aOutput, and while a crossfade runs the
+	//outgoing level replays the same excitation into the scratch and is mixed in. Returns whether anything was struck//
+	template<class ExcitationRenderer>
+	bool renderChunk(ExcitationRenderer& aRenderExcitation, LadderResources* aScratch, float* aOutput, uint32_t aNumSteps, uint32_t aQueued)
+	{
+		Level& level = levels_[active_.load(std::memory_order_relaxed)];
+		const bool fading = fadingFrom_ >= 0 && aScratch != nullptr;
+		bool struck = false;
+		level.engine_->renderBlock([&](ExcitationBlock& aBlock, uint32_t aNumSamples) -> uint32_t
+		{
+			const uint32_t span = aRenderExcitation(aBlock, aNumSamples);
+			struck |= span != 0;
+			if (fading)
+			{
+				aScratch->points_ = std::min(aBlock.points_, aScratch->maxPoints_);
+				aScratch->length_ = std::min(span, aScratch->maxBlockSize_);
+				for (uint32_t p = 0; p != aScratch->points_; ++p)
+				{
+					memcpy(&aScratch->excitation_[p * aScratch->maxBlockSize_], aBlock.samples_ + p * aBlock.stride_, aScratch->length_ * sizeof(float));
+					aScratch->positions_[p] = aBlock.positions_[p];
+				}
+			}
+			for (uint32_t p = 0; p != aBlock.points_; ++p)
+				aBlock.positions_[p] = levelPosition(level, aBlock.positions_[p]);
+			return span;
+		}, aOutput, aNumSteps, aQueued);
+
+		if (!fading)
+		{
+			if (level.scale_ != 1.0f)
+				for (uint32_t i = 0; i != aNumSteps; ++i)
+					aOutput[i] *= level.scale_;
+			return struck;
+		}
+
+		Level& outgoing = levels_[fadingFrom_];
+		float* fadeOutput = aScratch->output_.data();
+		outgoing.engine_->renderBlock([&](ExcitationBlock& aBlock, uint32_t aNumSamples) -> uint32_t
+		{
+			const uint32_t points = std::min(aScratch->points_, aBlock.points_);
+			const uint32_t length = std::min(aScratch->length_, aNumSamples);
+			for (uint32_t p = 0; p != points; ++p)
+			{
+				memcpy(aBlock.samples_ + p * aBlock.stride_, &aScratch->excitation_[p * aScratch->maxBlockSize_], length * sizeof(float));
+				aBlock.positions_[p] = levelPosition(outgoing, aScratch->positions_[p]);
+			}
+			aBlock.points_ = points;
+			return length;
+		}, fadeOutput, aNumSteps, aQueued);
+
+		//Linear - Both levels play the same instrument//
+		const uint32_t fadeLength = aScratch->crossfadeSamples_;
+		for (uint32_t i = 0; i != aNumSteps; ++i)
+		{
+			const float in = fadePosition_ < fadeLength ? (float)fadePosition_++ / fadeLength : 1.0f;
+			aOutput[i] = aOutput[i] * level.scale_ * in + fadeOutput[i] * outgoing.scale_ * (1.0f - in);
+		}
+		if (fadePosition_ >= fadeLength)
+			fadingFrom_ = -1;
+		return struck;
+	}
+
+	void switchLevel(int aLevel)
+	{
+		const uint32_t from = active_.load(std::memory_order_relaxed);
+		levels_[aLevel].engine_->clearField();
+		load_ = load_ * levels_[aLevel].scale_ / levels_[from].scale_;
+		fadingFrom_ = (int)from;
+		fadePosition_ = 0;
+		pending_ = -1;
+		waited_ = 0;
+		above_ = 0;
+		below_ = 0;
+		active_.store((uint32_t)aLevel, std::memory_order_relaxed);
+		switches_.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	//End of every block - Measures it, decides whether a switch is due and starts one at a gap between notes//
+	void updateLevel(double aLoad, bool aQuiet)
+	{
+		++blocks_;
+		const int active = (int)active_.load(std::memory_order_relaxed);
+		Level& level = levels_[active];
+
+		//Blocks that ran two levels say nothing about either//
+		if (fadingFrom_ < 0)
+		{
+			load_ += (aLoad - load_) * LOAD_SMOOTHING;
+			level.load_ = load_;
+			level.loadBlock_ = blocks_;
+		}
+
+		const int requested = requested_.exchange(-1, std::memory_order_relaxed);
+		if (requested >= 0 && requested < (int)levels_.size())
+		{
+			pending_ = requested != active ? requested : -1;
+			waited_ = 0;
+		}
+		else if (policy_.adaptive_ && fadingFrom_ < 0 && pending_ < 0)
+		{
+			above_ = load_ > policy_.lowerAbove_ ? above_ + 1 : 0;
+			below_ = load_ < policy_.raiseBelow_ ? below_ + 1 : 0;
+			if (above_ >= policy_.holdBlocks_ && active + 1 < (int)levels_.size())
+			{
+				pending_ = active + 1;
+			}
+			else if (below_ >= policy_.holdBlocks_ && active > 0)
+			{
+				const Level& finer = levels_[active - 1];
+				if (finer.load_ < policy_.lowerAbove_ || blocks_ - finer.loadBlock_ > policy_.retryBlocks_)
+					pending_ = active - 1;
+				below_ = 0;
+			}
+		}
+
+		//A block over its deadline does not wait for a gap to drop a level//
+		if (pending_ < 0 || fadingFrom_ >= 0)
+			return;
+		if (aQuiet || ++waited_ >= policy_.maxWaitBlocks_ || (pending_ > active && aLoad > 1.0))
+			switchLevel(pending_);
+	}
+public:
+	ResolutionLadder(Implementation aImplementation, uint32_t aBufferFrames, float aGridSpacing) :
+		implementation_(aImplementation),
+		bufferFrames_(aBufferFrames),
+		gridSpacing_(aGridSpacing),
+		active_(0),
+		requested_(-1),
+		switches_(0)
+	{
+	}
+	~ResolutionLadder()
+	{
+		delete resources_.exchange(nullptr);
+		for (Level& level : levels_)
+			delete level.engine_;
+	}
+
+	//Setup - Call before createModels()//
+	void setHugePages(bool aHugePages)
+	{
+		hugePages_ = aHugePages;
+	}
+	void setModelCache(const std::string& aDirectory, uint64_t aMaxBytes = ModelCache::DEFAULT_MAX_BYTES)
+	{
+		cacheDirectory_ = aDirectory;
+		cacheBytes_ = aMaxBytes;
+	}
+	//Call before the ladder is published to the rendering thread//
+	void setPolicy(const ResolutionPolicy& aPolicy)
+	{
+		policy_ = aPolicy;
+	}
+
+	//Builds an engine per model, finest first - The first is the level everything outside the ladder is expressed in//
+	void createModels(const std::vector<std::string>& aPaths, float aBoundaryValue, uint32_t aInputPosition[2], uint32_t aOutputPosition[2])
+	{
+		realtimeAssertNonBlocking("createModels called from a real-time thread.");
+		for (const std::string& path : aPaths)
+		{
+			FDTD_Accelerated* engine = createEngine();
+			engine->createModel(path, aBoundaryValue, aInputPosition, aOutputPosition);
+			addLevel(engine, path);
+		}
+		finishLevels(aInputPosition);
+	}
+	//Every level rasterised from one geometry - aSizes are width and height, finest first//
+	void createModels(const ModelGeometry& aGeometry, const std::vector<std::pair<int, int>>& aSizes, float aBoundaryValue, uint32_t aInputPosition[2], uint32_t aOutputPosition[2])
+	{
+		realtimeAssertNonBlocking("createModels called from a real-time thread.");
+		for (const std::pair<int, int>& size : aSizes)
+		{
+			FDTD_Accelerated* engine = createEngine();
+			engine->createModel(aGeometry, size.first, size.second, aBoundaryValue, aInputPosition, aOutputPosition);
+			addLevel(engine, std::to_string(size.first) + "x" + std::to_string(size.second));
+		}
+		finishLevels(aInputPosition);
+	}
+
+	//As FDTD_Accelerated - Every level is prepared alike, off the audio thread//
+	void prepare(uint32_t aMaxBlockSize, double aSampleRate)
+	{
+		realtimeAssertNonBlocking("prepare called from a real-time thread.");
+		for (Level& level : levels_)
+			level.engine_->prepare(aMaxBlockSize, aSampleRate);
+		buildResources(aMaxBlockSize, aSampleRate);
+	}
+	void setSimulationRate(double aSimulationRate)
+	{
+		for (Level& level : levels_)
+			level.engine_->setSimulationRate(aSimulationRate);
+	}
+	void setMaxExcitationPoints(uint32_t aMaxPoints)
+	{
+		for (Level& level : levels_)
+			level.engine_->setMaxExcitationPoints(aMaxPoints);
+		buildResources(getMaxBlockSize(), getSampleRate());
+	}
+	void setDeadlineMonitor(DeadlineMonitor* aMonitor)
+	{
+		for (Level& level : levels_)
+			level.engine_->setDeadlineMonitor(aMonitor);
+	}
+	//Every level draws at the same display size, its field scaled as the output is - See FDTD_Accelerated::setDisplaySize.
+	//After createModels()//
+	void setDisplaySize(int aWidth, int aHeight)
+	{
+		for (Level& level : levels_)
+			level.engine_->setDisplaySize(aWidth, aHeight, level.scale_);
+	}
+
+	//As FDTD_Accelerated::renderBlock, with positions on the finest grid. Levels not rendering take their queued
+	//coefficient changes here, so whichever is switched to is already up to date//
+	template<class ExcitationRenderer>
+	void renderBlock(ExcitationRenderer aRenderExcitation, float* output, uint32_t numSteps, uint32_t aQueued = 0)
+	{
+		const int64_t start = DeadlineMonitor::now();
+		EngineHandoff<LadderResources>::ReadScope resources(resources_);
+		LadderResources* scratch = resources.get();
+		const uint32_t active = active_.load(std::memory_order_relaxed);
+		for (size_t l = 0; l != levels_.size(); ++l)
+			if (l != active && (int)l != fadingFrom_)
+				levels_[l].engine_->applyParameterEvents();
+
+		bool struck = false;
+		const uint32_t chunk = scratch != nullptr ? scratch->maxBlockSize_ : numSteps;
+		for (uint32_t offset = 0; offset < numSteps; offset += chunk)
+			struck |= renderChunk(aRenderExcitation, scratch, output + offset, std::min(numSteps - offset, chunk), aQueued + offset);
+
+		float peak = 0.0f;
+		for (uint32_t i = 0; i != numSteps; ++i)
+			peak = std::max(peak, fabsf(output[i]));
+		const double seconds = scratch != nullptr ? numSteps / scratch->sampleRate_ : 0.0;
+		if (seconds > 0.0)
+			updateLevel((DeadlineMonitor::now() - start) * 1e-9 / seconds, !struck && peak < policy_.quietLevel_);
+	}
+	void publishFieldSnapshot()
+	{
+		levels_[active_.load(std::memory_order_relaxed)].engine_->publishFieldSnapshot();
+	}
+
+	//Any thread - Switches to aLevel at the next gap between notes, and with adaptive_ off stays there//
+	void requestLevel(uint32_t aLevel)
+	{
+		requested_.store((int)aLevel, std::memory_order_relaxed);
+	}
+	uint32_t getActiveLevel() const
+	{
+		return active_.load(std::memory_order_relaxed);
+	}
+	uint64_t getSwitches() const
+	{
+		return switches_.load(std::memory_order_relaxed);
+	}
+	uint32_t getNumLevels() const
+	{
+		return (uint32_t)levels_.size();
+	}
+	FDTD_Accelerated& getLevel(uint32_t aLevel)
+	{
+		return *levels_[aLevel].engine_;
+	}
+
+	//Coefficients as the finest level takes them//
+	void updateCoefficient(std::string aCoeff, uint32_t aIndex, float aValue)
+	{
+		for (Level& level : levels_)
+			level.engine_->updateCoefficient(aCoeff, aIndex, levelCoefficient(level, aIndex, aValue));
+	}
+	void applyCoefficient(uint32_t aIndex, float aValue)
+	{
+		for (Level& level : levels_)
+			level.engine_->applyCoefficient(aIndex, levelCoefficient(level, aIndex, aValue));
+	}
+
+	//Positions on the finest grid//
+	void setOutputPosition(int aOutputs[])
+	{
+		for (Level& level : levels_)
+		{
+			int outputs[2] = { levelX(level, aOutputs[0]), levelY(level, aOutputs[1]) };
+			level.engine_->setOutputPosition(outputs);
+		}
+	}
+	void movePickup(uint32_t aPickup, int aX, int aY)
+	{
+		for (Level& level : levels_)
+			level.engine_->movePickup(aPickup, levelX(level, aX), levelY(level, aY));
+	}
+	//Shape edits on the finest grid, painted into every level so a switch keeps the drawn shape//
+	void paintRectangle(int aX, int aY, int aWidth, int aHeight, int aId)
+	{
+		for (Level& level : levels_)
+		{
+			const int x = levelX(level, aX);
+			const int y = levelY(level, aY);
+			level.engine_->paintRectangle(x, y, std::max(1, levelX(level, aX + aWidth) - x), std::max(1, levelY(level, aY + aHeight) - y), aId);
+		}
+	}
+	void paintCircle(int aX, int aY, int aRadius, int aId)
+	{
+		for (Level& level : levels_)
+			level.engine_->paintCircle(levelX(level, aX), levelY(level, aY), levelX(level, aRadius), aId);
+	}
+	int getFlatPosition(int aX, int aY) const
+	{
+		return levels_[0].engine_->getFlatPosition(aX, aY);
+	}
+	int getModelWidth()
+	{
+		return levels_[0].width_;
+	}
+	int getModelHeight()
+	{
+		return levels_[0].height_;
+	}
+
+	const std::vector<ModelController>& getControllers() const
+	{
+		return levels_[0].engine_->getControllers();
+	}
+	const float* getDefaultExciter() const
+	{
+		return levels_[0].engine_->getDefaultExciter();
+	}
+	const std::vector<float>& getDefaultPickups() const
+	{
+		return levels_[0].engine_->getDefaultPickups();
+	}
+	uint32_t getMaxBlockSize() const
+	{
+		return levels_[0].engine_->getMaxBlockSize();
+	}
+	double getSampleRate() const
+	{
+		return levels_[0].engine_->getSampleRate();
+	}
+	const char* getBackendName() const
+	{
+		return levels_[0].engine_->getBackendName();
+	}
+};
+
+#endif
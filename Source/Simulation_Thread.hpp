@@ -0,0 +1,188 @@
+#ifndef SIMULATION_THREAD_HPP
+#define SIMULATION_THREAD_HPP
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <string.h>
+
+#include "Resolution_Ladder.hpp"
+#include "Engine_Handoff.hpp"
+#include "Spsc_Ring.hpp"
+#include "Latency_Monitor.hpp"
+#include "Realtime_Setup.hpp"
+#include "Realtime_Check.hpp"
+
+//Optional architecture where the engine runs ahead of the device on its own thread. Blocks are rendered into an SPSC ring
+//until it holds the target headroom; the audio callback only copies out of the ring, so compute jitter smaller than the
+//headroom never reaches the device. While running this thread is the only reader of the engine handoff.
+class SimulationThread
+{
+private:
+	EngineHandoff<ResolutionLadder>& engine_;
+	SpscRing<float> ring_;
+	uint32_t blockSize_;
+	std::vector<float> output_;
+
+	std::function<uint32_t(ExcitationBlock&, uint32_t)> renderExcitation_;	//As FDTD_Accelerated::renderBlock's renderer.
+	uint32_t snapshotInterval_ = 1000;
+	uint32_t samplesSinceSnapshot_ = 0;
+	LatencyMonitor* latencyMonitor_ = nullptr;
+	ThreadPolicy policy_;
+
+	std::thread thread_;
+	std::atomic<bool> running_;
+	std::atomic<uint32_t> targetHeadroom_;
+	std::atomic<uint64_t> underruns_;
+	std::atomic<uint64_t> underrunSamples_;
+	std::atomic<uint64_t> blocksRendered_;
+
+	void renderBlock()
+	{
+		ScopedRealtimeSection realtimeSection;
+		TRACE_SCOPE("render block");
+		EngineHandoff<ResolutionLadder>::ReadScope engine(engine_);
+		if (engine.get() == nullptr)
+		{
+			memset(output_.data(), 0, blockSize_ * sizeof(float));
+		}
+		else
+		{
+			//Events are timed behind the blocks already waiting in the ring//
+			std::function<uint32_t(ExcitationBlock&, uint32_t)>& render = renderExcitation_;
+			engine.get()->renderBlock([&render](ExcitationBlock& aBlock, uint32_t aNumSamples) -> uint32_t
+			{
+				if (!render)
+				{
+					aBlock.points_ = 0;
+					return 0;
+				}
+				return render(aBlock, aNumSamples);
+			}, output_.data(), blockSize_, (uint32_t)ring_.size());
+
+			samplesSinceSnapshot_ += blockSize_;
+			if (samplesSinceSnapshot_ > snapshotInterval_)
+			{
+				engine.get()->publishFieldSnapshot();
+				samplesSinceSnapshot_ = 0;
+			}
+		}
+		const uint32_t queued = ring_.size();
+		traceCounter("ring fill", queued);
+		ring_.write(output_.data(), blockSize_);
+		if (latencyMonitor_ != nullptr)
+			latencyMonitor_->blockDelivered(queued);
+		blocksRendered_.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void run()
+	{
+		TraceRecorder::get().registerThread("Simulation");
+		applyThreadPolicy("Simulation", policy_);
+		while (running_.load(std::memory_order_acquire))
+		{
+			//Render while below target and a whole block fits, otherwise back off for a fraction of a block//
+			const uint32_t fill = ring_.size();
+			if (fill < targetHeadroom_.load(std::memory_order_relaxed) && ring_.capacity() - fill >= blockSize_)
+				renderBlock();
+			else
+				std::this_thread::sleep_for(std::chrono::microseconds(250));
+		}
+	}
+public:
+	SimulationThread(EngineHandoff<ResolutionLadder>& aEngine, uint32_t aBlockSize, uint32_t aCapacity) :
+		engine_(aEngine),
+		ring_(aCapacity),
+		blockSize_(aBlockSize),
+		output_(aBlockSize, 0.0),
+		running_(false),
+		targetHeadroom_(aBlockSize * 2),
+		underruns_(0),
+		underrunSamples_(0),
+		blocksRendered_(0)
+	{
+	}
+	~SimulationThread()
+	{
+		stop();
+	}
+
+	//Setup - Call before start()//
+	void setExcitationRenderer(std::function<uint32_t(ExcitationBlock&, uint32_t)> aRenderExcitation)
+	{
+		renderExcitation_ = aRenderExcitation;
+	}
+	void setSnapshotInterval(uint32_t aSamples)
+	{
+		snapshotInterval_ = aSamples;
+	}
+	void setThreadPolicy(const ThreadPolicy& aPolicy)
+	{
+		policy_ = aPolicy;
+	}
+	//Onsets rendered here are delivered once they are in the ring, behind whatever it already holds//
+	void setLatencyMonitor(LatencyMonitor* aMonitor)
+	{
+		latencyMonitor_ = aMonitor;
+	}
+
+	void start()
+	{
+		running_.store(true, std::memory_order_release);
+		thread_ = std::thread(&SimulationThread::run, this);
+	}
+	void stop()
+	{
+		running_.store(false, std::memory_order_release);
+		if (thread_.joinable())
+			thread_.join();
+	}
+	bool isRunning() const
+	{
+		return running_.load(std::memory_order_acquire);
+	}
+
+	//Audio thread side - Wait-free copy out of the ring, zero filling and counting any shortfall//
+	void pull(float* aOutput, uint32_t aNumSamples)
+	{
+		const uint32_t got = ring_.read(aOutput, aNumSamples);
+		if (got < aNumSamples)
+		{
+			memset(aOutput + got, 0, (aNumSamples - got) * sizeof(float));
+			underruns_.fetch_add(1, std::memory_order_relaxed);
+			underrunSamples_.fetch_add(aNumSamples - got, std::memory_order_relaxed);
+		}
+	}
+
+	//Headroom is the fill the simulation aims to keep ahead of the device, i.e. the extra latency bought//
+	void setTargetHeadroom(uint32_t aSamples)
+	{
+		if (aSamples > ring_.capacity() - blockSize_)
+			aSamples = ring_.capacity() - blockSize_;
+		targetHeadroom_.store(aSamples, std::memory_order_relaxed);
+	}
+	uint32_t getTargetHeadroom() const
+	{
+		return targetHeadroom_.load(std::memory_order_relaxed);
+	}
+	uint32_t getFillLevel() const
+	{
+		return ring_.size();
+	}
+	uint64_t getUnderruns() const
+	{
+		return underruns_.load(std::memory_order_relaxed);
+	}
+	uint64_t getUnderrunSamples() const
+	{
+		return underrunSamples_.load(std::memory_order_relaxed);
+	}
+	uint64_t getBlocksRendered() const
+	{
+		return blocksRendered_.load(std::memory_order_relaxed);
+	}
+};
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef SPSC_RING_HPP
+#define SPSC_RING_HPP
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+//Lock-free single producer/single consumer ring of samples. Capacity is rounded up to a power of two so the indices can
+//run freely and wrap with a mask. Head and tail sit on separate cache lines to avoid false sharing between the threads.
+template<typename T>
+class SpscRing
+{
+private:
+	std::vector<T> buffer_;
+	uint32_t mask_;
+	alignas(64) std::atomic<uint32_t> head_;	//Written by the producer.
+	alignas(64) std::atomic<uint32_t> tail_;	//Written by the consumer.
+
+	static uint32_t roundUpPowerOfTwo(uint32_t aValue)
+	{
+		uint32_t power = 1;
+		while (power < aValue)
+			power <<= 1;
+		return power;
+	}
+public:
+	explicit SpscRing(uint32_t aCapacity) :
+		buffer_(roundUpPowerOfTwo(aCapacity)),
+		mask_(roundUpPowerOfTwo(aCapacity) - 1),
+		head_(0),
+		tail_(0)
+	{
+	}
+
+	uint32_t capacity() const
+	{
+		return mask_ + 1;
+	}
+	uint32_t size() const
+	{
+		return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+	}
+
+	//Producer side - Returns the number of elements actually written//
+	uint32_t write(const T* aData, uint32_t aCount)
+	{
+		const uint32_t head = head_.load(std::memory_order_relaxed);
+		const uint32_t tail = tail_.load(std::memory_order_acquire);
+		const uint32_t space = capacity() - (head - tail);
+		if (aCount > space)
+			aCount = space;
+
+		const uint32_t start = head & mask_;
+		const uint32_t first = aCount < capacity() - start ? aCount : capacity() - start;
+		memcpy(&buffer_[start], aData, first * sizeof(T));
+		memcpy(&buffer_[0], aData + first, (aCount - first) * sizeof(T));
+
+		head_.store(head + aCount, std::memory_order_release);
+		return aCount;
+	}
+
+	//Consumer side - Returns the number of elements actually read//
+	uint32_t read(T* aData, uint32_t aCount)
+	{
+		const uint32_t tail = tail_.load(std::memory_order_relaxed);
+		const uint32_t head = head_.load(std::memory_order_acquire);
+		const uint32_t available = head - tail;
+		if (aCount > available)
+			aCount = available;
+
+		const uint32_t start = tail & mask_;
+		const uint32_t first = aCount < capacity() - start ? aCount : capacity() - start;
+		memcpy(aData, &buffer_[start], first * sizeof(T));
+		memcpy(aData + first, &buffer_[0], (aCount - first) * sizeof(T));
+
+		tail_.store(tail + aCount, std::memory_order_release);
+		return aCount;
+	}
+};
+
+#endif
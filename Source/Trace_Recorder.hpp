@@ -0,0 +1,258 @@
+#ifndef TRACE_RECORDER_HPP
+#define TRACE_RECORDER_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+
+//One recorded event. Names must be string literals or otherwise outlive the recording - Only the pointer is stored//
+struct TraceEvent
+{
+	int64_t time_;			//Nanoseconds, steady clock.
+	int64_t duration_;		//Complete ('X') events only.
+	const char* name_;
+	double value_;			//Counter ('C') events only.
+	char phase_;			//'B'egin, 'E'nd, 'X' complete, 'C'ounter - As the Chrome trace format.
+};
+
+//Ring of events written by exactly one thread. Once full the oldest events are overwritten, so a long recording keeps its
+//most recent stretch. The ring is sized when the buffer is created - Recording never allocates.
+class TraceBuffer
+{
+private:
+	std::vector<TraceEvent> events_;
+	std::atomic<uint64_t> written_;
+	std::string name_;
+public:
+	TraceBuffer(const std::string& aName, uint32_t aCapacity) :
+		events_(aCapacity),
+		written_(0),
+		name_(aName)
+	{
+	}
+
+	void push(const TraceEvent& aEvent)
+	{
+		const uint64_t index = written_.load(std::memory_order_relaxed);
+		events_[index % events_.size()] = aEvent;
+		written_.store(index + 1, std::memory_order_release);
+	}
+	void clear()
+	{
+		written_.store(0, std::memory_order_release);
+	}
+
+	uint64_t getWritten() const
+	{
+		return written_.load(std::memory_order_acquire);
+	}
+	uint32_t getCapacity() const
+	{
+		return (uint32_t)events_.size();
+	}
+	const TraceEvent& getEvent(uint64_t aIndex) const
+	{
+		return events_[aIndex % events_.size()];
+	}
+	const std::string& getName() const
+	{
+		return name_;
+	}
+};
+
+//Process wide set of trace buffers, one per traced thread plus any device tracks. Buffers are created off the real-time
+//path and a thread binds to its own, after which tracing is a relaxed flag check and a store into that ring. Only creation
+//is locked, as threads register themselves as they start - The recording is written out after stopping, so dump a moment
+//after setEnabled(false) to let in-flight events land.
+class TraceRecorder
+{
+public:
+	static const uint32_t MAX_BUFFERS = 16;
+	static const uint32_t DEFAULT_CAPACITY = 1 << 16;
+private:
+	TraceBuffer* buffers_[MAX_BUFFERS];
+	std::atomic<uint32_t> numBuffers_;	//Published after the slot is filled - Readers never see an empty one.
+	std::mutex createMutex_;
+	std::atomic<bool> enabled_;
+
+	TraceRecorder() :
+		numBuffers_(0),
+		enabled_(false)
+	{
+	}
+	~TraceRecorder()
+	{
+		for (uint32_t i = 0; i != numBuffers_.load(); ++i)
+			delete buffers_[i];
+	}
+
+	static TraceBuffer*& threadBuffer()
+	{
+		static thread_local TraceBuffer* buffer = nullptr;
+		return buffer;
+	}
+
+	static void writeString(std::ostream& aStream, const std::string& aString)
+	{
+		aStream << '"';
+		for (char c : aString)
+		{
+			if (c == '"' || c == '\\')
+				aStream << '\\';
+			aStream << c;
+		}
+		aStream << '"';
+	}
+public:
+	static TraceRecorder& get()
+	{
+		static TraceRecorder recorder;
+		return recorder;
+	}
+
+	static int64_t now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	//Allocates and locks - Call from setup code or at the top of a thread, never from the real-time path//
+	TraceBuffer* createBuffer(const std::string& aName, uint32_t aCapacity = DEFAULT_CAPACITY)
+	{
+		std::lock_guard<std::mutex> lock(createMutex_);
+		const uint32_t index = numBuffers_.load(std::memory_order_relaxed);
+		if (index == MAX_BUFFERS)
+		{
+			std::cout << "ERROR too many trace buffers, not tracing " << aName << std::endl;
+			return nullptr;
+		}
+		buffers_[index] = new TraceBuffer(aName, aCapacity);
+		numBuffers_.store(index + 1, std::memory_order_release);
+		return buffers_[index];
+	}
+	//Binds the calling thread's trace calls to aBuffer - Cheap enough to repeat at the top of every callback//
+	static void bindThread(TraceBuffer* aBuffer)
+	{
+		threadBuffer() = aBuffer;
+	}
+	//Creates and binds in one - For threads that own their loop//
+	void registerThread(const std::string& aName, uint32_t aCapacity = DEFAULT_CAPACITY)
+	{
+		bindThread(createBuffer(aName, aCapacity));
+	}
+
+	void setEnabled(bool aEnabled)
+	{
+		if (aEnabled)
+		{
+			for (uint32_t i = 0; i != numBuffers_.load(std::memory_order_acquire); ++i)
+				buffers_[i]->clear();
+		}
+		enabled_.store(aEnabled, std::memory_order_release);
+	}
+	bool isEnabled() const
+	{
+		return enabled_.load(std::memory_order_relaxed);
+	}
+
+	//Records on the calling thread's buffer, or on aBuffer for tracks not tied to a thread//
+	static void record(char aPhase, const char* aName, int64_t aTime, int64_t aDuration = 0, double aValue = 0.0, TraceBuffer* aBuffer = nullptr)
+	{
+		if (!get().isEnabled())
+			return;
+		TraceBuffer* buffer = aBuffer != nullptr ? aBuffer : threadBuffer();
+		if (buffer == nullptr)
+			return;
+		TraceEvent event = { aTime, aDuration, aName, aValue, aPhase };
+		buffer->push(event);
+	}
+
+	//Chrome trace JSON, loadable in chrome://tracing and Perfetto. Each buffer is its own track//
+	bool writeChromeTrace(const std::string& aPath) const
+	{
+		std::ofstream file(aPath);
+		if (!file.is_open())
+		{
+			std::cout << "ERROR writing trace to " << aPath << std::endl;
+			return false;
+		}
+
+		//Timestamps relative to the earliest event kept, in microseconds as the format expects//
+		const uint32_t numBuffers = numBuffers_.load(std::memory_order_acquire);
+		int64_t origin = INT64_MAX;
+		for (uint32_t b = 0; b != numBuffers; ++b)
+		{
+			const uint64_t written = buffers_[b]->getWritten();
+			if (written != 0)
+			{
+				const uint64_t first = written > buffers_[b]->getCapacity() ? written - buffers_[b]->getCapacity() : 0;
+				const int64_t time = buffers_[b]->getEvent(first).time_;
+				origin = time < origin ? time : origin;
+			}
+		}
+
+		file << "{\"traceEvents\":[" << std::endl;
+		bool first = true;
+		for (uint32_t b = 0; b != numBuffers; ++b)
+		{
+			const TraceBuffer& buffer = *buffers_[b];
+			file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b << ",\"args\":{\"name\":";
+			writeString(file, buffer.getName());
+			file << "}}";
+			first = false;
+
+			const uint64_t written = buffer.getWritten();
+			const uint64_t start = written > buffer.getCapacity() ? written - buffer.getCapacity() : 0;
+			for (uint64_t i = start; i != written; ++i)
+			{
+				const TraceEvent& event = buffer.getEvent(i);
+				file << ",\n{\"name\":";
+				writeString(file, event.name_);
+				file << ",\"ph\":\"" << event.phase_ << "\",\"pid\":1,\"tid\":" << b << ",\"ts\":" << (event.time_ - origin) / 1000.0;
+				if (event.phase_ == 'X')
+					file << ",\"dur\":" << event.duration_ / 1000.0;
+				if (event.phase_ == 'C')
+					file << ",\"args\":{\"value\":" << event.value_ << "}";
+				file << "}";
+			}
+		}
+		file << "\n]}" << std::endl;
+		return true;
+	}
+};
+
+//Begin/end pair around a scope on the calling thread's buffer//
+class ScopedTrace
+{
+private:
+	const char* name_;
+	bool recording_;
+public:
+	explicit ScopedTrace(const char* aName) :
+		name_(aName),
+		recording_(TraceRecorder::get().isEnabled())
+	{
+		if (recording_)
+			TraceRecorder::record('B', name_, TraceRecorder::now());
+	}
+	~ScopedTrace()
+	{
+		if (recording_)
+			TraceRecorder::record('E', name_, TraceRecorder::now());
+	}
+};
+
+#define TRACE_CONCATENATE_INNER(a, b) a##b
+#define TRACE_CONCATENATE(a, b) TRACE_CONCATENATE_INNER(a, b)
+#define TRACE_SCOPE(aName) ScopedTrace TRACE_CONCATENATE(traceScope, __LINE__)(aName)
+
+inline void traceCounter(const char* aName, double aValue)
+{
+	TraceRecorder::record('C', aName, TraceRecorder::now(), 0, aValue);
+}
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef TRIPLE_BUFFER_HPP
+#define TRIPLE_BUFFER_HPP
+
+#include <atomic>
+
+//Single producer, single consumer triple buffer. The writer always owns one slot, the reader one, and the third sits in
+//the middle holding the most recent publication. publish() and update() are a single atomic exchange each, neither side
+//ever waits on the other, and a slow reader only skips frames.
+template<typename T>
+class TripleBuffer
+{
+private:
+	static const int indexMask_ = 3;
+	static const int freshBit_ = 4;
+
+	T slots_[3];
+	std::atomic<int> middle_;
+	int back_;
+	int front_;
+public:
+	TripleBuffer() : middle_(2), back_(0), front_(1) {}
+
+	//Writer side//
+	T& writeSlot()
+	{
+		return slots_[back_];
+	}
+	void publish()
+	{
+		back_ = middle_.exchange(back_ | freshBit_, std::memory_order_acq_rel) & indexMask_;
+	}
+
+	//Reader side - Returns true if a newer slot was swapped in//
+	bool update()
+	{
+		if ((middle_.load(std::memory_order_relaxed) & freshBit_) == 0)
+			return false;
+		front_ = middle_.exchange(front_, std::memory_order_acq_rel) & indexMask_;
+		return true;
+	}
+	T& readSlot()
+	{
+		return slots_[front_];
+	}
+
+	//Setup only - Not safe while either side is running//
+	T& slot(int aIndex)
+	{
+		return slots_[aIndex];
+	}
+};
+
+#endif
@@ -1,139 +1,197 @@
-#ifndef WAVETABLE_EXCITER_HPP
-#define WAVETABLE_EXCITER_HPP
-
-#include <cmath>
-
-#define PI 3.14159265359
-
-#define SAMPLE_RATE 44100
-#define SAMPLES_PER_MILLISECOND SAMPLE_RATE / 1000.0
-
-//There might be a optimization worth implementing involving how the table wraps back to the beginning worth checking out - https://docs.juce.com/master/tutorial_wavetable_synth.html//
-class WavetableSynth
-{
-private:
-	int wavetableSize = 0;
-	float* wavetable;
-	float currentIndex = 0.0f, tableDelta = 0.0f;
-
-	double midiToFreq(int midiNote)
-	{
-		return 440 * (pow(2, (midiNote - 69) / 12.0));
-	}
-public:
-	WavetableSynth() {}
-	WavetableSynth(const float* aWavetableBuffer, const int aWavetableSize)
-	{
-		wavetableSize = aWavetableSize;
-		wavetable = new float[wavetableSize];
-		for (int i = 0; i != wavetableSize; ++i)
-			wavetable[i] = aWavetableBuffer[i];
-	}
-	~WavetableSynth()
-	{
-		delete wavetable;	//This breaks it.
-	}
-	void setMidiNote(int midiNote, float sampleRate)
-	{
-		double frequency = midiToFreq(midiNote);
-		tableDelta = frequency * (wavetableSize / sampleRate);
-	}
-	void setFrequency(float frequency, float sampleRate)
-	{
-		tableDelta = frequency * (wavetableSize / sampleRate);
-	}
-	float getNextSample() noexcept
-	{
-		auto index0 = (unsigned int)currentIndex;
-		auto index1 = index0 == (wavetableSize - 1) ? (unsigned int)0 : index0 + 1;
-		auto frac = currentIndex - (float)index0;
-		float* table = wavetable;
-		auto value0 = table[index0];
-		auto value1 = table[index1];
-		auto currentSample = value0 + frac * (value1 - value0);
-		if ((currentIndex += tableDelta) > wavetableSize)
-			currentIndex -= wavetableSize;
-		return currentSample;
-	}
-	void setCurrentIndex(const float aCurrentIndex)
-	{
-		currentIndex = aCurrentIndex;
-	}
-};
-
-class WavetableExciter
-{
-private:
-	WavetableSynth wavetableSynth;
-
-	unsigned int excitationNumSamples;
-public:
-	int index = 0;
-	WavetableExciter(const int duration, const float* wavetableBuffer, const size_t wavetableSize) : wavetableSynth(wavetableBuffer, wavetableSize)
-	{
-		excitationNumSamples = duration * SAMPLES_PER_MILLISECOND;
-		wavetableSynth.setFrequency(1440, 44100);
-	}
-	~WavetableExciter() {}
-	float getNextSample()
-	{
-		++index;
-		return wavetableSynth.getNextSample();
-	}
-	void setDuration(int aDuration)
-	{
-		excitationNumSamples = aDuration * SAMPLES_PER_MILLISECOND;
-	}
-	void resetExcitation()
-	{
-		index = 0;
-		wavetableSynth.setCurrentIndex(0.0);
-	}
-	bool isExcitation()
-	{
-		if (index > excitationNumSamples)
-			return false;
-		return true;
-	}
-};
-
-class SineOscillator
-{
-private:
-	float currentAngle = 0.0f;	//Current angle/phase of wave.
-	float angleDelta = 0.0f;	//Amount to increment between each cycle - Depending on frequency and sample rate.
-public:
-	SineOscillator(int sampleRate)
-	{
-		float midiNote = 70.0;
-		float frequency = 440.0 * pow(2.0, (midiNote - 69.0) / 12.0);
-		setFrequency(frequency, sampleRate);
-	}
-	void setFrequency(float frequency, float sampleRate)
-	{
-		auto cyclesPerSample = frequency / sampleRate;
-		angleDelta = cyclesPerSample * 2 * PI;
-	}
-	void updateAngle() noexcept
-	{
-		currentAngle += angleDelta;
-		if (currentAngle >= 2 * PI)
-			currentAngle -= 2 * PI;
-	}
-	float getNextSample() noexcept
-	{
-		auto currentSample = std::sin(currentAngle);
-		updateAngle();
-		return currentSample;
-	}
-	void getAudioBlock(int bufferSize, float* buffer)
-	{
-		for (int i = 0; i != bufferSize; ++i)
-		{
-			*buffer = getNextSample();
-			++buffer;
-		}
-	}
-};
-
+#ifndef WAVETABLE_EXCITER_HPP
+#define WAVETABLE_EXCITER_HPP
+
+#include <cmath>
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WAVETABLE_USE_SSE
+#endif
+
+#define PI 3.14159265359
+
+#define SAMPLE_RATE 44100
+#define SAMPLES_PER_MILLISECOND SAMPLE_RATE / 1000.0
+
+//There might be a optimization worth implementing involving how the table wraps back to the beginning worth checking out - https://docs.juce.com/master/tutorial_wavetable_synth.html//
+class WavetableSynth
+{
+private:
+	int wavetableSize = 0;
+	float* wavetable = nullptr;
+	float currentIndex = 0.0f, tableDelta = 0.0f;
+
+	double midiToFreq(int midiNote)
+	{
+		return 440 * (pow(2, (midiNote - 69) / 12.0));
+	}
+public:
+	WavetableSynth() {}
+	WavetableSynth(const float* aWavetableBuffer, const int aWavetableSize)
+	{
+		setWavetable(aWavetableBuffer, aWavetableSize);
+	}
+	~WavetableSynth()
+	{
+		delete[] wavetable;	//Owns its table - Not copyable.
+	}
+	WavetableSynth(const WavetableSynth&) = delete;
+	WavetableSynth& operator=(const WavetableSynth&) = delete;
+
+	void setWavetable(const float* aWavetableBuffer, const int aWavetableSize)
+	{
+		delete[] wavetable;
+		wavetableSize = aWavetableSize;
+		wavetable = new float[wavetableSize + 1];
+		for (int i = 0; i != wavetableSize; ++i)
+			wavetable[i] = aWavetableBuffer[i];
+		wavetable[wavetableSize] = wavetable[0];	//Guard sample - Interpolation never needs to wrap index1.
+	}
+	void setMidiNote(int midiNote, float sampleRate)
+	{
+		double frequency = midiToFreq(midiNote);
+		tableDelta = frequency * (wavetableSize / sampleRate);
+	}
+	void setFrequency(float frequency, float sampleRate)
+	{
+		tableDelta = frequency * (wavetableSize / sampleRate);
+	}
+	float getNextSample() noexcept
+	{
+		auto index0 = (unsigned int)currentIndex;
+		auto index1 = index0 == (wavetableSize - 1) ? (unsigned int)0 : index0 + 1;
+		auto frac = currentIndex - (float)index0;
+		float* table = wavetable;
+		auto value0 = table[index0];
+		auto value1 = table[index1];
+		auto currentSample = value0 + frac * (value1 - value0);
+		if ((currentIndex += tableDelta) > wavetableSize)
+			currentIndex -= wavetableSize;
+		return currentSample;
+	}
+	//Block version of getNextSample. Positions and interpolation are done four samples at a time, only the table reads
+	//are scalar. The guard sample means index1 is always index0 + 1.
+	void renderBlock(float* aBuffer, uint32_t aNumSamples) noexcept
+	{
+		const float size = (float)wavetableSize;
+		const float inverseSize = 1.0f / size;
+		uint32_t i = 0;
+#ifdef WAVETABLE_USE_SSE
+		const __m128 sizes = _mm_set1_ps(size);
+		const __m128 inverseSizes = _mm_set1_ps(inverseSize);
+		const __m128 offsets = _mm_mul_ps(_mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f), _mm_set1_ps(tableDelta));
+		alignas(16) int32_t indices[4];
+		alignas(16) float values0[4];
+		alignas(16) float values1[4];
+		for (; i + 4 <= aNumSamples; i += 4)
+		{
+			__m128 positions = _mm_add_ps(_mm_set1_ps(currentIndex), offsets);
+			positions = _mm_sub_ps(positions, _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_mul_ps(positions, inverseSizes))), sizes));
+			const __m128i index0 = _mm_cvttps_epi32(positions);
+			const __m128 fractions = _mm_sub_ps(positions, _mm_cvtepi32_ps(index0));
+			_mm_store_si128((__m128i*)indices, index0);
+			for (int k = 0; k != 4; ++k)
+			{
+				const int32_t index = indices[k] < wavetableSize ? indices[k] : wavetableSize - 1;
+				values0[k] = wavetable[index];
+				values1[k] = wavetable[index + 1];
+			}
+			const __m128 value0 = _mm_load_ps(values0);
+			_mm_storeu_ps(aBuffer + i, _mm_add_ps(value0, _mm_mul_ps(fractions, _mm_sub_ps(_mm_load_ps(values1), value0))));
+
+			currentIndex += 4.0f * tableDelta;
+			currentIndex -= size * (float)(int)(currentIndex * inverseSize);
+		}
+#endif
+		for (; i != aNumSamples; ++i)
+		{
+			const int32_t index0 = (int32_t)currentIndex < wavetableSize ? (int32_t)currentIndex : wavetableSize - 1;
+			const float fraction = currentIndex - (float)index0;
+			aBuffer[i] = wavetable[index0] + fraction * (wavetable[index0 + 1] - wavetable[index0]);
+			currentIndex += tableDelta;
+			currentIndex -= size * (float)(int)(currentIndex * inverseSize);
+		}
+	}
+	void setCurrentIndex(const float aCurrentIndex)
+	{
+		currentIndex = aCurrentIndex;
+	}
+};
+
+class WavetableExciter
+{
+private:
+	WavetableSynth wavetableSynth;
+
+	unsigned int excitationNumSamples;
+public:
+	int index = 0;
+	WavetableExciter(const int duration, const float* wavetableBuffer, const size_t wavetableSize) : wavetableSynth(wavetableBuffer, wavetableSize)
+	{
+		excitationNumSamples = duration * SAMPLES_PER_MILLISECOND;
+		wavetableSynth.setFrequency(1440, 44100);
+	}
+	~WavetableExciter() {}
+	float getNextSample()
+	{
+		++index;
+		return wavetableSynth.getNextSample();
+	}
+	void setDuration(int aDuration)
+	{
+		excitationNumSamples = aDuration * SAMPLES_PER_MILLISECOND;
+	}
+	void resetExcitation()
+	{
+		index = 0;
+		wavetableSynth.setCurrentIndex(0.0);
+	}
+	bool isExcitation()
+	{
+		if (index > excitationNumSamples)
+			return false;
+		return true;
+	}
+};
+
+class SineOscillator
+{
+private:
+	float currentAngle = 0.0f;	//Current angle/phase of wave.
+	float angleDelta = 0.0f;	//Amount to increment between each cycle - Depending on frequency and sample rate.
+public:
+	SineOscillator(int sampleRate)
+	{
+		float midiNote = 70.0;
+		float frequency = 440.0 * pow(2.0, (midiNote - 69.0) / 12.0);
+		setFrequency(frequency, sampleRate);
+	}
+	void setFrequency(float frequency, float sampleRate)
+	{
+		auto cyclesPerSample = frequency / sampleRate;
+		angleDelta = cyclesPerSample * 2 * PI;
+	}
+	void updateAngle() noexcept
+	{
+		currentAngle += angleDelta;
+		if (currentAngle >= 2 * PI)
+			currentAngle -= 2 * PI;
+	}
+	float getNextSample() noexcept
+	{
+		auto currentSample = std::sin(currentAngle);
+		updateAngle();
+		return currentSample;
+	}
+	void getAudioBlock(int bufferSize, float* buffer)
+	{
+		for (int i = 0; i != bufferSize; ++i)
+		{
+			*buffer = getNextSample();
+			++buffer;
+		}
+	}
+};
+
 #endif
\ No newline at end of file
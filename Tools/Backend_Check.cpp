@@ -0,0 +1,177 @@
+//Runs the same blocks through every compute backend available and compares each against the CPU reference - Pickup
+//output sample by sample, then the final field. Block lengths vary and some blocks carry strikes, so rotation, the
+//excitation offsets and the Vulkan indirect dispatch counts are all exercised.
+//Build from the repository root, with the SPIR-V header generated as in README.md:
+//	g++ -std=c++17 -O2 -DFDTD_USE_VULKAN -I Source Tools/Backend_Check.cpp Source/Realtime_Check.cpp -o backend_check -lOpenCL -lvulkan -lpthread
+//Leave out -DFDTD_USE_VULKAN and -lvulkan to check OpenCL alone.
+//Usage:
+//	backend_check [<model.json|model.tmod>] [--blocks n]
+//Without a model the twin membrane geometry is generated at 256x192. Set VK_ICD_FILENAMES and FDTD_VULKAN_DEVICE to
+//check a particular Vulkan driver (e.g. lavapipe). Exits 1 if any backend disagrees with the CPU, 2 if none could run.
+
+#include <stdlib.h>
+#include <math.h>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "FDTD_Backend_CPU.hpp"
+#include "FDTD_Backend_OpenCL.hpp"
+#ifdef FDTD_USE_VULKAN
+#include "FDTD_Backend_Vulkan.hpp"
+#endif
+#include "Model_Loader.hpp"
+#include "Model_Geometry.hpp"
+
+static const uint32_t MAX_STEPS = 256;
+static const uint32_t NUM_POINTS = 2;
+//Relative to the largest reference value - OpenCL builds with -cl-fast-relaxed-math, so bit equality is not expected//
+static const double TOLERANCE = 1e-3;
+
+static int usage()
+{
+	std::cout << "Usage: backend_check [<model.json|model" << MODEL_FILE_EXTENSION << ">] [--blocks n]" << std::endl;
+	return 2;
+}
+
+struct BackendRun
+{
+	FDTD_Backend* backend_ = nullptr;
+	FDTD_Backend::ProcessBlockFn processBlock_ = nullptr;
+	std::unique_ptr<BlockResources> resources_;
+	std::vector<float> output_;
+	std::vector<float> field_;
+};
+
+template<class Backend>
+static bool startRun(Backend* aBackend, const ModelData& aModel, BackendRun& aRun)
+{
+	aRun.backend_ = aBackend;
+	aRun.processBlock_ = &FDTD_Backend::processBlockThunk<Backend>;
+	if (!aBackend->init())
+	{
+		std::cout << aBackend->getName() << " not available, skipped." << std::endl;
+		return false;
+	}
+	aBackend->uploadModel(aModel);
+	aBackend->setCoefficient(9, 0.0005f);
+	aBackend->setCoefficient(10, 0.35f);
+	aBackend->setCoefficient(11, 0.25f);
+	aBackend->setCoefficient(12, 0.001f);
+	aRun.resources_.reset(aBackend->createBlockResources(MAX_STEPS, NUM_POINTS));
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	std::string path;
+	uint32_t blocks = 400;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string argument = argv[i];
+		if (argument == "--blocks" && i + 1 < argc)
+			blocks = (uint32_t)std::max(1, atoi(argv[++i]));
+		else if (path.empty() && argument[0] != '-')
+			path = argument;
+		else
+			return usage();
+	}
+
+	ModelData model;
+	if (path.empty() ? !ModelGeometry::twinMembrane().generate(256, 192, 1.0f, model) : !loadModel(path, 1.0f, model))
+		return 2;
+	const int width = model.width_;
+	const int height = model.height_;
+	const int pickups[2] = { (height / 4) * width + width / 3, (3 * height / 4) * width + 2 * width / 3 };
+	for (int pickup : pickups)
+		model.outputGrid_[pickup] = 1;
+	int positions[NUM_POINTS] = { (height / 4) * width + width / 2, (3 * height / 4) * width + width / 4 };
+
+	FDTD_Backend_CPU cpu;
+	BackendRun reference;
+	startRun(&cpu, model, reference);
+
+	std::vector<std::unique_ptr<FDTD_Backend>> owned;
+	std::vector<BackendRun> runs;
+	BackendRun run;
+	FDTD_Backend_OpenCL* openCL = new FDTD_Backend_OpenCL();
+	owned.emplace_back(openCL);
+	if (startRun(openCL, model, run))
+		runs.push_back(std::move(run));
+#ifdef FDTD_USE_VULKAN
+	FDTD_Backend_Vulkan* vulkan = new FDTD_Backend_Vulkan();
+	owned.emplace_back(vulkan);
+	if (startRun(vulkan, model, run))
+		runs.push_back(std::move(run));
+#endif
+	if (runs.empty())
+	{
+		std::cout << "ERROR no backend to compare against the CPU." << std::endl;
+		return 2;
+	}
+
+	//Same block sequence for every backend - Full blocks, random lengths and a strike every few blocks//
+	std::vector<float> rows(NUM_POINTS * MAX_STEPS);
+	std::vector<double> outputDiff(runs.size(), 0.0);
+	double outputPeak = 0.0;
+	uint64_t steps = 0;
+	std::mt19937 random(1);
+	for (BackendRun& compared : runs)
+		compared.output_.resize(MAX_STEPS);
+	reference.output_.resize(MAX_STEPS);
+	for (uint32_t block = 0; block != blocks; ++block)
+	{
+		const uint32_t numSteps = block % 5 == 0 ? MAX_STEPS : 1 + random() % MAX_STEPS;
+		const uint32_t length = block % 7 == 0 ? std::min<uint32_t>(numSteps, 24) : 0;
+		for (size_t r = 0; r <= runs.size(); ++r)
+		{
+			BackendRun& current = r == runs.size() ? reference : runs[r];
+			std::fill(rows.begin(), rows.end(), 0.0f);
+			for (uint32_t i = 0; i != length; ++i)
+			{
+				rows[i] = sinf(0.5f * i);
+				rows[MAX_STEPS + i] = 0.5f * cosf(0.3f * i);
+			}
+			ExcitationBlock excitation;
+			excitation.samples_ = rows.data();
+			excitation.positions_ = positions;
+			excitation.points_ = NUM_POINTS;
+			excitation.stride_ = MAX_STEPS;
+			excitation.length_ = length;
+			current.processBlock_(current.backend_, *current.resources_, excitation, current.output_.data(), numSteps);
+		}
+		for (uint32_t i = 0; i != numSteps; ++i)
+		{
+			outputPeak = std::max(outputPeak, (double)fabsf(reference.output_[i]));
+			for (size_t r = 0; r != runs.size(); ++r)
+				outputDiff[r] = std::max(outputDiff[r], (double)fabsf(runs[r].output_[i] - reference.output_[i]));
+		}
+		steps += numSteps;
+	}
+
+	reference.field_.resize(model.elements());
+	cpu.readFieldSnapshot(reference.field_.data());
+	double fieldPeak = 0.0;
+	for (float value : reference.field_)
+		fieldPeak = std::max(fieldPeak, (double)fabsf(value));
+
+	bool matched = true;
+	for (size_t r = 0; r != runs.size(); ++r)
+	{
+		BackendRun& compared = runs[r];
+		compared.field_.resize(model.elements());
+		compared.backend_->readFieldSnapshot(compared.field_.data());
+		double fieldDiff = 0.0;
+		for (int i = 0; i != model.elements(); ++i)
+			fieldDiff = std::max(fieldDiff, (double)fabsf(compared.field_[i] - reference.field_[i]));
+		const bool match = outputDiff[r] <= TOLERANCE * std::max(outputPeak, 1e-6) && fieldDiff <= TOLERANCE * std::max(fieldPeak, 1e-6);
+		std::cout << compared.backend_->getName() << " vs CPU over " << steps << " steps: output max diff " << outputDiff[r] << " (peak " << outputPeak
+			<< "), field max diff " << fieldDiff << " (peak " << fieldPeak << ") - " << (match ? "match" : "MISMATCH") << std::endl;
+		matched = matched && match;
+	}
+	runs.clear();
+	reference.resources_.reset();
+	return matched ? 0 : 1;
+}
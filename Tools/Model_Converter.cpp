@@ -0,0 +1,92 @@
+//Converts the JSON instrument models into the binary model format (Model_Binary.hpp) loaded by mapping the file.
+//Build from the repository root:
+//	g++ -std=c++17 -O2 -I Source Tools/Model_Converter.cpp -o model_converter
+//Usage:
+//	model_converter <model.json> [<model.tmod>] [--exciter x y] [--pickup x y]...
+//Positions are normalised 0-1. Without --pickup the model keeps the two default pickups MainComponent always used.
+
+#include <stdlib.h>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "Model_Loader.hpp"
+
+static int usage()
+{
+	std::cout << "Usage: model_converter <model.json> [<model" << MODEL_FILE_EXTENSION << ">] [--exciter x y] [--pickup x y]..." << std::endl;
+	return 1;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+		return usage();
+
+	const std::string input = argv[1];
+	std::string output;
+	float exciter[2] = { -1.0f, -1.0f };
+	std::vector<float> pickups;
+	for (int i = 2; i < argc; ++i)
+	{
+		const std::string argument = argv[i];
+		if ((argument == "--exciter" || argument == "--pickup") && i + 2 < argc)
+		{
+			const float x = (float)atof(argv[i + 1]);
+			const float y = (float)atof(argv[i + 2]);
+			i += 2;
+			if (argument == "--exciter")
+			{
+				exciter[0] = x;
+				exciter[1] = y;
+			}
+			else
+			{
+				pickups.push_back(x);
+				pickups.push_back(y);
+			}
+		}
+		else if (output.empty() && argument[0] != '-')
+		{
+			output = argument;
+		}
+		else
+		{
+			return usage();
+		}
+	}
+	if (output.empty())
+		output = input.substr(0, input.find_last_of('.')) + MODEL_FILE_EXTENSION;
+
+	//Boundary value 1 - The file stores where the boundary is, the loader applies whichever value the engine asks for//
+	ModelData model;
+	if (!loadModelJSON(input, 1.0f, model))
+		return 1;
+	if (exciter[0] >= 0.0f)
+	{
+		model.exciter_[0] = exciter[0];
+		model.exciter_[1] = exciter[1];
+	}
+	if (!pickups.empty())
+		model.pickups_ = pickups;
+	if (!saveModelBinary(output, model))
+		return 1;
+
+	//Read back and compare, timing the load the engine will do//
+	ModelData check;
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	if (!loadModelBinary(output, 1.0f, check))
+		return 1;
+	const double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	if (check.idGrid_ != model.idGrid_ || check.boundaryGrid_ != model.boundaryGrid_ || check.kernelSource_ != model.kernelSource_ ||
+		check.controllers_.size() != model.controllers_.size() || check.pickups_ != model.pickups_)
+	{
+		std::cout << "ERROR " << output << " does not read back as " << input << std::endl;
+		return 1;
+	}
+
+	std::ifstream written(output, std::ios::binary | std::ios::ate);
+	std::cout << "Wrote " << output << " (" << model.width_ << "x" << model.height_ << ", " << written.tellg() << " bytes) - Loads in "
+		<< loadMs << " ms" << std::endl;
+	return 0;
+}